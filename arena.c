@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+// Round a request up to the allocator's alignment
+static size_t roundUp(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+// Create an arena that reserves memory in blocks of 'blockSize' bytes
+Arena* arenaCreate(size_t blockSize) {
+    Arena *arena = (Arena*)calloc(1, sizeof(Arena));
+    if (!arena) return NULL;
+    arena->blockSize = blockSize ? blockSize : ARENA_DEFAULT_BLOCK;
+    return arena;
+}
+
+// Allocate 'size' bytes, reusing a released chunk of the same class if any
+void* arenaAlloc(Arena *arena, size_t size) {
+    size = roundUp(size ? size : 1);
+    size_t cls = size / ARENA_ALIGN - 1;
+    if (size <= ARENA_SLAB_MAX && arena->freeList[cls]) {
+        void *chunk = arena->freeList[cls];
+        arena->freeList[cls] = *(void**)chunk;
+        arena->bytesUsed += size;
+        return chunk;
+    }
+
+    ArenaBlock *block = arena->blocks;
+    if (!block || block->size - block->used < size) {
+        size_t blockBytes = size > arena->blockSize ? size : arena->blockSize;
+        block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + blockBytes);
+        if (!block) return NULL;
+        block->size = blockBytes;
+        block->used = 0;
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->bytesReserved += sizeof(ArenaBlock) + blockBytes;
+    }
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->bytesUsed += size;
+    return ptr;
+}
+
+// Return a chunk to its size-class free list for later reuse
+void arenaRelease(Arena *arena, void *ptr, size_t size) {
+    if (!ptr) return;
+    size = roundUp(size ? size : 1);
+    arena->bytesUsed -= size;
+    if (size > ARENA_SLAB_MAX) return;
+    size_t cls = size / ARENA_ALIGN - 1;
+    *(void**)ptr = arena->freeList[cls];
+    arena->freeList[cls] = ptr;
+}
+
+// Drop every allocation but keep the first block for reuse
+void arenaReset(Arena *arena) {
+    ArenaBlock *block = arena->blocks;
+    while (block && block->next) {
+        ArenaBlock *next = block->next;
+        arena->bytesReserved -= sizeof(ArenaBlock) + block->size;
+        free(block);
+        block = next;
+    }
+    if (block) block->used = 0;
+    arena->blocks = block;
+    memset(arena->freeList, 0, sizeof(arena->freeList));
+    arena->bytesUsed = 0;
+}
+
+// Free every block (and so every node allocated from the arena)
+void arenaDestroy(Arena *arena) {
+    if (!arena) return;
+    ArenaBlock *block = arena->blocks;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+// Report bytes reserved from the system and bytes currently handed out
+void arenaStats(const Arena *arena, size_t *bytesReserved, size_t *bytesUsed) {
+    if (bytesReserved) *bytesReserved = arena ? arena->bytesReserved : 0;
+    if (bytesUsed) *bytesUsed = arena ? arena->bytesUsed : 0;
+}
@@ -0,0 +1,40 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Arena/slab allocator shared by the trie and N-ary tree.
+// Nodes are carved out of large contiguous blocks; freed nodes go onto
+// per-size-class free lists and are reused, and arenaDestroy() releases
+// every block at once, so a whole tree is torn down in one call.
+
+#define ARENA_ALIGN 16
+#define ARENA_SLAB_MAX 4096          // larger requests are never recycled;
+                                     // covers TrieNode256 (~2 KB with CHAR_SIZE 256)
+#define ARENA_CLASSES (ARENA_SLAB_MAX / ARENA_ALIGN)
+#define ARENA_DEFAULT_BLOCK (1 << 20)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;                     // usable bytes in data[]
+    size_t used;
+    size_t pad;                      // keeps data[] 16-byte aligned
+    unsigned char data[];
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock *blocks;              // most recent block first
+    size_t blockSize;
+    void *freeList[ARENA_CLASSES];   // recycled chunks per size class
+    size_t bytesReserved;            // bytes obtained from malloc
+    size_t bytesUsed;                // bytes handed out and not released
+} Arena;
+
+Arena* arenaCreate(size_t blockSize);
+void* arenaAlloc(Arena *arena, size_t size);
+void arenaRelease(Arena *arena, void *ptr, size_t size);
+void arenaReset(Arena *arena);
+void arenaDestroy(Arena *arena);
+void arenaStats(const Arena *arena, size_t *bytesReserved, size_t *bytesUsed);
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * bench.c
+ *
+ * Clock, RSS and histogram plumbing behind bench.h.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h>
+#include "bench.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+  #include <windows.h>
+  #include <psapi.h>
+  #include <direct.h>
+#else
+  #include <errno.h>
+  #include <time.h>
+  #include <sys/resource.h>
+  #include <sys/stat.h>
+#endif
+
+uint64_t bench_now_ns(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER pc;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&pc);
+    return (uint64_t)((double)pc.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+size_t bench_peak_rss(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return (size_t)pmc.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+  #if defined(__APPLE__)
+    return (size_t)ru.ru_maxrss;            /* bytes on macOS */
+  #else
+    return (size_t)ru.ru_maxrss * 1024;     /* kilobytes on Linux/BSD */
+  #endif
+#endif
+}
+
+int bench_ensure_dir(const char *path) {
+#if defined(_WIN32) || defined(_WIN64)
+    return _mkdir(path) == 0 || GetFileAttributesA(path) != INVALID_FILE_ATTRIBUTES ? 0 : -1;
+#else
+    return mkdir(path, 0777) == 0 || errno == EEXIST ? 0 : -1;
+#endif
+}
+
+/* ---------- Histogram ---------- */
+
+static int bucket_of(uint64_t v) {
+    if (v < (1u << BENCH_SUB_BITS)) return (int)v;
+    int e = 63;
+    while (!(v >> e)) e--;                  /* e >= BENCH_SUB_BITS */
+    int sub = (int)((v >> (e - BENCH_SUB_BITS)) & ((1u << BENCH_SUB_BITS) - 1));
+    return ((e - BENCH_SUB_BITS + 1) << BENCH_SUB_BITS) + sub;
+}
+
+/* Midpoint of a bucket's value range */
+static uint64_t bucket_value(int b) {
+    if (b < (1 << BENCH_SUB_BITS)) return (uint64_t)b;
+    int e = (b >> BENCH_SUB_BITS) + BENCH_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(b & ((1 << BENCH_SUB_BITS) - 1));
+    uint64_t width = 1ull << (e - BENCH_SUB_BITS);
+    return (((1ull << BENCH_SUB_BITS) + sub) << (e - BENCH_SUB_BITS)) + width / 2;
+}
+
+void bench_hist_reset(BenchHist *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void bench_hist_add(BenchHist *h, uint64_t ns, uint64_t count) {
+    h->counts[bucket_of(ns)] += count;
+    h->samples += count;
+    h->sum_ns += ns * count;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+uint64_t bench_hist_percentile(const BenchHist *h, double q) {
+    if (!h->samples) return 0;
+    uint64_t rank = (uint64_t)(q * (double)h->samples);
+    if (rank >= h->samples) rank = h->samples - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BENCH_BUCKETS; ++b) {
+        seen += h->counts[b];
+        if (seen > rank) {
+            uint64_t v = bucket_value(b);
+            return v > h->max_ns ? h->max_ns : v;
+        }
+    }
+    return h->max_ns;
+}
+
+double bench_hist_mean(const BenchHist *h) {
+    return h->samples ? (double)h->sum_ns / (double)h->samples : 0.0;
+}
+
+/* ---------- Runner ---------- */
+
+void bench_run(const BenchSpec *spec, bench_op_fn op, void *ctx, BenchResult *out) {
+    size_t batch = spec->batch > 1 ? spec->batch : 1;
+    memset(out, 0, sizeof(*out));
+    for (int rep = -spec->warmup; rep < spec->reps; ++rep) {
+        if (spec->setup) spec->setup(ctx, rep);
+        int timed = rep >= 0;
+        for (size_t i = 0; i < spec->ops; i += batch) {
+            size_t end = i + batch < spec->ops ? i + batch : spec->ops;
+            uint64_t t0 = bench_now_ns();
+            for (size_t j = i; j < end; ++j) op(ctx, j);
+            uint64_t t1 = bench_now_ns();
+            if (timed) {
+                bench_hist_add(&out->hist, (t1 - t0) / (end - i), end - i);
+                out->total_ns += t1 - t0;
+                out->ops += end - i;
+            }
+        }
+    }
+    out->peak_rss = bench_peak_rss();
+}
+
+void bench_single(BenchResult *out, uint64_t ns) {
+    memset(out, 0, sizeof(*out));
+    bench_hist_add(&out->hist, ns, 1);
+    out->ops = 1;
+    out->total_ns = ns;
+    out->peak_rss = bench_peak_rss();
+}
+
+void bench_merge(BenchResult *into, const BenchResult *from) {
+    for (int b = 0; b < BENCH_BUCKETS; ++b) into->hist.counts[b] += from->hist.counts[b];
+    into->hist.samples += from->hist.samples;
+    into->hist.sum_ns += from->hist.sum_ns;
+    if (from->hist.max_ns > into->hist.max_ns) into->hist.max_ns = from->hist.max_ns;
+    into->ops += from->ops;
+    into->total_ns += from->total_ns;
+    if (from->peak_rss > into->peak_rss) into->peak_rss = from->peak_rss;
+}
+
+/* ---------- CSV ---------- */
+
+void bench_csv_header(FILE *f) {
+    fprintf(f, "module,op,n,params,reps,ops,mean_ns,p50_ns,p99_ns,p999_ns,max_ns,"
+               "ops_per_sec,peak_rss_bytes,result\n");
+}
+
+void bench_csv_row(FILE *f, const char *module, const char *op, size_t n,
+                   const char *params, int reps, const BenchResult *r, const char *result) {
+    double secs = (double)r->total_ns / 1e9;
+    fprintf(f, "%s,%s,%zu,\"%s\",%d,%llu,%.1f,%llu,%llu,%llu,%llu,%.0f,%zu,%s\n",
+            module, op, n, params ? params : "", reps, (unsigned long long)r->ops,
+            bench_hist_mean(&r->hist),
+            (unsigned long long)bench_hist_percentile(&r->hist, 0.50),
+            (unsigned long long)bench_hist_percentile(&r->hist, 0.99),
+            (unsigned long long)bench_hist_percentile(&r->hist, 0.999),
+            (unsigned long long)r->hist.max_ns,
+            secs > 0 ? (double)r->ops / secs : 0.0, r->peak_rss, result ? result : "");
+    fflush(f);
+}
+
+/* ---------- Workload helpers ---------- */
+
+uint64_t bench_rand(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+int bench_chance(uint64_t *state, double ratio) {
+    return (double)(bench_rand(state) >> 11) * (1.0 / 9007199254740992.0) < ratio;
+}
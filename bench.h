@@ -0,0 +1,88 @@
+/*
+ * bench.h
+ *
+ * Shared benchmark harness for the trie, N-ary and Merkle drivers: a
+ * portable nanosecond clock, peak RSS, per-operation latency histograms
+ * with percentiles, warmup + repetitions, and one CSV schema for every
+ * module:
+ *
+ *   module,op,n,params,reps,ops,mean_ns,p50_ns,p99_ns,p999_ns,max_ns,
+ *   ops_per_sec,peak_rss_bytes,result
+ *
+ * 'params' carries the workload knobs (hit ratio, fanout, depth, ...) as
+ * key=value pairs separated by ';'.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Log-linear histogram: 16 sub-buckets per power of two (<= 6.25% error) */
+#define BENCH_SUB_BITS 4
+#define BENCH_BUCKETS ((64 - BENCH_SUB_BITS + 1) << BENCH_SUB_BITS)
+
+typedef struct {
+    uint64_t counts[BENCH_BUCKETS];
+    uint64_t samples;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+} BenchHist;
+
+/* Monotonic clock in nanoseconds */
+uint64_t bench_now_ns(void);
+
+/* Peak resident set size of the process so far, in bytes (0 if unknown) */
+size_t bench_peak_rss(void);
+
+/* Create a directory if it does not exist yet (0 on success) */
+int bench_ensure_dir(const char *path);
+
+void bench_hist_reset(BenchHist *h);
+/* Record 'count' operations that each took ns */
+void bench_hist_add(BenchHist *h, uint64_t ns, uint64_t count);
+/* Latency at quantile q (0..1), e.g. 0.99 */
+uint64_t bench_hist_percentile(const BenchHist *h, double q);
+double bench_hist_mean(const BenchHist *h);
+
+/* One operation of a workload: op(ctx, i) for i = 0 .. ops-1 */
+typedef void (*bench_op_fn)(void *ctx, size_t i);
+
+typedef struct {
+    size_t ops;          /* operations per repetition */
+    int warmup;          /* untimed repetitions run first */
+    int reps;            /* timed repetitions */
+    size_t batch;        /* operations per clock sample; 0 or 1 = every op.
+                            Use > 1 when an op is close to the clock's cost */
+    void (*setup)(void *ctx, int rep);   /* optional, untimed, before each rep */
+} BenchSpec;
+
+typedef struct {
+    BenchHist hist;      /* per-operation latency */
+    uint64_t ops;        /* operations timed */
+    uint64_t total_ns;   /* time spent in timed operations */
+    size_t peak_rss;
+} BenchResult;
+
+/* Run spec->warmup + spec->reps repetitions of the workload */
+void bench_run(const BenchSpec *spec, bench_op_fn op, void *ctx, BenchResult *out);
+
+/* Record a single timed operation (e.g. one build) as a result */
+void bench_single(BenchResult *out, uint64_t ns);
+
+/* Fold one result into another (e.g. the same op across several runs) */
+void bench_merge(BenchResult *into, const BenchResult *from);
+
+void bench_csv_header(FILE *f);
+void bench_csv_row(FILE *f, const char *module, const char *op, size_t n,
+                   const char *params, int reps, const BenchResult *r, const char *result);
+
+/* splitmix64: small seeded generator for reproducible workloads */
+uint64_t bench_rand(uint64_t *state);
+
+/* 1 with probability 'ratio' (hit/miss mixing) */
+int bench_chance(uint64_t *state, double ratio);
+
+#endif
@@ -0,0 +1,371 @@
+/*
+ * leafsource.c
+ *
+ * Directory scan and streaming file hashing for Merkle leaves. Reads go
+ * through a fixed LEAF_READ_BLOCK buffer (sequential-access hint on POSIX);
+ * chunk tasks open their own handle and read their byte range with pread.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "leafsource.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+  #include <windows.h>
+#else
+  #include <dirent.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+/* ---------- Files ---------- */
+
+#if defined(_WIN32) || defined(_WIN64)
+typedef FILE *LeafFile;
+#define LEAF_FILE_NONE NULL
+
+static LeafFile file_open(const char *path, uint64_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    _fseeki64(f, 0, SEEK_END);
+    *size = (uint64_t)_ftelli64(f);
+    _fseeki64(f, 0, SEEK_SET);
+    return f;
+}
+
+/* Read up to len bytes at offset off; returns bytes read or -1 */
+static long long file_read_at(LeafFile f, void *buf, size_t len, uint64_t off) {
+    if (_fseeki64(f, (long long)off, SEEK_SET) != 0) return -1;
+    size_t got = fread(buf, 1, len, f);
+    return ferror(f) ? -1 : (long long)got;
+}
+
+static void file_close(LeafFile f) { fclose(f); }
+#else
+typedef int LeafFile;
+#define LEAF_FILE_NONE (-1)
+
+static LeafFile file_open(const char *path, uint64_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return -1; }
+    *size = (uint64_t)st.st_size;
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return fd;
+}
+
+static long long file_read_at(LeafFile fd, void *buf, size_t len, uint64_t off) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t r = pread(fd, (char*)buf + got, len - got, (off_t)(off + got));
+        if (r < 0) return -1;
+        if (r == 0) break;
+        got += (size_t)r;
+    }
+    return (long long)got;
+}
+
+static void file_close(LeafFile fd) { close(fd); }
+#endif
+
+/* SHA-256 of bytes [off, off+len) of an open file, read in buffer-sized
+   pieces; returns 0, or -1 on a short or failed read */
+static int hash_range(LeafFile f, uint64_t off, uint64_t len, unsigned char *buf,
+                      uint8_t digest[SHA256_DIGEST_LEN]) {
+    Sha256Ctx ctx;
+    sha256_mb_init(&ctx);
+    while (len > 0) {
+        size_t want = len < LEAF_READ_BLOCK ? (size_t)len : LEAF_READ_BLOCK;
+        long long got = file_read_at(f, buf, want, off);
+        if (got != (long long)want) return -1;
+        sha256_mb_update(&ctx, buf, want);
+        off += want;
+        len -= want;
+    }
+    sha256_mb_final(&ctx, digest);
+    return 0;
+}
+
+/* ---------- Chunk sub-trees ---------- */
+
+typedef struct {
+    const char *path;
+    uint64_t size;
+    size_t chunk_size;
+    uint8_t (*digests)[SHA256_DIGEST_LEN];
+    atomic_int failed;
+} ChunkJob;
+
+/* Hash chunks [begin, end) with a private handle and buffer */
+static void chunk_body(size_t begin, size_t end, void *ctx) {
+    ChunkJob *job = ctx;
+    uint64_t size;
+    unsigned char *buf = malloc(job->chunk_size < LEAF_READ_BLOCK ? job->chunk_size : LEAF_READ_BLOCK);
+    LeafFile f = buf ? file_open(job->path, &size) : LEAF_FILE_NONE;
+    if (f == LEAF_FILE_NONE) {
+        atomic_store(&job->failed, 1);
+        free(buf);
+        return;
+    }
+    for (size_t c = begin; c < end; ++c) {
+        uint64_t off = (uint64_t)c * job->chunk_size;
+        uint64_t len = job->size - off < job->chunk_size ? job->size - off : job->chunk_size;
+        if (hash_range(f, off, len, buf, job->digests[c]) != 0)
+            atomic_store(&job->failed, 1);
+    }
+    file_close(f);
+    free(buf);
+}
+
+/* Pair chunk digests upwards in place (unpaired ones are promoted) */
+static void reduce_chunks(uint8_t (*d)[SHA256_DIGEST_LEN], size_t n) {
+    uint8_t pair[2 * SHA256_DIGEST_LEN];
+    while (n > 1) {
+        size_t half = (n + 1) / 2;
+        for (size_t j = 0; j < half; ++j) {
+            if (2 * j + 1 < n) {
+                memcpy(pair, d[2 * j], SHA256_DIGEST_LEN);
+                memcpy(pair + SHA256_DIGEST_LEN, d[2 * j + 1], SHA256_DIGEST_LEN);
+                sha256_mb_single(pair, sizeof(pair), d[j]);
+            } else {
+                memmove(d[j], d[2 * j], SHA256_DIGEST_LEN);
+            }
+        }
+        n = half;
+    }
+}
+
+int leaf_hash_file(const char *path, size_t chunk_size, ThreadPool *pool,
+                   uint8_t digest[SHA256_DIGEST_LEN], uint64_t *bytes) {
+    uint64_t size = 0;
+    LeafFile f = file_open(path, &size);
+    if (f == LEAF_FILE_NONE) return -1;
+    if (bytes) *bytes = size;
+
+    /* Whole-content digest: no chunking asked for, or one chunk at most */
+    if (chunk_size == 0 || size <= chunk_size) {
+        unsigned char *buf = malloc(size < LEAF_READ_BLOCK ? (size ? size : 1) : LEAF_READ_BLOCK);
+        int rc = buf ? hash_range(f, 0, size, buf, digest) : -1;
+        free(buf);
+        file_close(f);
+        return rc;
+    }
+    file_close(f);
+
+    size_t chunks = (size_t)((size + chunk_size - 1) / chunk_size);
+    ChunkJob job = { path, size, chunk_size, malloc(chunks * SHA256_DIGEST_LEN), 0 };
+    if (!job.digests) return -1;
+    if (pool)
+        threadpool_parallel_for(pool, chunks, 0, chunk_body, &job);
+    else
+        chunk_body(0, chunks, &job);
+    int rc = atomic_load(&job.failed) ? -1 : 0;
+    if (rc == 0) {
+        reduce_chunks(job.digests, chunks);
+        memcpy(digest, job.digests[0], SHA256_DIGEST_LEN);
+    }
+    free(job.digests);
+    return rc;
+}
+
+/* ---------- Whole lists ---------- */
+
+typedef struct {
+    const LeafList *list;
+    size_t chunk_size;
+    uint64_t big;                     /* files this size or more are deferred */
+    uint8_t (*digests)[SHA256_DIGEST_LEN];
+    atomic_size_t failed;
+    atomic_ullong bytes;
+} ListJob;
+
+/* Full path of list entry i (caller frees) */
+static char *entry_path(const LeafList *list, size_t i) {
+    size_t len = strlen(list->dir) + strlen(list->paths[i]) + 2;
+    char *p = malloc(len);
+    if (p) snprintf(p, len, "%s/%s", list->dir, list->paths[i]);
+    return p;
+}
+
+static void hash_entry(ListJob *job, size_t i, ThreadPool *pool) {
+    uint64_t n = 0;
+    char *path = entry_path(job->list, i);
+    if (!path || leaf_hash_file(path, job->chunk_size, pool, job->digests[i], &n) != 0) {
+        memset(job->digests[i], 0, SHA256_DIGEST_LEN);
+        atomic_fetch_add(&job->failed, 1);
+    }
+    atomic_fetch_add(&job->bytes, n);
+    free(path);
+}
+
+static void list_body(size_t begin, size_t end, void *ctx) {
+    ListJob *job = ctx;
+    for (size_t i = begin; i < end; ++i)
+        if (job->list->sizes[i] < job->big)
+            hash_entry(job, i, NULL);
+}
+
+size_t leaf_hash_all(const LeafList *list, size_t chunk_size, ThreadPool *pool,
+                     uint8_t (*digests)[SHA256_DIGEST_LEN], uint64_t *total_bytes) {
+    ListJob job = { list, chunk_size, UINT64_MAX, digests, 0, 0 };
+    int threads = pool ? threadpool_size(pool) : 1;
+    if (pool && chunk_size && threads > 1)
+        job.big = (uint64_t)chunk_size * (uint64_t)threads;
+
+    if (pool)
+        threadpool_parallel_for(pool, list->count, 0, list_body, &job);
+    else
+        list_body(0, list->count, &job);
+
+    /* Large files: one at a time, chunks spread over the pool */
+    for (size_t i = 0; i < list->count; ++i)
+        if (list->sizes[i] >= job.big)
+            hash_entry(&job, i, pool);
+
+    if (total_bytes) *total_bytes = atomic_load(&job.bytes);
+    return atomic_load(&job.failed);
+}
+
+/* ---------- Directory scan ---------- */
+
+typedef struct {
+    char *path;
+    uint64_t size;
+} ScanEntry;
+
+typedef struct {
+    ScanEntry *items;
+    size_t count, cap;
+    int failed;
+} ScanList;
+
+static void scan_add(ScanList *s, const char *rel, uint64_t size) {
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 256;
+        ScanEntry *grown = realloc(s->items, cap * sizeof(ScanEntry));
+        if (!grown) { s->failed = 1; return; }
+        s->items = grown;
+        s->cap = cap;
+    }
+    size_t len = strlen(rel) + 1;
+    char *copy = malloc(len);
+    if (!copy) { s->failed = 1; return; }
+    memcpy(copy, rel, len);
+    s->items[s->count].path = copy;
+    s->items[s->count].size = size;
+    s->count++;
+}
+
+/* Walk dir/rel; rel is "" for the top level. Symlinks are not followed. */
+static int scan_walk(const char *dir, const char *rel, ScanList *s) {
+    size_t base_len = strlen(dir) + strlen(rel) + 2;
+    char *base = malloc(base_len);
+    if (!base) return -1;
+    snprintf(base, base_len, rel[0] ? "%s/%s" : "%s", dir, rel);
+    int rc = 0;
+
+#if defined(_WIN32) || defined(_WIN64)
+    size_t pat_len = base_len + 2;
+    char *pattern = malloc(pat_len);
+    WIN32_FIND_DATAA fd;
+    HANDLE h = INVALID_HANDLE_VALUE;
+    if (pattern) {
+        snprintf(pattern, pat_len, "%s\\*", base);
+        h = FindFirstFileA(pattern, &fd);
+    }
+    free(pattern);
+    if (h == INVALID_HANDLE_VALUE) { free(base); return -1; }
+    do {
+        const char *name = fd.cFileName;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+        int is_dir = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        uint64_t size = ((uint64_t)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+#else
+    DIR *d = opendir(base);
+    if (!d) { free(base); return -1; }
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        const char *name = ent->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+        size_t full_len = base_len + strlen(name) + 1;
+        char *full = malloc(full_len);
+        if (!full) { s->failed = 1; break; }
+        snprintf(full, full_len, "%s/%s", base, name);
+        struct stat st;
+        int ok = lstat(full, &st) == 0;
+        free(full);
+        if (!ok || !(S_ISDIR(st.st_mode) || S_ISREG(st.st_mode))) continue;
+        int is_dir = S_ISDIR(st.st_mode);
+        uint64_t size = (uint64_t)st.st_size;
+#endif
+        size_t sub_len = strlen(rel) + strlen(name) + 2;
+        char *sub = malloc(sub_len);
+        if (!sub) { s->failed = 1; break; }
+        snprintf(sub, sub_len, rel[0] ? "%s/%s" : "%s%s", rel, name);
+        if (is_dir) {
+            if (scan_walk(dir, sub, s) != 0) rc = -1;
+        } else {
+            scan_add(s, sub, size);
+        }
+        free(sub);
+        if (s->failed) break;
+#if defined(_WIN32) || defined(_WIN64)
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+#else
+    }
+    closedir(d);
+#endif
+    free(base);
+    return rc;
+}
+
+static int cmp_scan_entry(const void *a, const void *b) {
+    return strcmp(((const ScanEntry*)a)->path, ((const ScanEntry*)b)->path);
+}
+
+int leaf_scan_dir(const char *dir, LeafList *out) {
+    memset(out, 0, sizeof(*out));
+    ScanList s = { NULL, 0, 0, 0 };
+    int rc = scan_walk(dir, "", &s);
+    size_t dir_len = strlen(dir) + 1;
+
+    out->dir = malloc(dir_len);
+    out->paths = malloc((s.count ? s.count : 1) * sizeof(char*));
+    out->sizes = malloc((s.count ? s.count : 1) * sizeof(uint64_t));
+    if (rc != 0 || s.failed || !out->dir || !out->paths || !out->sizes) {
+        for (size_t i = 0; i < s.count; ++i) free(s.items[i].path);
+        free(s.items);
+        leaf_list_free(out);
+        return -1;
+    }
+    memcpy(out->dir, dir, dir_len);
+    qsort(s.items, s.count, sizeof(ScanEntry), cmp_scan_entry);
+    for (size_t i = 0; i < s.count; ++i) {
+        out->paths[i] = s.items[i].path;
+        out->sizes[i] = s.items[i].size;
+    }
+    out->count = s.count;
+    free(s.items);
+    return 0;
+}
+
+void leaf_list_free(LeafList *list) {
+    if (!list) return;
+    for (size_t i = 0; i < list->count; ++i) free(list->paths[i]);
+    free(list->paths);
+    free(list->sizes);
+    free(list->dir);
+    memset(list, 0, sizeof(*list));
+}
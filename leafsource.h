@@ -0,0 +1,54 @@
+/*
+ * leafsource.h
+ *
+ * Merkle leaves from files on disk instead of in-memory strings. A
+ * directory tree is scanned for regular files (paths only), and each file
+ * is hashed incrementally from large sequential reads, so memory stays at
+ * one read buffer per thread no matter how big the files are.
+ *
+ * With a chunk size, a file larger than one chunk is hashed as a sub-tree:
+ * each chunk gets its own SHA-256, the chunk digests are paired upwards
+ * (an unpaired digest is promoted), and that sub-tree's root becomes the
+ * file's leaf digest. Chunks are independent, so one huge file can be
+ * hashed by several threads.
+ */
+
+#ifndef LEAFSOURCE_H
+#define LEAFSOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sha256_mb.h"
+#include "threadpool.h"
+
+#define LEAF_READ_BLOCK (1u << 20)   /* bytes per sequential read */
+
+typedef struct {
+    char **paths;        /* relative to the scanned directory, sorted */
+    uint64_t *sizes;     /* file sizes at scan time */
+    size_t count;
+    char *dir;           /* the scanned directory */
+} LeafList;
+
+/* Collect every regular file below dir (recursively), sorted by path.
+   Returns 0, or -1 if dir cannot be read or memory runs out. */
+int leaf_scan_dir(const char *dir, LeafList *out);
+void leaf_list_free(LeafList *list);
+
+/* Digest of one file. chunk_size 0 hashes the whole content (identical to
+   SHA-256 of the bytes in memory); otherwise files above chunk_size bytes
+   get a chunk sub-tree root. pool may be NULL; with a pool the chunks of
+   this file are hashed in parallel. *bytes receives the file size.
+   Returns 0, or -1 on a read error. */
+int leaf_hash_file(const char *path, size_t chunk_size, ThreadPool *pool,
+                   uint8_t digest[SHA256_DIGEST_LEN], uint64_t *bytes);
+
+/* Hash every file of the list: digests[i] belongs to list->paths[i].
+   With a pool, small files are spread over the threads one file per task,
+   and files of at least one chunk per thread are then hashed one at a
+   time with their chunks in parallel. Returns the number of files that
+   could not be read (their digest is left zeroed). */
+size_t leaf_hash_all(const LeafList *list, size_t chunk_size, ThreadPool *pool,
+                     uint8_t (*digests)[SHA256_DIGEST_LEN], uint64_t *total_bytes);
+
+#endif
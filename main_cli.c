@@ -1,301 +1,1069 @@
-/*
- * main_cli.c
- *
- * CLI driver for Merkle module used by Person D.
- *
- * Usage examples:
- *  ./merkle_demo --build 1024 --runs 10 --seed 42 --csv output_merkle.csv
- *  ./merkle_demo --build 1024 --runs 5 --seed 10 --tamper file0.txt --verify file0.txt --csv out.csv
- *
- * This expects your merkle.h/merkle.c/sha256.c implementations to provide:
- *  - int build_leaves_from_arrays(MerkleTree*, const char**, const char**, size_t)
- *  - int build_merkle_tree(MerkleTree*)
- *  - NameMap *namemap_create(size_t)
- *  - int namemap_put(NameMap*, const char*, MerkleNode*)
- *  - int verify_file(NameMap*, MerkleTree*, const char*)
- *  - int tamper_file(NameMap*, const char*, const char*)
- *  - void free_tree(MerkleTree*)
- *  - void namemap_free(NameMap*)
- *
- * CSV format written:
- * module,run_id,n,seed,op,op_time_ms,memory_bytes,result,details
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include "merkle.h"
-#include <string.h>
-
-
-#define _POSIX_C_SOURCE 200809L
-#define MODULE_NAME "merkle"
-#define DEFAULT_RUNS 5
-#define DEFAULT_N 16
-#define DEFAULT_BUCKETS 257
-/* portable high-res timer */
-#if defined(_WIN32) || defined(_WIN64)
-  #include <windows.h>
-  static double now_seconds(void) {
-      LARGE_INTEGER freq, pc;
-      QueryPerformanceFrequency(&freq);
-      QueryPerformanceCounter(&pc);
-      return (double)pc.QuadPart / (double)freq.QuadPart;
-  }
-#else
-  #include <time.h>
-  static double now_seconds(void) {
-      struct timespec ts;
-      clock_gettime(CLOCK_MONOTONIC, &ts);
-      return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
-  }
-#endif
-
-
-/* Helper: portable timer (seconds) */
-
-/* Generate deterministic "random" content given seed + index */
-static char *gen_content(unsigned int seed, size_t idx, size_t length) {
-    srand((unsigned int)(seed + (unsigned int)idx));
-    char *s = malloc(length + 1);
-    if (!s) return NULL;
-    const char *chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
-    size_t m = strlen(chars);
-    for (size_t i = 0; i < length; ++i) {
-        s[i] = chars[rand() % m];
-    }
-    s[length] = '\0';
-    return s;
-}
-
-/* Build arrays of filenames and contents for n files (returns 0 on success) */
-static int make_datasets(const char *prefix, size_t n, unsigned int seed,
-                         char ***out_filenames, char ***out_contents) {
-    char **fn = calloc(n, sizeof(char*));
-    char **ct = calloc(n, sizeof(char*));
-    if (!fn || !ct) { free(fn); free(ct); return -1; }
-    for (size_t i = 0; i < n; ++i) {
-        char buf[128];
-        snprintf(buf, sizeof(buf), "%s%zu.txt", prefix, i);
-        fn[i] = strdup(buf);
-        /* varied length for realism */
-        size_t len = 20 + (rand() % 200);
-        ct[i] = gen_content(seed, i, len);
-        if (!ct[i]) {
-            for (size_t j = 0; j <= i; ++j) { free(fn[j]); free(ct[j]); }
-            free(fn); free(ct);
-            return -2;
-        }
-    }
-    *out_filenames = fn;
-    *out_contents = ct;
-    return 0;
-}
-
-/* Free datasets */
-static void free_datasets(char **fn, char **ct, size_t n) {
-    if (!fn || !ct) return;
-    for (size_t i = 0; i < n; ++i) {
-        free(fn[i]);
-        free(ct[i]);
-    }
-    free(fn);
-    free(ct);
-}
-
-/* Append one CSV row (opened file pointer must be writable) */
-static void csv_write_row(FILE *f, const char *module, int run_id, size_t n, unsigned int seed,
-                          const char *op, double time_ms, long memory_bytes,
-                          const char *result, const char *details) {
-    /* CSV escaping simple: wrap details in quotes, escape internal quotes by doubling */
-    fprintf(f, "%s,%d,%zu,%u,%s,%.6f,%ld,%s,\"%s\"\n",
-            module, run_id, n, seed, op, time_ms, memory_bytes,
-            result ? result : "", details ? details : "");
-    fflush(f);
-}
-
-/* Very small wrapper to build, map names, measure and output CSV rows */
-static int run_one_build(FILE *csv, int run_id, size_t n, unsigned int seed, NameMap *map_prefix) {
-    char **filenames = NULL, **contents = NULL;
-    int rc = make_datasets("file", n, seed, &filenames, &contents);
-    if (rc != 0) return rc;
-
-    MerkleTree tree = {0};
-
-    /* fill leaves and time the build */
-    double t0 = now_seconds();
-    if (build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, n) != 0) {
-        free_datasets(filenames, contents, n);
-        return -3;
-    }
-    if (map_prefix) {
-        for (size_t i = 0; i < tree.leaf_count; ++i) {
-            namemap_put(map_prefix, tree.leaves[i]->filename, tree.leaves[i]);
-        }
-    }
-    if (build_merkle_tree(&tree)) {
-        free_tree(&tree);
-        free_datasets(filenames, contents, n);
-        return -4;
-    }
-    double t1 = now_seconds();
-    double build_ms = (t1 - t0) * 1000.0;
-
-    /* memory unknown here (set 0) */
-    long mem = 0;
-    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "build", build_ms, mem, "ok", tree.root ? tree.root->hash : "no_root");
-
-    /* We keep tree and map live for possible verify/tamper during the same run.
-       The caller may want to tamper/verify using the same tree; so we return the tree by storing
-       it in a file-scoped or caller-managed structure. For our CLI, we'll free at end of function.
-    */
-
-    /* For convenience, print root to stdout */
-    if (tree.root) printf("Run %d build complete: root=%s (time=%.3f ms)\n", run_id, tree.root->hash, build_ms);
-
-    /* Cleanup */
-    free_tree(&tree);
-    free_datasets(filenames, contents, n);
-    return 0;
-}
-
-/* For runs that require tamper + verify in same run, we provide a function that builds and returns tree + map.
-   But to keep this file small, Person D will typically call --build then invoke --verify separately.
-   Below are simplified verify/tamper helpers that reconstruct the same data (deterministic via seed). */
-
-/* Verify a named file: builds structure, then measures verify */
-static int run_verify(FILE *csv, int run_id, size_t n, unsigned int seed, const char *target_filename) {
-    char **filenames = NULL, **contents = NULL;
-    int rc = make_datasets("file", n, seed, &filenames, &contents);
-    if (rc != 0) return rc;
-
-    MerkleTree tree = {0};
-    NameMap *map = namemap_create(DEFAULT_BUCKETS);
-
-    if (build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, n) != 0) {
-        free_datasets(filenames, contents, n);
-        namemap_free(map);
-        return -3;
-    }
-    for (size_t i = 0; i < tree.leaf_count; ++i) namemap_put(map, tree.leaves[i]->filename, tree.leaves[i]);
-    if (build_merkle_tree(&tree)) {
-        free_tree(&tree); free_datasets(filenames, contents, n); namemap_free(map);
-        return -4;
-    }
-
-    double t0 = now_seconds();
-    int res = verify_file(map, &tree, target_filename);
-    double t1 = now_seconds();
-    double v_ms = (t1 - t0) * 1000.0;
-    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "verify", v_ms, 0, (res==1) ? "ok" : (res==0) ? "tampered" : "error", target_filename);
-
-    free_tree(&tree);
-    namemap_free(map);
-    free_datasets(filenames, contents, n);
-    return 0;
-}
-
-/* Tamper a named file and measure verify post-tamper: */
-static int run_tamper_and_verify(FILE *csv, int run_id, size_t n, unsigned int seed,
-                                const char *target_filename, const char *new_content) {
-    /* Build deterministic dataset and map */
-    char **filenames = NULL, **contents = NULL;
-    int rc = make_datasets("file", n, seed, &filenames, &contents);
-    if (rc != 0) return rc;
-
-    MerkleTree tree = {0};
-    NameMap *map = namemap_create(DEFAULT_BUCKETS);
-
-    if (build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, n) != 0) {
-        free_datasets(filenames, contents, n); namemap_free(map); return -3;
-    }
-    for (size_t i = 0; i < tree.leaf_count; ++i) namemap_put(map, tree.leaves[i]->filename, tree.leaves[i]);
-    if (build_merkle_tree(&tree)) {
-        free_tree(&tree); free_datasets(filenames, contents, n); namemap_free(map); return -4;
-    }
-
-    /* Verify before tamper */
-    double t0 = now_seconds();
-    int res_before = verify_file(map, &tree, target_filename);
-    double t1 = now_seconds();
-    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "verify_before_tamper", (t1 - t0)*1000.0, 0,
-                  (res_before==1) ? "ok" : (res_before==0) ? "tampered" : "error", target_filename);
-
-    /* Tamper (should change only data) */
-    tamper_file(map, &tree, target_filename, new_content);
-
-
-    /* Verify after tamper */
-    double t2 = now_seconds();
-    int res_after = verify_file(map, &tree, target_filename);
-    double t3 = now_seconds();
-    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "verify_after_tamper", (t3 - t2)*1000.0, 0,
-                  (res_after==1) ? "ok" : (res_after==0) ? "tampered" : "error", target_filename);
-
-    /* Optionally rebuild and record rebuild time */
-    double t4 = now_seconds();
-    build_merkle_tree(&tree);
-    double t5 = now_seconds();
-    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "rebuild_after_tamper", (t5 - t4)*1000.0, 0, "ok", "rebuild");
-
-    /* Cleanup */
-    free_tree(&tree);
-    namemap_free(map);
-    free_datasets(filenames, contents, n);
-    return 0;
-}
-
-/* Simple CLI arg parsing (naive) */
-int main(int argc, char **argv) {
-    size_t n = DEFAULT_N;
-    int runs = DEFAULT_RUNS;
-    unsigned int seed = 42;
-    char csv_path[512] = "output_merkle.csv";
-    int do_build = 0, do_verify = 0, do_tamper = 0;
-    char verify_target[256] = {0};
-    char tamper_target[256] = {0}, tamper_content[512] = {0};
-
-    /* parse arguments */
-    for (int i = 1; i < argc; ++i) {
-        if (strcmp(argv[i], "--build") == 0 && i+1 < argc) { n = (size_t)atoi(argv[++i]); do_build = 1; }
-        else if (strcmp(argv[i], "--runs") == 0 && i+1 < argc) { runs = atoi(argv[++i]); }
-        else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) { seed = (unsigned int)atoi(argv[++i]); }
-        else if (strcmp(argv[i], "--csv") == 0 && i+1 < argc) { strncpy(csv_path, argv[++i], sizeof(csv_path)-1); }
-        else if (strcmp(argv[i], "--verify") == 0 && i+1 < argc) { strncpy(verify_target, argv[++i], sizeof(verify_target)-1); do_verify = 1; }
-        else if (strcmp(argv[i], "--tamper") == 0 && i+2 < argc) { strncpy(tamper_target, argv[++i], sizeof(tamper_target)-1); strncpy(tamper_content, argv[++i], sizeof(tamper_content)-1); do_tamper = 1; }
-        else if (strcmp(argv[i], "--help") == 0) {
-            printf("Usage: %s [--build N] [--runs R] [--seed S] [--verify filename] [--tamper filename newcontent] [--csv out.csv]\n", argv[0]);
-            return 0;
-        } else {
-            fprintf(stderr, "Unknown arg: %s\n", argv[i]);
-            return 1;
-        }
-    }
-
-    FILE *csv = fopen(csv_path, "w");
-    if (!csv) { perror("fopen"); return 1; }
-    /* CSV header */
-    fprintf(csv, "module,run_id,n,seed,op,op_time_ms,memory_bytes,result,details\n");
-
-    /* For each run: call requested ops */
-    for (int run = 1; run <= runs; ++run) {
-        unsigned int this_seed = seed + (unsigned int)run; /* vary seed per run for variability but deterministic */
-        if (do_build) {
-            int rc = run_one_build(csv, run, n, this_seed, NULL);
-            if (rc != 0) fprintf(stderr, "run_one_build failed (rc=%d)\n", rc);
-        }
-        if (do_verify) {
-            int rc = run_verify(csv, run, n, this_seed, verify_target);
-            if (rc != 0) fprintf(stderr, "run_verify failed (rc=%d)\n", rc);
-        }
-        if (do_tamper) {
-            int rc = run_tamper_and_verify(csv, run, n, this_seed, tamper_target, tamper_content);
-            if (rc != 0) fprintf(stderr, "run_tamper_and_verify failed (rc=%d)\n", rc);
-        }
-    }
-
-    fclose(csv);
-    printf("Results written to %s\n", csv_path);
-    return 0;
-}
+/*
+ * main_cli.c
+ *
+ * CLI driver for Merkle module used by Person D.
+ *
+ * Usage examples:
+ *  ./merkle_demo --build 1024 --runs 10 --seed 42 --csv output_merkle.csv
+ *  ./merkle_demo --build 1024 --runs 5 --seed 10 --tamper file0.txt --verify file0.txt --csv out.csv
+ *  ./merkle_demo --build 100000 --runs 3 --threads 1,2,4,8 --csv speedup.csv
+ *  ./merkle_demo --build 65536 --tamper file7.txt XYZ --batch 64 --csv update.csv
+ *  ./merkle_demo --build 1048576 --runs 3 --proof 256 --csv proofs.csv
+ *  ./merkle_demo --build 1000000 --runs 3 --hash-bench --csv hashing.csv
+ *  ./merkle_demo --build 1000000 --runs 1 --save-snap a.snap --csv snap.csv
+ *  ./merkle_demo --build 1000000 --runs 1 --load-snap a.snap --verify file7.txt --csv snap.csv
+ *  ./merkle_demo --diff a.snap b.snap --csv diff.csv
+ *  ./merkle_demo --dir /data/corpus --chunk 4194304 --threads 1,4,8 --runs 3 --csv dir.csv
+ *  ./merkle_demo --build 100000 --verify file7.txt --proof 16 --bench-csv bench_merkle.csv
+ *  ./merkle_demo --build 1000000 --runs 3 --generate --proof 64 --csv realistic.csv
+ *  ./merkle_demo --build 1000000 --runs 3 --stream --csv stream.csv
+ *
+ * This expects your merkle.h/merkle.c/sha256.c implementations to provide:
+ *  - MerkleNode::hash as a raw uint8_t[SHA256_DIGEST_LEN] digest, not hex text;
+ *      node digests live in one contiguous level-ordered array (leaves first,
+ *      root last) and parents hash the 64-byte left||right digests directly.
+ *      Hex is produced only here, at output time (hex_digest()).
+ *  - size_t merkle_tree_bytes(const MerkleTree*)
+ *      heap footprint of nodes, digest array and leaf data (memory_bytes column)
+ *  - const uint8_t *merkle_digests(const MerkleTree*)
+ *      the level-ordered digest array (leaves first, root last), for snapshot_write()
+ *  - int merkle_odd_rule(void)
+ *      SNAPSHOT_ODD_PROMOTE or SNAPSHOT_ODD_DUPLICATE, how an unpaired node is lifted
+ *  - int build_leaves_from_digests(MerkleTree*, const char **names,
+ *                                  const uint8_t (*digests)[SHA256_DIGEST_LEN], size_t n)
+ *      leaves whose digests were computed elsewhere (leafsource.c streams files
+ *      from disk); no leaf content is kept in memory
+ *  - merkle.h including namemap.h: the filename index (namemap_create/put/get/free)
+ *      is the open-addressing table in namemap.c
+ *  - NameMap *merkle_name_index(const MerkleTree*)
+ *      that index filled with every leaf, pre-sized with the leaf count
+ *  - int build_leaves_from_arrays(MerkleTree*, const char**, const char**, size_t)
+ *  - int build_merkle_tree(MerkleTree*)
+ *  - int verify_file(NameMap*, MerkleTree*, const char*)
+ *  - int tamper_file(NameMap*, MerkleTree*, const char*, const char*)
+ *  - void free_tree(MerkleTree*)
+ *  - int build_leaves_from_arrays_mt(MerkleTree*, const char**, const char**, size_t, ThreadPool*)
+ *      hashes leaves in parallel chunks via threadpool_parallel_for()
+ *  - int build_merkle_tree_mt(MerkleTree*, ThreadPool*)
+ *      reduces each level in parallel; root must be byte-identical to build_merkle_tree()
+ *  - int merkle_update_leaf(MerkleTree*, MerkleNode *leaf)
+ *      rehashes the leaf from its data, then only its ancestors up to the root (O(log n))
+ *  - int merkle_update_leaves(MerkleTree*, MerkleNode **leaves, size_t k)
+ *      batched variant: rehashes every shared ancestor once, level by level
+ *  - MerkleProof *get_proof(NameMap*, MerkleTree*, const char *filename)
+ *      sibling-hash path from the leaf to the root
+ *  - int verify_proof(const uint8_t *root_hash, const char *leaf_content, const MerkleProof*)
+ *      standalone check, needs no tree (1 = valid, 0 = invalid)
+ *  - size_t proof_size_bytes(const MerkleProof*), void free_proof(MerkleProof*)
+ *  - MerkleMultiProof *get_multiproof(NameMap*, MerkleTree*, const char **filenames, size_t k)
+ *      one proof for k leaves; siblings shared by several paths (or derivable
+ *      from other included leaves) are stored once
+ *  - int verify_multiproof(const uint8_t *root_hash, const char **contents, size_t k, const MerkleMultiProof*)
+ *  - size_t multiproof_size_bytes(const MerkleMultiProof*), void free_multiproof(MerkleMultiProof*)
+ *
+ * Leaf hashing and interior pair hashing in merkle.c are expected to go
+ * through sha256_mb_hash() (sha256_mb.h) a level at a time, so that 4/8/16
+ * small messages share one SIMD compression; --hash-bench checks that the
+ * multi-buffer kernels agree with OpenSSL's SHA256() digest for digest.
+ *
+ * CSV format written:
+ * module,run_id,n,seed,op,op_time_ms,memory_bytes,result,details
+ *
+ * --stream appends the same leaves one at a time to the frontier
+ * accumulator of merkle_stream.h and checks its root against
+ * build_merkle_tree(); rows stream_append, stream_append_logged and
+ * stream_consistency report append throughput and proof cost, and
+ * stream_prefix_roots compares merkle_stream_root_at() with a batch build
+ * over the same prefix for every size up to 64 and around each power of two.
+ *
+ * --bench-csv additionally writes build, namemap_get (hit/miss mix, see
+ * --hit-ratio), proof_gen and proof_verify latency percentiles in the
+ * shared schema of bench.h.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "merkle.h"
+#include "namemap.h"
+#include "threadpool.h"
+#include "sha256_mb.h"
+#include "snapshot.h"
+#include "leafsource.h"
+#include "bench.h"
+#include "nsgen.h"
+#include "merkle_stream.h"
+#include <openssl/sha.h>
+
+#define MODULE_NAME "merkle"
+#define DEFAULT_RUNS 5
+#define DEFAULT_N 16
+#define MAX_THREAD_CONFIGS 16
+#define BENCH_PROOF_SAMPLES 1024
+#define BENCH_LOOKUP_REPS 3
+
+/* portable high-res timer (seconds), shared with the other drivers via bench.c */
+static double now_seconds(void) {
+    return bench_now_ns() / 1e9;
+}
+
+static char bench_csv_path[512] = {0};
+
+/* --bench-csv: per-operation latency in the shared schema of bench.h,
+   folded across runs and written once at exit */
+static double bench_hit_ratio = 0.5;
+static struct {
+    BenchResult build, namemap_get, proof_gen, proof_verify;
+    int builds, lookup_reps, proof_reps;
+    size_t wrong;
+} bench_totals;
+
+/* Generate deterministic "random" content given seed + index. The length
+   is drawn after seeding too, so leaf i depends only on (seed, i) and not
+   on how many datasets were generated before in this process. */
+static char *gen_content(unsigned int seed, size_t idx) {
+    srand((unsigned int)(seed + (unsigned int)idx));
+    size_t length = 20 + (rand() % 200);   /* varied length for realism */
+    char *s = malloc(length + 1);
+    if (!s) return NULL;
+    const char *chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+    size_t m = strlen(chars);
+    for (size_t i = 0; i < length; ++i) {
+        s[i] = chars[rand() % m];
+    }
+    s[length] = '\0';
+    return s;
+}
+
+/* --generate: filenames are full paths from nsgen.h instead of "fileN.txt" */
+static int gen_names = 0;
+
+/* Build arrays of filenames and contents for n files (returns 0 on success) */
+static int make_datasets(const char *prefix, size_t n, unsigned int seed,
+                         char ***out_filenames, char ***out_contents) {
+    char **fn = calloc(n, sizeof(char*));
+    char **ct = calloc(n, sizeof(char*));
+    NsGen *gen = NULL;
+    if (gen_names) {
+        NsGenConfig gc;
+        nsgen_defaults(&gc, seed, n);
+        gen = nsgen_create(&gc);
+    }
+    if (!fn || !ct || (gen_names && !gen)) { free(fn); free(ct); nsgen_free(gen); return -1; }
+    for (size_t i = 0; i < n; ++i) {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%s%zu.txt", prefix, i);
+        const char *name = gen ? nsgen_next(gen, NULL) : buf;
+        fn[i] = name ? strdup(name) : NULL;
+        ct[i] = gen_content(seed, i);
+        if (!ct[i] || !fn[i]) {
+            for (size_t j = 0; j <= i; ++j) { free(fn[j]); free(ct[j]); }
+            free(fn); free(ct);
+            nsgen_free(gen);
+            return -2;
+        }
+    }
+    nsgen_free(gen);
+    *out_filenames = fn;
+    *out_contents = ct;
+    return 0;
+}
+
+/* Free datasets */
+static void free_datasets(char **fn, char **ct, size_t n) {
+    if (!fn || !ct) return;
+    for (size_t i = 0; i < n; ++i) {
+        free(fn[i]);
+        free(ct[i]);
+    }
+    free(fn);
+    free(ct);
+}
+
+/* Append one CSV row (opened file pointer must be writable) */
+static void csv_write_row(FILE *f, const char *module, int run_id, size_t n, unsigned int seed,
+                          const char *op, double time_ms, long memory_bytes,
+                          const char *result, const char *details) {
+    /* CSV escaping simple: wrap details in quotes, escape internal quotes by doubling */
+    fprintf(f, "%s,%d,%zu,%u,%s,%.6f,%ld,%s,\"%s\"\n",
+            module, run_id, n, seed, op, time_ms, memory_bytes,
+            result ? result : "", details ? details : "");
+    fflush(f);
+}
+
+/* Format a raw digest as lowercase hex (out must hold 2*SHA256_DIGEST_LEN+1) */
+static const char *hex_digest(const uint8_t *digest, char *out) {
+    static const char hexd[] = "0123456789abcdef";
+    for (size_t i = 0; i < SHA256_DIGEST_LEN; ++i) {
+        out[2*i] = hexd[digest[i] >> 4];
+        out[2*i + 1] = hexd[digest[i] & 15];
+    }
+    out[2*SHA256_DIGEST_LEN] = '\0';
+    return out;
+}
+
+/* Thread counts requested with --threads (empty = sequential build only) */
+static int thread_configs[MAX_THREAD_CONFIGS];
+static int thread_config_count = 0;
+
+/* Leaves to tamper and update together with --batch (0 = single leaf only) */
+static int batch_k = 0;
+
+/* --save-snap: where builds (and tampered rebuilds) write their snapshot */
+static char snap_save_path[512] = {0};
+
+/* Write the tree's digests and filenames to --save-snap and record a row */
+static void save_snapshot(FILE *csv, int run_id, size_t n, unsigned int seed,
+                          const MerkleTree *tree, char **filenames) {
+    if (!snap_save_path[0] || !tree->root) return;
+    double t0 = now_seconds();
+    int rc = snapshot_write(snap_save_path, (const uint8_t (*)[SHA256_DIGEST_LEN])merkle_digests(tree),
+                            tree->leaf_count, (const char *const *)filenames, merkle_odd_rule());
+    double t1 = now_seconds();
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "snapshot_save", (t1 - t0)*1000.0, 0,
+                  rc == 0 ? "ok" : "error", snap_save_path);
+}
+
+/* Parse a comma-separated thread list such as "1,2,4,8" */
+static void parse_thread_list(const char *arg) {
+    thread_config_count = 0;
+    while (*arg && thread_config_count < MAX_THREAD_CONFIGS) {
+        int t = atoi(arg);
+        if (t > 0) thread_configs[thread_config_count++] = t;
+        const char *comma = strchr(arg, ',');
+        if (!comma) break;
+        arg = comma + 1;
+    }
+}
+
+/* Very small wrapper to build, map names, measure and output CSV rows */
+static int run_one_build(FILE *csv, int run_id, size_t n, unsigned int seed, NameMap *map_prefix) {
+    char **filenames = NULL, **contents = NULL;
+    int rc = make_datasets("file", n, seed, &filenames, &contents);
+    if (rc != 0) return rc;
+
+    MerkleTree tree = {0};
+
+    /* fill leaves and time the build */
+    double t0 = now_seconds();
+    if (build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, n) != 0) {
+        free_datasets(filenames, contents, n);
+        return -3;
+    }
+    if (map_prefix) {
+        for (size_t i = 0; i < tree.leaf_count; ++i) {
+            namemap_put(map_prefix, tree.leaves[i]->filename, tree.leaves[i]);
+        }
+    }
+    if (build_merkle_tree(&tree)) {
+        free_tree(&tree);
+        free_datasets(filenames, contents, n);
+        return -4;
+    }
+    double t1 = now_seconds();
+    double build_ms = (t1 - t0) * 1000.0;
+    BenchResult single;
+    bench_single(&single, (uint64_t)((t1 - t0) * 1e9));
+    bench_merge(&bench_totals.build, &single);
+    bench_totals.builds++;
+
+    long mem = (long)merkle_tree_bytes(&tree);
+    char root_hex[2*SHA256_DIGEST_LEN + 1];
+    if (tree.root) hex_digest(tree.root->hash, root_hex);
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "build", build_ms, mem, "ok", tree.root ? root_hex : "no_root");
+
+    /* We keep tree and map live for possible verify/tamper during the same run.
+       The caller may want to tamper/verify using the same tree; so we return the tree by storing
+       it in a file-scoped or caller-managed structure. For our CLI, we'll free at end of function.
+    */
+
+    /* For convenience, print root to stdout */
+    if (tree.root) printf("Run %d build complete: root=%s (time=%.3f ms)\n", run_id, root_hex, build_ms);
+    save_snapshot(csv, run_id, n, seed, &tree, filenames);
+
+    /* Parallel builds: same dataset, each thread count, root must match */
+    for (int t = 0; t < thread_config_count; ++t) {
+        ThreadPool *pool = threadpool_create(thread_configs[t]);
+        if (!pool) continue;
+        MerkleTree ptree = {0};
+        double p0 = now_seconds();
+        int prc = build_leaves_from_arrays_mt(&ptree, (const char**)filenames, (const char**)contents, n, pool);
+        if (prc == 0) prc = build_merkle_tree_mt(&ptree, pool);
+        double p1 = now_seconds();
+        double par_ms = (p1 - p0) * 1000.0;
+
+        int same = prc == 0 && tree.root && ptree.root && memcmp(tree.root->hash, ptree.root->hash, SHA256_DIGEST_LEN) == 0;
+        char details[128];
+        snprintf(details, sizeof(details), "threads=%d;speedup=%.2f",
+                 threadpool_size(pool), par_ms > 0 ? build_ms / par_ms : 0.0);
+        csv_write_row(csv, MODULE_NAME, run_id, n, seed, "build_parallel", par_ms, (long)merkle_tree_bytes(&ptree),
+                      prc != 0 ? "error" : same ? "ok" : "root_mismatch", details);
+        printf("  %d threads: %.3f ms (%s)\n", threadpool_size(pool), par_ms, details);
+
+        free_tree(&ptree);
+        threadpool_free(pool);
+    }
+
+    /* Cleanup */
+    free_tree(&tree);
+    free_datasets(filenames, contents, n);
+    return 0;
+}
+
+/* For runs that require tamper + verify in same run, we provide a function that builds and returns tree + map.
+   But to keep this file small, Person D will typically call --build then invoke --verify separately.
+   Below are simplified verify/tamper helpers that reconstruct the same data (deterministic via seed). */
+
+/* Hit/miss name lookups in one random order: hits are leaf names, misses
+   are leaf contents (never a name); the share of hits is --hit-ratio */
+typedef struct {
+    NameMap *map;
+    const char **keys;
+    MerkleNode **expect;
+    size_t wrong;
+} LookupMix;
+
+static void namemap_get_op(void *ctx, size_t i) {
+    LookupMix *mix = ctx;
+    mix->wrong += namemap_get(mix->map, mix->keys[i]) != mix->expect[i];
+}
+
+static void bench_namemap_mix(NameMap *map, MerkleTree *tree, char **filenames, char **contents,
+                              unsigned int seed) {
+    size_t count = tree->leaf_count;
+    LookupMix mix = { map, malloc(count * sizeof(char*)), malloc(count * sizeof(MerkleNode*)), 0 };
+    if (count && mix.keys && mix.expect) {
+        uint64_t rng = seed;
+        for (size_t i = 0; i < count; ++i) {
+            size_t j = (size_t)(bench_rand(&rng) % count);
+            int hit = bench_chance(&rng, bench_hit_ratio);
+            mix.keys[i] = hit ? filenames[j] : contents[j];
+            mix.expect[i] = hit ? tree->leaves[j] : NULL;
+        }
+        BenchSpec spec = { count, 1, BENCH_LOOKUP_REPS, 1, NULL };
+        BenchResult r;
+        bench_run(&spec, namemap_get_op, &mix, &r);
+        bench_merge(&bench_totals.namemap_get, &r);
+        bench_totals.lookup_reps += BENCH_LOOKUP_REPS;
+        bench_totals.wrong += mix.wrong;
+    }
+    free(mix.keys);
+    free(mix.expect);
+}
+
+/* Verify a named file: builds structure, then measures verify */
+static int run_verify(FILE *csv, int run_id, size_t n, unsigned int seed, const char *target_filename) {
+    char **filenames = NULL, **contents = NULL;
+    int rc = make_datasets("file", n, seed, &filenames, &contents);
+    if (rc != 0) return rc;
+
+    MerkleTree tree = {0};
+
+    if (build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, n) != 0) {
+        free_datasets(filenames, contents, n);
+        return -3;
+    }
+    double i0 = now_seconds();
+    NameMap *map = merkle_name_index(&tree);
+    double i1 = now_seconds();
+    if (!map || build_merkle_tree(&tree)) {
+        free_tree(&tree); free_datasets(filenames, contents, n); namemap_free(map);
+        return -4;
+    }
+
+    /* Name index: every leaf by name, then the same number of misses */
+    size_t found = 0;
+    double l0 = now_seconds();
+    for (size_t i = 0; i < tree.leaf_count; ++i) found += namemap_get(map, filenames[i]) == tree.leaves[i];
+    double l1 = now_seconds();
+    for (size_t i = 0; i < tree.leaf_count; ++i) found += namemap_get(map, contents[i]) != NULL;
+    double l2 = now_seconds();
+    char details[128];
+    long map_bytes = (long)namemap_bytes(map);
+    snprintf(details, sizeof(details), "names=%zu;put_ns=%.1f", namemap_count(map),
+             tree.leaf_count ? (i1 - i0) * 1e9 / tree.leaf_count : 0.0);
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "namemap_put", (i1 - i0)*1000.0, map_bytes,
+                  namemap_count(map) == tree.leaf_count ? "ok" : "error", details);
+    snprintf(details, sizeof(details), "hit_ns=%.1f;miss_ns=%.1f",
+             tree.leaf_count ? (l1 - l0) * 1e9 / tree.leaf_count : 0.0,
+             tree.leaf_count ? (l2 - l1) * 1e9 / tree.leaf_count : 0.0);
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "namemap_get", (l2 - l0)*1000.0, map_bytes,
+                  found == tree.leaf_count ? "ok" : "error", details);
+    if (bench_csv_path[0]) bench_namemap_mix(map, &tree, filenames, contents, seed);
+
+    double t0 = now_seconds();
+    int res = verify_file(map, &tree, target_filename);
+    double t1 = now_seconds();
+    double v_ms = (t1 - t0) * 1000.0;
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "verify", v_ms, (long)merkle_tree_bytes(&tree), (res==1) ? "ok" : (res==0) ? "tampered" : "error", target_filename);
+
+    free_tree(&tree);
+    namemap_free(map);
+    free_datasets(filenames, contents, n);
+    return 0;
+}
+
+/* Verify a named file against a saved snapshot: the snapshot is mapped,
+   not rebuilt; only the dataset is regenerated to obtain the content */
+static int run_verify_snapshot(FILE *csv, int run_id, size_t n, unsigned int seed,
+                               const char *snap_path, const char *target_filename) {
+    char **filenames = NULL, **contents = NULL;
+    int rc = make_datasets("file", n, seed, &filenames, &contents);
+    if (rc != 0) return rc;
+
+    double t0 = now_seconds();
+    Snapshot *snap = snapshot_open(snap_path);
+    double t1 = now_seconds();
+    if (!snap) {
+        csv_write_row(csv, MODULE_NAME, run_id, n, seed, "snapshot_load", (t1 - t0)*1000.0, 0, "error", snap_path);
+        free_datasets(filenames, contents, n);
+        return -3;
+    }
+    long mem = (long)snapshot_bytes(snap);
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "snapshot_load", (t1 - t0)*1000.0, mem, "ok", snap_path);
+
+    /* The content comes from this run's dataset, looked up by name */
+    const char *content = NULL;
+    for (size_t i = 0; i < n && !content; ++i)
+        if (strcmp(filenames[i], target_filename) == 0) content = contents[i];
+
+    double v0 = now_seconds();
+    long leaf = snapshot_find(snap, target_filename);
+    int res = (leaf < 0 || !content) ? -1 : snapshot_verify_leaf(snap, (size_t)leaf, content, strlen(content));
+    double v1 = now_seconds();
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "verify_snapshot", (v1 - v0)*1000.0, mem,
+                  (res==1) ? "ok" : (res==0) ? "tampered" : "error", target_filename);
+
+    snapshot_close(snap);
+    free_datasets(filenames, contents, n);
+    return 0;
+}
+
+typedef struct {
+    size_t kinds[3];      /* indexed by SNAPSHOT_CHANGED/ADDED/REMOVED */
+} DiffCounts;
+
+static void print_diff(const char *name, int kind, void *ctx) {
+    static const char *labels[] = { "changed", "added", "removed" };
+    ((DiffCounts*)ctx)->kinds[kind]++;
+    printf("  %-8s %s\n", labels[kind], name);
+}
+
+/* List files that differ between two snapshots (--diff old new) */
+static int run_diff(FILE *csv, const char *old_path, const char *new_path) {
+    Snapshot *a = snapshot_open(old_path);
+    Snapshot *b = snapshot_open(new_path);
+    if (!a || !b) {
+        fprintf(stderr, "cannot open snapshot %s\n", !a ? old_path : new_path);
+        snapshot_close(a);
+        snapshot_close(b);
+        return -1;
+    }
+    DiffCounts counts = {{0, 0, 0}};
+    double t0 = now_seconds();
+    size_t k = snapshot_diff(a, b, print_diff, &counts);
+    double t1 = now_seconds();
+    char details[128];
+    snprintf(details, sizeof(details), "changed=%zu;added=%zu;removed=%zu",
+             counts.kinds[SNAPSHOT_CHANGED], counts.kinds[SNAPSHOT_ADDED], counts.kinds[SNAPSHOT_REMOVED]);
+    csv_write_row(csv, MODULE_NAME, 0, snapshot_leaf_count(b), 0, "snapshot_diff", (t1 - t0)*1000.0,
+                  (long)(snapshot_bytes(a) + snapshot_bytes(b)), k ? "differs" : "same", details);
+    printf("%zu difference(s): %s\n", k, details);
+    snapshot_close(a);
+    snapshot_close(b);
+    return 0;
+}
+
+/* Proof generation and verification latency over random leaves */
+typedef struct {
+    NameMap *map;
+    MerkleTree *tree;
+    const uint8_t *root;
+    const char **names, **datas;
+    MerkleProof **proofs;
+    size_t wrong;
+} ProofSample;
+
+static void proof_gen_op(void *ctx, size_t i) {
+    ProofSample *ps = ctx;
+    ps->proofs[i] = get_proof(ps->map, ps->tree, ps->names[i]);
+}
+
+static void proof_verify_op(void *ctx, size_t i) {
+    ProofSample *ps = ctx;
+    ps->wrong += !ps->proofs[i] || verify_proof(ps->root, ps->datas[i], ps->proofs[i]) != 1;
+}
+
+static void bench_proof_sample(NameMap *map, MerkleTree *tree, char **filenames, char **contents,
+                               unsigned int seed) {
+    size_t count = tree->leaf_count < BENCH_PROOF_SAMPLES ? tree->leaf_count : BENCH_PROOF_SAMPLES;
+    ProofSample ps = { map, tree, tree->root->hash, malloc(count * sizeof(char*)),
+                       malloc(count * sizeof(char*)), calloc(count, sizeof(MerkleProof*)), 0 };
+    if (count && ps.names && ps.datas && ps.proofs) {
+        uint64_t rng = seed;
+        for (size_t i = 0; i < count; ++i) {
+            size_t j = (size_t)(bench_rand(&rng) % tree->leaf_count);
+            ps.names[i] = filenames[j];
+            ps.datas[i] = contents[j];
+        }
+        /* one pass keeps the proofs for the verify workload */
+        BenchSpec gen = { count, 0, 1, 1, NULL };
+        BenchSpec ver = { count, 1, BENCH_LOOKUP_REPS, 1, NULL };
+        BenchResult r;
+        bench_run(&gen, proof_gen_op, &ps, &r);
+        bench_merge(&bench_totals.proof_gen, &r);
+        bench_run(&ver, proof_verify_op, &ps, &r);
+        bench_merge(&bench_totals.proof_verify, &r);
+        bench_totals.proof_reps++;
+        bench_totals.wrong += ps.wrong;
+        for (size_t i = 0; i < count; ++i) free_proof(ps.proofs[i]);
+    }
+    free(ps.names);
+    free(ps.datas);
+    free(ps.proofs);
+}
+
+/* Inclusion proofs: size and verify time for one leaf and for k leaves */
+static int run_proofs(FILE *csv, int run_id, size_t n, unsigned int seed, size_t k) {
+    if (n == 0) return -1;
+    char **filenames = NULL, **contents = NULL;
+    int rc = make_datasets("file", n, seed, &filenames, &contents);
+    if (rc != 0) return rc;
+
+    MerkleTree tree = {0};
+
+    if (build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, n) != 0) {
+        free_datasets(filenames, contents, n); return -3;
+    }
+    NameMap *map = merkle_name_index(&tree);
+    if (!map || build_merkle_tree(&tree) || !tree.root) {
+        free_tree(&tree); free_datasets(filenames, contents, n); namemap_free(map); return -4;
+    }
+    const uint8_t *root = tree.root->hash;
+    char details[128];
+
+    /* Single proof for the middle leaf; a wrong content must be rejected */
+    size_t mid = n / 2;
+    double t0 = now_seconds();
+    MerkleProof *proof = get_proof(map, &tree, filenames[mid]);
+    double t1 = now_seconds();
+    int ok = proof ? verify_proof(root, contents[mid], proof) : -1;
+    double t2 = now_seconds();
+    int forged = proof ? verify_proof(root, "forged content", proof) : -1;
+    size_t single_bytes = proof ? proof_size_bytes(proof) : 0;
+    snprintf(details, sizeof(details), "%s;bytes=%zu", filenames[mid], single_bytes);
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "proof_gen", (t1 - t0)*1000.0, (long)single_bytes,
+                  proof ? "ok" : "error", details);
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "proof_verify", (t2 - t1)*1000.0, (long)single_bytes,
+                  (ok == 1 && forged == 0) ? "ok" : "error", details);
+    free_proof(proof);
+
+    if (bench_csv_path[0]) bench_proof_sample(map, &tree, filenames, contents, seed);
+
+    /* Multi-proof over k leaves spread across the tree vs k single proofs */
+    if (k > n) k = n;
+    if (k > 0) {
+        const char **names = malloc(k * sizeof(char*));
+        const char **datas = malloc(k * sizeof(char*));
+        if (names && datas) {
+            for (size_t j = 0; j < k; ++j) {
+                names[j] = filenames[j * n / k];
+                datas[j] = contents[j * n / k];
+            }
+            double m0 = now_seconds();
+            MerkleMultiProof *mp = get_multiproof(map, &tree, names, k);
+            double m1 = now_seconds();
+            int mok = mp ? verify_multiproof(root, datas, k, mp) : -1;
+            double m2 = now_seconds();
+            /* one wrong content among the k must sink the whole proof */
+            const char *kept = datas[k / 2];
+            datas[k / 2] = "forged content";
+            int mforged = mp ? verify_multiproof(root, datas, k, mp) : -1;
+            datas[k / 2] = kept;
+            size_t multi_bytes = mp ? multiproof_size_bytes(mp) : 0;
+            snprintf(details, sizeof(details), "k=%zu;bytes=%zu;single_bytes_total=%zu",
+                     k, multi_bytes, k * single_bytes);
+            csv_write_row(csv, MODULE_NAME, run_id, n, seed, "multiproof_gen", (m1 - m0)*1000.0, (long)multi_bytes,
+                          mp ? "ok" : "error", details);
+            csv_write_row(csv, MODULE_NAME, run_id, n, seed, "multiproof_verify", (m2 - m1)*1000.0, (long)multi_bytes,
+                          (mok == 1 && mforged == 0) ? "ok" : "error", details);
+            free_multiproof(mp);
+        }
+        free(names);
+        free(datas);
+    }
+
+    free_tree(&tree);
+    namemap_free(map);
+    free_datasets(filenames, contents, n);
+    return 0;
+}
+
+/* Multi-buffer SHA-256 vs one OpenSSL call per message, for leaf contents
+   and for 64-byte interior messages (two concatenated child digests) */
+static int run_hash_bench(FILE *csv, int run_id, size_t n, unsigned int seed) {
+    if (n == 0) return -1;
+    char **filenames = NULL, **contents = NULL;
+    int rc = make_datasets("file", n, seed, &filenames, &contents);
+    if (rc != 0) return rc;
+
+    size_t pairs = n / 2;
+    const uint8_t **msgs = malloc(n * sizeof(uint8_t*));
+    size_t *lens = malloc(n * sizeof(size_t));
+    uint8_t (*ref)[SHA256_DIGEST_LEN] = malloc(n * SHA256_DIGEST_LEN);
+    uint8_t (*out)[SHA256_DIGEST_LEN] = malloc(n * SHA256_DIGEST_LEN);
+    if (!msgs || !lens || !ref || !out) {
+        free(msgs); free(lens); free(ref); free(out);
+        free_datasets(filenames, contents, n);
+        return -2;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i) {
+        msgs[i] = (const uint8_t*)contents[i];
+        lens[i] = strlen(contents[i]);
+        total += lens[i];
+    }
+
+    static const int kernels[] = { 1, 4, 8, 16 };
+    char details[128];
+    for (int pass = 0; pass < 2; ++pass) {
+        /* pass 0: leaf contents; pass 1: pairs of the leaf digests left in out[]
+           by pass 0 (the scalar kernel always runs, so out[] is filled) */
+        size_t count = pass == 0 ? n : pairs;
+        const char *name_ref = pass == 0 ? "hash_openssl" : "pair_hash_openssl";
+        const char *name_mb = pass == 0 ? "hash_multibuffer" : "pair_hash_multibuffer";
+        uint8_t (*pair_buf)[2 * SHA256_DIGEST_LEN] = NULL;
+        if (pass == 1) {
+            if (count == 0) break;
+            pair_buf = malloc(count * sizeof(*pair_buf));
+            if (!pair_buf) break;
+            for (size_t i = 0; i < count; ++i) {
+                memcpy(pair_buf[i], out[2*i], SHA256_DIGEST_LEN);
+                memcpy(pair_buf[i] + SHA256_DIGEST_LEN, out[2*i + 1], SHA256_DIGEST_LEN);
+                msgs[i] = pair_buf[i];
+                lens[i] = sizeof(pair_buf[i]);
+            }
+            total = count * sizeof(pair_buf[0]);
+        }
+
+        double t0 = now_seconds();
+        for (size_t i = 0; i < count; ++i) SHA256(msgs[i], lens[i], ref[i]);
+        double ref_ms = (now_seconds() - t0) * 1000.0;
+        snprintf(details, sizeof(details), "impl=openssl;lanes=1;MBps=%.1f",
+                 ref_ms > 0 ? total / (ref_ms * 1000.0) : 0.0);
+        csv_write_row(csv, MODULE_NAME, run_id, count, seed, name_ref, ref_ms, (long)total, "ok", details);
+
+        /* Every kernel this CPU can run; sha256_mb_select() falls back to
+           the widest available one, so skip lane counts it rejects */
+        for (size_t k = 0; k < sizeof(kernels)/sizeof(kernels[0]); ++k) {
+            if (sha256_mb_select(kernels[k]) != kernels[k]) continue;
+            double m0 = now_seconds();
+            sha256_mb_hash(msgs, lens, out, count);
+            double mb_ms = (now_seconds() - m0) * 1000.0;
+            int same = memcmp(ref, out, count * SHA256_DIGEST_LEN) == 0;
+            snprintf(details, sizeof(details), "impl=%s;lanes=%d;MBps=%.1f;speedup=%.2f",
+                     sha256_mb_impl_name(), sha256_mb_lanes(),
+                     mb_ms > 0 ? total / (mb_ms * 1000.0) : 0.0, mb_ms > 0 ? ref_ms / mb_ms : 0.0);
+            csv_write_row(csv, MODULE_NAME, run_id, count, seed, name_mb, mb_ms, (long)total,
+                          same ? "ok" : "mismatch", details);
+            printf("  %s %s: %.3f ms (%s)\n", name_mb, sha256_mb_impl_name(), mb_ms, same ? "ok" : "MISMATCH");
+        }
+        sha256_mb_select(0);
+        free(pair_buf);
+    }
+
+    free(msgs); free(lens); free(ref); free(out);
+    free_datasets(filenames, contents, n);
+    return 0;
+}
+
+/* Tree over real files (--dir): scan once, stream-hash every file with
+   bounded memory, sequentially and at each --threads count, then build */
+static int run_dir_build(FILE *csv, int run_id, unsigned int seed, const char *dir, size_t chunk_size) {
+    LeafList list;
+    double s0 = now_seconds();
+    if (leaf_scan_dir(dir, &list) != 0) return -1;
+    double s1 = now_seconds();
+    size_t n = list.count;
+    char details[160];
+    snprintf(details, sizeof(details), "%.96s;files=%zu", dir, n);   /* long paths are cut in the CSV */
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "dir_scan", (s1 - s0)*1000.0, 0, "ok", details);
+
+    uint8_t (*digests)[SHA256_DIGEST_LEN] = malloc((n ? n : 1) * SHA256_DIGEST_LEN);
+    uint8_t (*par)[SHA256_DIGEST_LEN] = malloc((n ? n : 1) * SHA256_DIGEST_LEN);
+    if (!digests || !par) { free(digests); free(par); leaf_list_free(&list); return -2; }
+
+    /* Sequential baseline; memory is one read buffer, not the file contents */
+    uint64_t bytes = 0;
+    double h0 = now_seconds();
+    size_t failed = leaf_hash_all(&list, chunk_size, NULL, digests, &bytes);
+    double h1 = now_seconds();
+    double seq_ms = (h1 - h0) * 1000.0;
+    snprintf(details, sizeof(details), "threads=1;chunk=%zu;bytes=%llu;MBps=%.1f;unreadable=%zu",
+             chunk_size, (unsigned long long)bytes, seq_ms > 0 ? bytes / (seq_ms * 1000.0) : 0.0, failed);
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "leaf_stream_hash", seq_ms, (long)LEAF_READ_BLOCK,
+                  failed ? "error" : "ok", details);
+
+    for (int t = 0; t < thread_config_count; ++t) {
+        ThreadPool *pool = threadpool_create(thread_configs[t]);
+        if (!pool) continue;
+        double p0 = now_seconds();
+        size_t pfailed = leaf_hash_all(&list, chunk_size, pool, par, NULL);
+        double p1 = now_seconds();
+        double par_ms = (p1 - p0) * 1000.0;
+        int same = n == 0 || memcmp(par, digests, n * SHA256_DIGEST_LEN) == 0;
+        snprintf(details, sizeof(details), "threads=%d;chunk=%zu;MBps=%.1f;speedup=%.2f",
+                 threadpool_size(pool), chunk_size,
+                 par_ms > 0 ? bytes / (par_ms * 1000.0) : 0.0, par_ms > 0 ? seq_ms / par_ms : 0.0);
+        csv_write_row(csv, MODULE_NAME, run_id, n, seed, "leaf_stream_hash", par_ms,
+                      (long)LEAF_READ_BLOCK * threadpool_size(pool),
+                      pfailed ? "error" : same ? "ok" : "digest_mismatch", details);
+        threadpool_free(pool);
+    }
+
+    MerkleTree tree = {0};
+    double b0 = now_seconds();
+    int rc = build_leaves_from_digests(&tree, (const char**)list.paths,
+                                       (const uint8_t (*)[SHA256_DIGEST_LEN])digests, n);
+    if (rc == 0) rc = build_merkle_tree(&tree);
+    double b1 = now_seconds();
+    char root_hex[2*SHA256_DIGEST_LEN + 1] = "no_root";
+    if (rc == 0 && tree.root) hex_digest(tree.root->hash, root_hex);
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "build_from_dir", (b1 - b0)*1000.0,
+                  rc == 0 ? (long)merkle_tree_bytes(&tree) : 0, rc == 0 ? "ok" : "error", root_hex);
+    if (rc == 0) {
+        printf("Run %d dir build: %zu files, %llu bytes, root=%s\n", run_id, n, (unsigned long long)bytes, root_hex);
+        save_snapshot(csv, run_id, n, seed, &tree, list.paths);
+    }
+
+    free_tree(&tree);
+    free(digests);
+    free(par);
+    leaf_list_free(&list);
+    return rc == 0 ? 0 : -3;
+}
+
+/* Tamper a named file and measure verify post-tamper: */
+static int run_tamper_and_verify(FILE *csv, int run_id, size_t n, unsigned int seed,
+                                const char *target_filename, const char *new_content) {
+    /* Build deterministic dataset and map */
+    char **filenames = NULL, **contents = NULL;
+    int rc = make_datasets("file", n, seed, &filenames, &contents);
+    if (rc != 0) return rc;
+
+    MerkleTree tree = {0};
+
+    if (build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, n) != 0) {
+        free_datasets(filenames, contents, n); return -3;
+    }
+    NameMap *map = merkle_name_index(&tree);
+    if (!map || build_merkle_tree(&tree)) {
+        free_tree(&tree); free_datasets(filenames, contents, n); namemap_free(map); return -4;
+    }
+
+    long mem = (long)merkle_tree_bytes(&tree);
+
+    /* Verify before tamper */
+    double t0 = now_seconds();
+    int res_before = verify_file(map, &tree, target_filename);
+    double t1 = now_seconds();
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "verify_before_tamper", (t1 - t0)*1000.0, mem,
+                  (res_before==1) ? "ok" : (res_before==0) ? "tampered" : "error", target_filename);
+
+    /* Tamper (should change only data) */
+    tamper_file(map, &tree, target_filename, new_content);
+
+
+    /* Verify after tamper */
+    double t2 = now_seconds();
+    int res_after = verify_file(map, &tree, target_filename);
+    double t3 = now_seconds();
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "verify_after_tamper", (t3 - t2)*1000.0, mem,
+                  (res_after==1) ? "ok" : (res_after==0) ? "tampered" : "error", target_filename);
+
+    /* Incremental update: rehash only the tampered leaf and its ancestors */
+    uint8_t inc_root[SHA256_DIGEST_LEN] = {0};
+    MerkleNode *leaf = namemap_get(map, target_filename);
+    double u0 = now_seconds();
+    int urc = leaf ? merkle_update_leaf(&tree, leaf) : -1;
+    double u1 = now_seconds();
+    if (urc == 0 && tree.root) memcpy(inc_root, tree.root->hash, SHA256_DIGEST_LEN);
+
+    /* Optionally rebuild and record rebuild time */
+    double t4 = now_seconds();
+    build_merkle_tree(&tree);
+    double t5 = now_seconds();
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "rebuild_after_tamper", (t5 - t4)*1000.0, mem, "ok", "rebuild");
+    save_snapshot(csv, run_id, n, seed, &tree, filenames);
+
+    /* The incremental root must equal the full rebuild's root */
+    csv_write_row(csv, MODULE_NAME, run_id, n, seed, "incremental_update", (u1 - u0)*1000.0, mem,
+                  urc != 0 ? "error" : (tree.root && memcmp(inc_root, tree.root->hash, SHA256_DIGEST_LEN) == 0) ? "ok" : "root_mismatch",
+                  target_filename);
+
+    /* Batched: tamper k leaves spread across the tree, update them together */
+    if (batch_k > 0) {
+        size_t k = (size_t)batch_k < tree.leaf_count ? (size_t)batch_k : tree.leaf_count;
+        MerkleNode **changed = malloc(k * sizeof(MerkleNode*));
+        if (changed) {
+            for (size_t j = 0; j < k; ++j) {
+                changed[j] = tree.leaves[j * tree.leaf_count / k];
+                tamper_file(map, &tree, changed[j]->filename, new_content);
+            }
+            double b0 = now_seconds();
+            int brc = merkle_update_leaves(&tree, changed, k);
+            double b1 = now_seconds();
+            uint8_t batch_root[SHA256_DIGEST_LEN] = {0};
+            if (brc == 0 && tree.root) memcpy(batch_root, tree.root->hash, SHA256_DIGEST_LEN);
+
+            double b2 = now_seconds();
+            build_merkle_tree(&tree);
+            double b3 = now_seconds();
+
+            char details[64];
+            snprintf(details, sizeof(details), "k=%zu", k);
+            csv_write_row(csv, MODULE_NAME, run_id, n, seed, "incremental_update_batch", (b1 - b0)*1000.0, mem,
+                          brc != 0 ? "error" : (tree.root && memcmp(batch_root, tree.root->hash, SHA256_DIGEST_LEN) == 0) ? "ok" : "root_mismatch",
+                          details);
+            csv_write_row(csv, MODULE_NAME, run_id, n, seed, "rebuild_after_batch_tamper", (b3 - b2)*1000.0, mem, "ok", details);
+            free(changed);
+        }
+    }
+
+    /* Cleanup */
+    free_tree(&tree);
+    namemap_free(map);
+    free_datasets(filenames, contents, n);
+    return 0;
+}
+
+/* Append every leaf to the frontier accumulator, publishing the root after
+   each append, first without and then with a node log; check the final
+   root against the batch tree and prove the half-size tree a prefix */
+#define STREAM_PREFIX_MAX 256
+
+/* Prefix sizes worth a batch comparison: all up to 64, where every odd
+   case shows up, then 2^k - 1, 2^k and 2^k + 1, where the frontier
+   collapses, and n - 1 */
+static size_t stream_prefix_sizes(size_t n, size_t *sizes) {
+    size_t count = 0;
+    for (size_t m = 1; m <= n && m <= 64; ++m) sizes[count++] = m;
+    for (size_t p = 128; p / 2 < n && count + 3 < STREAM_PREFIX_MAX; p *= 2) {
+        for (size_t m = p - 1; m <= p + 1; ++m)
+            if (m <= n) sizes[count++] = m;
+    }
+    if (n > 65 && count < STREAM_PREFIX_MAX) sizes[count++] = n - 1;
+    return count;
+}
+
+/* Root of build_merkle_tree() over the first m leaves */
+static int batch_prefix_root(char **filenames, char **contents, size_t m, uint8_t root[SHA256_DIGEST_LEN]) {
+    MerkleTree tree = {0};
+    int rc = build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, m);
+    if (rc == 0) rc = build_merkle_tree(&tree);
+    if (rc == 0) memcpy(root, tree.root->hash, SHA256_DIGEST_LEN);
+    free_tree(&tree);
+    return rc;
+}
+
+static int run_stream(FILE *csv, int run_id, size_t n, unsigned int seed) {
+    char **filenames = NULL, **contents = NULL;
+    int rc = make_datasets("file", n, seed, &filenames, &contents);
+    if (rc != 0) return rc;
+
+    MerkleTree tree = {0};
+    uint8_t batch_root[SHA256_DIGEST_LEN] = {0};
+    int have_batch = build_leaves_from_arrays(&tree, (const char**)filenames, (const char**)contents, n) == 0 &&
+                     build_merkle_tree(&tree) == 0 && tree.root;
+    if (have_batch) memcpy(batch_root, tree.root->hash, SHA256_DIGEST_LEN);
+    free_tree(&tree);
+
+    FILE *log = tmpfile();
+    uint8_t root[SHA256_DIGEST_LEN];
+    char root_hex[2*SHA256_DIGEST_LEN + 1], details[160];
+    for (int logged = 0; logged <= 1; ++logged) {
+        if (logged && !log) break;
+        MerkleStream ms;
+        merkle_stream_init(&ms, merkle_odd_rule(), logged ? log : NULL);
+        int arc = 0;
+        double t0 = now_seconds();
+        for (size_t i = 0; i < n; ++i) {
+            arc |= merkle_stream_append(&ms, contents[i], strlen(contents[i]));
+            merkle_stream_root(&ms, root);
+        }
+        double t1 = now_seconds();
+        double ms_total = (t1 - t0) * 1000.0;
+        const char *result = arc != 0 || !have_batch ? "error"
+                           : memcmp(root, batch_root, SHA256_DIGEST_LEN) == 0 ? "ok" : "root_mismatch";
+        snprintf(details, sizeof(details), "appends_per_sec=%.0f;root=%s",
+                 ms_total > 0 ? n / (ms_total / 1000.0) : 0.0, hex_digest(root, root_hex));
+        csv_write_row(csv, MODULE_NAME, run_id, n, seed, logged ? "stream_append_logged" : "stream_append",
+                      ms_total, (long)sizeof(MerkleStream), result, details);
+        printf("Run %d stream%s: %zu appends in %.3f ms, root %s\n", run_id, logged ? " (logged)" : "",
+               n, ms_total, result);
+        if (!logged || arc != 0 || n == 0) continue;
+
+        /* Consistency proof from half the leaves to all of them */
+        uint64_t old_size = n / 2 ? n / 2 : 1;
+        uint8_t old_root[SHA256_DIGEST_LEN];
+        MerkleConsistencyProof proof;
+        double p0 = now_seconds();
+        int prc = merkle_stream_root_at(&ms, old_size, old_root);
+        if (prc == 0) prc = merkle_stream_consistency(&ms, old_size, n, &proof);
+        double p1 = now_seconds();
+        int valid = prc == 0 && merkle_consistency_verify(old_root, root, &proof, merkle_odd_rule()) == 1;
+        double p2 = now_seconds();
+        snprintf(details, sizeof(details), "old=%llu;new=%zu;digests=%zu;verify_ms=%.6f",
+                 (unsigned long long)old_size, n, prc == 0 ? proof.count : 0, (p2 - p1) * 1000.0);
+        csv_write_row(csv, MODULE_NAME, run_id, n, seed, "stream_consistency", (p1 - p0) * 1000.0,
+                      prc == 0 ? (long)(proof.count * SHA256_DIGEST_LEN) : 0,
+                      prc != 0 ? "error" : valid ? "ok" : "invalid", details);
+
+        /* The accumulator must reproduce the batch tree of every prefix,
+           not only of all n leaves */
+        size_t sizes[STREAM_PREFIX_MAX], mismatched = 0, errors = 0, first_bad = 0;
+        size_t checked = stream_prefix_sizes(n, sizes);
+        double c0 = now_seconds();
+        for (size_t i = 0; i < checked; ++i) {
+            uint8_t stream_at[SHA256_DIGEST_LEN], batch_at[SHA256_DIGEST_LEN];
+            if (merkle_stream_root_at(&ms, sizes[i], stream_at) != 0 ||
+                batch_prefix_root(filenames, contents, sizes[i], batch_at) != 0) { errors++; continue; }
+            if (memcmp(stream_at, batch_at, SHA256_DIGEST_LEN) != 0 && mismatched++ == 0) first_bad = sizes[i];
+        }
+        double c1 = now_seconds();
+        snprintf(details, sizeof(details), "prefixes=%zu;mismatched=%zu;first_bad=%zu", checked, mismatched, first_bad);
+        csv_write_row(csv, MODULE_NAME, run_id, n, seed, "stream_prefix_roots", (c1 - c0) * 1000.0, 0,
+                      errors ? "error" : mismatched ? "root_mismatch" : "ok", details);
+    }
+    if (log) fclose(log);
+    free_datasets(filenames, contents, n);
+    return 0;
+}
+
+/* Write the rows collected for --bench-csv */
+static void write_bench_csv(size_t n, unsigned int seed) {
+    FILE *f = fopen(bench_csv_path, "w");
+    if (!f) { perror("fopen"); return; }
+    char params[96];
+    snprintf(params, sizeof(params), "hit_ratio=%.2f;seed=%u", bench_hit_ratio, seed);
+    const char *result = bench_totals.wrong ? "error" : "ok";
+    bench_csv_header(f);
+    if (bench_totals.build.ops)
+        bench_csv_row(f, MODULE_NAME, "build", n, params, bench_totals.builds, &bench_totals.build, "ok");
+    if (bench_totals.namemap_get.ops)
+        bench_csv_row(f, MODULE_NAME, "namemap_get", n, params, bench_totals.lookup_reps,
+                      &bench_totals.namemap_get, result);
+    if (bench_totals.proof_gen.ops) {
+        bench_csv_row(f, MODULE_NAME, "proof_gen", n, params, bench_totals.proof_reps,
+                      &bench_totals.proof_gen, result);
+        bench_csv_row(f, MODULE_NAME, "proof_verify", n, params, bench_totals.proof_reps * BENCH_LOOKUP_REPS,
+                      &bench_totals.proof_verify, result);
+    }
+    fclose(f);
+    printf("Benchmark rows written to %s\n", bench_csv_path);
+}
+
+/* Simple CLI arg parsing (naive) */
+int main(int argc, char **argv) {
+    size_t n = DEFAULT_N;
+    int runs = DEFAULT_RUNS;
+    unsigned int seed = 42;
+    char csv_path[512] = "output_merkle.csv";
+    int do_build = 0, do_verify = 0, do_tamper = 0, do_proof = 0, do_hash = 0, do_stream = 0;
+    size_t proof_k = 0;
+    char verify_target[256] = {0};
+    char load_snap[512] = {0}, diff_old[512] = {0}, diff_new[512] = {0};
+    char leaf_dir[512] = {0};
+    size_t chunk_size = 0;
+    char tamper_target[256] = {0}, tamper_content[512] = {0};
+
+    /* parse arguments */
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--build") == 0 && i+1 < argc) { n = (size_t)atoi(argv[++i]); do_build = 1; }
+        else if (strcmp(argv[i], "--runs") == 0 && i+1 < argc) { runs = atoi(argv[++i]); }
+        else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) { seed = (unsigned int)atoi(argv[++i]); }
+        else if (strcmp(argv[i], "--csv") == 0 && i+1 < argc) { strncpy(csv_path, argv[++i], sizeof(csv_path)-1); }
+        else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) { parse_thread_list(argv[++i]); }
+        else if (strcmp(argv[i], "--batch") == 0 && i+1 < argc) { batch_k = atoi(argv[++i]); }
+        else if (strcmp(argv[i], "--proof") == 0 && i+1 < argc) { proof_k = (size_t)atoi(argv[++i]); do_proof = 1; }
+        else if (strcmp(argv[i], "--hash-bench") == 0) { do_hash = 1; }
+        else if (strcmp(argv[i], "--stream") == 0) { do_stream = 1; }
+        else if (strcmp(argv[i], "--generate") == 0) { gen_names = 1; }
+        else if (strcmp(argv[i], "--bench-csv") == 0 && i+1 < argc) { strncpy(bench_csv_path, argv[++i], sizeof(bench_csv_path)-1); }
+        else if (strcmp(argv[i], "--hit-ratio") == 0 && i+1 < argc) { bench_hit_ratio = atof(argv[++i]); }
+        else if (strcmp(argv[i], "--save-snap") == 0 && i+1 < argc) { strncpy(snap_save_path, argv[++i], sizeof(snap_save_path)-1); }
+        else if (strcmp(argv[i], "--dir") == 0 && i+1 < argc) { strncpy(leaf_dir, argv[++i], sizeof(leaf_dir)-1); }
+        else if (strcmp(argv[i], "--chunk") == 0 && i+1 < argc) { chunk_size = (size_t)strtoull(argv[++i], NULL, 10); }
+        else if (strcmp(argv[i], "--load-snap") == 0 && i+1 < argc) { strncpy(load_snap, argv[++i], sizeof(load_snap)-1); }
+        else if (strcmp(argv[i], "--diff") == 0 && i+2 < argc) { strncpy(diff_old, argv[++i], sizeof(diff_old)-1); strncpy(diff_new, argv[++i], sizeof(diff_new)-1); }
+        else if (strcmp(argv[i], "--verify") == 0 && i+1 < argc) { strncpy(verify_target, argv[++i], sizeof(verify_target)-1); do_verify = 1; }
+        else if (strcmp(argv[i], "--tamper") == 0 && i+2 < argc) { strncpy(tamper_target, argv[++i], sizeof(tamper_target)-1); strncpy(tamper_content, argv[++i], sizeof(tamper_content)-1); do_tamper = 1; }
+        else if (strcmp(argv[i], "--help") == 0) {
+            printf("Usage: %s [--build N] [--runs R] [--seed S] [--verify filename] [--tamper filename newcontent] [--threads 1,2,4,8] [--batch K] [--proof K] [--hash-bench] [--stream] [--generate] [--bench-csv file] [--hit-ratio R] [--save-snap file] [--load-snap file] [--diff old.snap new.snap] [--dir path] [--chunk bytes] [--csv out.csv]\n", argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown arg: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    /* --load-snap replaces the rebuild; --build then only supplies N */
+    if (load_snap[0]) do_build = 0;
+
+    FILE *csv = fopen(csv_path, "w");
+    if (!csv) { perror("fopen"); return 1; }
+    /* CSV header */
+    fprintf(csv, "module,run_id,n,seed,op,op_time_ms,memory_bytes,result,details\n");
+
+    if (diff_old[0]) {
+        int rc = run_diff(csv, diff_old, diff_new);
+        if (rc != 0) fprintf(stderr, "run_diff failed (rc=%d)\n", rc);
+    }
+
+    /* For each run: call requested ops */
+    for (int run = 1; run <= runs; ++run) {
+        unsigned int this_seed = seed + (unsigned int)run; /* vary seed per run for variability but deterministic */
+        if (do_build) {
+            int rc = run_one_build(csv, run, n, this_seed, NULL);
+            if (rc != 0) fprintf(stderr, "run_one_build failed (rc=%d)\n", rc);
+        }
+        if (do_verify && load_snap[0]) {
+            /* with --load-snap, verify against the saved tree instead of rebuilding */
+            int rc = run_verify_snapshot(csv, run, n, this_seed, load_snap, verify_target);
+            if (rc != 0) fprintf(stderr, "run_verify_snapshot failed (rc=%d)\n", rc);
+        } else if (do_verify) {
+            int rc = run_verify(csv, run, n, this_seed, verify_target);
+            if (rc != 0) fprintf(stderr, "run_verify failed (rc=%d)\n", rc);
+        }
+        if (do_tamper) {
+            int rc = run_tamper_and_verify(csv, run, n, this_seed, tamper_target, tamper_content);
+            if (rc != 0) fprintf(stderr, "run_tamper_and_verify failed (rc=%d)\n", rc);
+        }
+        if (do_proof) {
+            int rc = run_proofs(csv, run, n, this_seed, proof_k);
+            if (rc != 0) fprintf(stderr, "run_proofs failed (rc=%d)\n", rc);
+        }
+        if (leaf_dir[0]) {
+            int rc = run_dir_build(csv, run, this_seed, leaf_dir, chunk_size);
+            if (rc != 0) fprintf(stderr, "run_dir_build failed (rc=%d)\n", rc);
+        }
+        if (do_hash) {
+            int rc = run_hash_bench(csv, run, n, this_seed);
+            if (rc != 0) fprintf(stderr, "run_hash_bench failed (rc=%d)\n", rc);
+        }
+        if (do_stream) {
+            int rc = run_stream(csv, run, n, this_seed);
+            if (rc != 0) fprintf(stderr, "run_stream failed (rc=%d)\n", rc);
+        }
+    }
+
+    fclose(csv);
+    printf("Results written to %s\n", csv_path);
+    if (bench_csv_path[0]) write_bench_csv(n, seed);
+    return 0;
+}
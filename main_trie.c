@@ -1,59 +1,749 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <windows.h>   // for high-precision timing
-#include "trie.h"
-
-int main(int argc, char *argv[]) {
-    TrieNode *root = createNode();
-
-    FILE *fp = fopen("sample_files/sample.txt", "r");
-    if (!fp) {
-        printf("Error: could not open sample_files/sample.txt\n");
-        return 1;
-    }
-
-    char word[256];
-
-    // ---------- Build timing ----------
-    LARGE_INTEGER freq, start, end;
-    QueryPerformanceFrequency(&freq);
-    QueryPerformanceCounter(&start);
-
-    while (fscanf(fp, "%s", word) != EOF)
-        insertFile(root, word);
-
-    QueryPerformanceCounter(&end);
-    double build_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
-    fclose(fp);
-
-    // ---------- Search feature ----------
-    if (argc == 3 && strcmp(argv[1], "--search") == 0) {
-        const char *query = argv[2];
-        printf("Searching for '%s'...\n", query);
-        if (searchFile(root, query))
-            printf("Result: Found\n");
-        else
-            printf("Result: Not Found\n");
-    }
-
-    // ---------- 1000 lookups timing ----------
-    QueryPerformanceCounter(&start);
-    for (int i = 0; i < 1000; i++)
-        searchFile(root, "dummy.txt");
-    QueryPerformanceCounter(&end);
-    double search_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
-
-    // ---------- Save results ----------
-    system("if not exist results mkdir results");
-    FILE *csv = fopen("results/output_trie.csv", "w");
-    fprintf(csv, "BuildTime(s),SearchTime(s)\n%.6f,%.6f\n", build_time, search_time);
-    fclose(csv);
-
-    printf("\nBuild time: %.6f s\n", build_time);
-    printf("Search time (1000 lookups): %.6f s\n", search_time);
-    printf("Results saved in results/output_trie.csv\n");
-
-    freeTrie(root);
-    return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "trie.h"
+#include "trie_index.h"
+#include "trie_bulk.h"
+#include "bench.h"
+#include "nsgen.h"
+#include "trie_rcu.h"
+
+#define MODULE_NAME "trie"
+#define DEFAULT_LOOKUPS 1000
+#define DEFAULT_REPS 5
+#define DEFAULT_WARMUP 1
+#define DEFAULT_HIT_RATIO 0.5
+#define DEFAULT_BATCH 64         // paths per searchFileBatch() call
+#define MISS_SUFFIX ".missing"   // appended to a real path to make a miss
+#define DEFAULT_PAGE 20
+#define MAX_THREAD_CONFIGS 16
+#define WRITER_BACKLOG 64         // paths the writer keeps inserted before removing
+
+// Workload knobs shared by the build and index modes
+typedef struct {
+    const char *inputPath;
+    size_t generate;      // > 0: paths come from nsgen instead of inputPath
+    size_t lookups;
+    int reps;
+    int warmup;
+    double hitRatio;
+    unsigned long long seed;
+    size_t batch;         // paths per batched lookup
+} BenchConfig;
+
+// Lookup workload: real paths sampled from the input, some turned into misses
+typedef struct {
+    char **keys;
+    int *expect;          // 1 = key is stored
+    size_t count;
+    size_t seen;          // input lines seen while sampling
+    double avgDepth;      // '/'-separated components per key
+    uint64_t rng;
+    TrieNode *root;
+    TrieIndex *index;
+    size_t wrong;         // lookups that disagreed with expect[]
+    size_t batch;
+    uint64_t *found;      // searchFileBatch() result bitmap
+} Workload;
+
+// Hand every input path to fn: lines of the input file, or the generated
+// namespace, regenerated from the seed on each call
+static int forEachPath(const BenchConfig *cfg, int (*fn)(char *line, size_t len, void *ctx),
+                       void *ctx, size_t *bytesRead) {
+    if (!cfg->generate)
+        return trieBulkForEachLine(cfg->inputPath, fn, ctx, bytesRead);
+    NsGenConfig gc;
+    nsgen_defaults(&gc, cfg->seed, cfg->generate);
+    NsGen *gen = nsgen_create(&gc);
+    if (!gen) return -1;
+    char line[NSGEN_MAX_PATH];
+    const char *path;
+    size_t len, total = 0;
+    int rc = 0;
+    while (rc == 0 && (path = nsgen_next(gen, &len)) != NULL) {
+        memcpy(line, path, len + 1);
+        total += len + 1;
+        rc = fn(line, len, ctx);
+    }
+    if (nsgen_emitted(gen) != cfg->generate) rc = -1;
+    nsgen_free(gen);
+    if (bytesRead) *bytesRead = total;
+    return rc;
+}
+
+typedef struct {
+    TrieNode *root;
+    TrieLoadStats *stats;
+} GenLoad;
+
+static int insertGenerated(char *line, size_t len, void *ctx) {
+    GenLoad *load = (GenLoad*)ctx;
+    if (insertFile(load->root, line) != 0) return -1;
+    load->stats->paths++;
+    if (len > load->stats->longestPath) load->stats->longestPath = len;
+    return 0;
+}
+
+// Reservoir-sample 'count' input lines (uniform, bounded memory)
+static int sampleLine(char *line, size_t len, void *ctx) {
+    Workload *w = (Workload*)ctx;
+    size_t slot = w->seen < w->count ? w->seen : (size_t)(bench_rand(&w->rng) % (w->seen + 1));
+    w->seen++;
+    if (slot >= w->count) return 0;
+    char *copy = (char*)malloc(len + 1);
+    if (!copy) return -1;
+    memcpy(copy, line, len + 1);
+    free(w->keys[slot]);
+    w->keys[slot] = copy;
+    return 0;
+}
+
+static void freeWorkload(Workload *w) {
+    if (w->keys)
+        for (size_t i = 0; i < w->count; i++) free(w->keys[i]);
+    free(w->keys);
+    free(w->expect);
+    free(w->found);
+}
+
+// Draw cfg->lookups keys from the input file; a (1 - hitRatio) share of
+// them get MISS_SUFFIX so they share a full stored prefix but miss
+static int buildWorkload(Workload *w, const BenchConfig *cfg) {
+    memset(w, 0, sizeof(*w));
+    w->count = cfg->lookups ? cfg->lookups : 1;
+    w->rng = cfg->seed;
+    w->batch = cfg->batch ? cfg->batch : 1;
+    w->keys = (char**)calloc(w->count, sizeof(char*));
+    w->expect = (int*)calloc(w->count, sizeof(int));
+    w->found = (uint64_t*)calloc((w->batch + 63) / 64, sizeof(uint64_t));
+    if (!w->keys || !w->expect || !w->found ||
+        forEachPath(cfg, sampleLine, w, NULL) != 0 || w->seen == 0) {
+        freeWorkload(w);
+        return -1;
+    }
+    // Fewer lines than lookups: repeat the ones we have
+    size_t distinct = w->seen < w->count ? w->seen : w->count;
+    char **keys = (char**)calloc(w->count, sizeof(char*));
+    if (!keys) { freeWorkload(w); return -1; }
+    size_t depth = 0;
+    for (size_t i = 0; i < w->count; i++) {
+        const char *src = w->keys[i % distinct];
+        int hit = bench_chance(&w->rng, cfg->hitRatio);
+        size_t len = strlen(src);
+        char *key = (char*)malloc(len + sizeof(MISS_SUFFIX));
+        if (!key) break;
+        memcpy(key, src, len + 1);
+        if (!hit) memcpy(key + len, MISS_SUFFIX, sizeof(MISS_SUFFIX));
+        for (const char *c = key; *c; c++) depth += *c == '/';
+        w->expect[i] = hit;
+        keys[i] = key;
+    }
+    for (size_t i = 0; i < distinct; i++) free(w->keys[i]);
+    free(w->keys);
+    w->keys = keys;
+    if (!keys[w->count - 1]) { freeWorkload(w); return -1; }
+    w->avgDepth = (double)depth / (double)w->count + 1.0;
+    return 0;
+}
+
+static void searchOp(void *ctx, size_t i) {
+    Workload *w = (Workload*)ctx;
+    w->wrong += searchFile(w->root, w->keys[i]) != w->expect[i];
+}
+
+// One searchFileBatch() call per group of w->batch keys. bench_run()
+// times groups of the same size, so the op only runs on a group's first
+// index and its time is spread over the group.
+static void batchSearchOp(void *ctx, size_t i) {
+    Workload *w = (Workload*)ctx;
+    if (i % w->batch != 0) return;
+    size_t n = w->count - i < w->batch ? w->count - i : w->batch;
+    searchFileBatch(w->root, (const char *const *)w->keys + i, n, w->found);
+    for (size_t j = 0; j < n; j++)
+        w->wrong += (int)((w->found[j / 64] >> (j % 64)) & 1) != w->expect[i + j];
+}
+
+static void indexSearchOp(void *ctx, size_t i) {
+    Workload *w = (Workload*)ctx;
+    w->wrong += trieIndexSearch(w->index, w->keys[i]) != w->expect[i];
+}
+
+// Run the lookup workload ('batch' ops per clock sample) and return its
+// unified-CSV parameter string
+static void runLookups(Workload *w, const BenchConfig *cfg, bench_op_fn op, size_t batch,
+                       BenchResult *r, char *params, size_t paramsSize) {
+    BenchSpec spec = { w->count, cfg->warmup, cfg->reps, batch, NULL };
+    bench_run(&spec, op, w, r);
+    snprintf(params, paramsSize, "hit_ratio=%.2f;depth=%.1f;lookups=%zu;seed=%llu",
+             cfg->hitRatio, w->avgDepth, w->count, cfg->seed);
+}
+
+// ---------- Concurrent readers + one writer ----------
+
+typedef struct {
+    Workload *w;                 // shared, read-only while threads run
+    RcuTrie *rcu;                // RCU mode
+    TrieNode *root;              // mutex mode: the plain trie behind 'lock'
+    pthread_mutex_t lock;
+    const BenchConfig *cfg;
+    atomic_int started;          // threads waiting at the start line
+    atomic_int go;
+    atomic_int stop;             // readers done: the writer stops
+    size_t writes;
+} ConcurrentRun;
+
+typedef struct {
+    ConcurrentRun *run;
+    RcuTrieReader *reader;       // NULL in mutex mode
+    size_t offset;               // threads start at different keys
+    size_t wrong;
+    BenchResult result;
+} ReaderThread;
+
+static void rcuSearchOp(void *ctx, size_t i) {
+    ReaderThread *t = (ReaderThread*)ctx;
+    size_t k = (i + t->offset) % t->run->w->count;
+    t->wrong += rcuTrieSearch(t->reader, t->run->w->keys[k]) != t->run->w->expect[k];
+}
+
+static void mutexSearchOp(void *ctx, size_t i) {
+    ReaderThread *t = (ReaderThread*)ctx;
+    size_t k = (i + t->offset) % t->run->w->count;
+    pthread_mutex_lock(&t->run->lock);
+    t->wrong += searchFile(t->run->root, t->run->w->keys[k]) != t->run->w->expect[k];
+    pthread_mutex_unlock(&t->run->lock);
+}
+
+static void waitForStart(ConcurrentRun *run) {
+    atomic_fetch_add(&run->started, 1);
+    while (!atomic_load(&run->go)) sched_yield();
+}
+
+static void* readerMain(void *arg) {
+    ReaderThread *t = (ReaderThread*)arg;
+    const BenchConfig *cfg = t->run->cfg;
+    BenchSpec spec = { t->run->w->count, cfg->warmup, cfg->reps, 1, NULL };
+    waitForStart(t->run);
+    bench_run(&spec, t->reader ? rcuSearchOp : mutexSearchOp, t, &t->result);
+    return NULL;
+}
+
+// Insert path i and, once WRITER_BACKLOG paths are in, remove path
+// i - WRITER_BACKLOG, the same churn in both modes so the trie the readers
+// search stays at its loaded size plus the backlog
+static void writerStep(ConcurrentRun *run, size_t i, int insert) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.rcu%zu", run->w->keys[i % run->w->count], i);
+    if (run->rcu) {
+        if (insert) rcuTrieInsert(run->rcu, path);
+        else rcuTrieRemove(run->rcu, path);
+    } else {
+        pthread_mutex_lock(&run->lock);
+        if (insert) insertFile(run->root, path);
+        else removeFile(run->root, path);
+        pthread_mutex_unlock(&run->lock);
+    }
+}
+
+static void* writerMain(void *arg) {
+    ConcurrentRun *run = (ConcurrentRun*)arg;
+    size_t i = 0;
+    waitForStart(run);
+    for (; !atomic_load(&run->stop); i++) {
+        writerStep(run, i, 1);
+        if (i >= WRITER_BACKLOG) writerStep(run, i - WRITER_BACKLOG, 0);
+        run->writes++;
+    }
+    // Drop the backlog so the next configuration starts from the loaded trie
+    for (size_t old = i > WRITER_BACKLOG ? i - WRITER_BACKLOG : 0; old < i; old++)
+        writerStep(run, old, 0);
+    return NULL;
+}
+
+// Run 'threads' readers and one writer; fold the readers into 'out'. Its
+// total_ns is the wall time, so ops_per_sec is the aggregate throughput.
+static int runConcurrent(ConcurrentRun *run, int threads, BenchResult *out, size_t *wrong) {
+    ReaderThread *readers = (ReaderThread*)calloc((size_t)threads, sizeof(ReaderThread));
+    pthread_t *ids = (pthread_t*)calloc((size_t)threads + 1, sizeof(pthread_t));
+    if (!readers || !ids) {
+        free(readers);
+        free(ids);
+        return -1;
+    }
+    atomic_store(&run->started, 0);
+    atomic_store(&run->go, 0);
+    atomic_store(&run->stop, 0);
+    run->writes = 0;
+
+    int created = 0;
+    for (; created < threads; created++) {
+        ReaderThread *t = &readers[created];
+        t->run = run;
+        t->offset = run->w->count * (size_t)created / (size_t)threads;
+        t->reader = run->rcu ? rcuTrieReaderJoin(run->rcu) : NULL;
+        if ((run->rcu && !t->reader) || pthread_create(&ids[created], NULL, readerMain, t) != 0) {
+            rcuTrieReaderLeave(t->reader);
+            break;
+        }
+    }
+    int writer = pthread_create(&ids[threads], NULL, writerMain, run) == 0;
+    while (atomic_load(&run->started) < created + writer) sched_yield();
+    uint64_t t0 = bench_now_ns();
+    atomic_store(&run->go, 1);
+    for (int i = 0; i < created; i++) pthread_join(ids[i], NULL);
+    uint64_t t1 = bench_now_ns();
+    atomic_store(&run->stop, 1);
+    if (writer) pthread_join(ids[threads], NULL);
+
+    memset(out, 0, sizeof(*out));
+    *wrong = 0;
+    for (int i = 0; i < created; i++) {
+        bench_merge(out, &readers[i].result);
+        *wrong += readers[i].wrong;
+        rcuTrieReaderLeave(readers[i].reader);
+    }
+    out->total_ns = t1 - t0;
+    free(readers);
+    free(ids);
+    return created == threads ? 0 : -1;
+}
+
+typedef struct {
+    const char *op;
+    int threads;
+    size_t writes;
+    size_t wrong;
+    BenchResult result;
+} ConcurrentRow;
+
+static int insertRcu(char *line, size_t len, void *ctx) {
+    (void)len;
+    return rcuTrieInsert((RcuTrie*)ctx, line) < 0 ? -1 : 0;
+}
+
+// Same lookups from 1..N threads against the RCU trie and against the
+// plain trie behind one mutex, each with a writer running alongside
+static size_t benchConcurrent(Workload *w, const BenchConfig *cfg, TrieNode *root,
+                              const int *threads, int configs, ConcurrentRow *rows,
+                              BenchResult *rcuBuild) {
+    ConcurrentRun run;
+    memset(&run, 0, sizeof(run));
+    run.w = w;
+    run.cfg = cfg;
+    run.root = root;
+    pthread_mutex_init(&run.lock, NULL);
+
+    uint64_t t0 = bench_now_ns();
+    RcuTrie *rcu = rcuTrieCreate();
+    if (!rcu || forEachPath(cfg, insertRcu, rcu, NULL) != 0) {
+        rcuTrieFree(rcu);
+        pthread_mutex_destroy(&run.lock);
+        return 0;
+    }
+    bench_single(rcuBuild, bench_now_ns() - t0);
+
+    size_t n = 0;
+    for (int c = 0; c < configs; c++) {
+        for (int mode = 0; mode < 2; mode++) {
+            ConcurrentRow *row = &rows[n];
+            run.rcu = mode == 0 ? rcu : NULL;
+            row->op = mode == 0 ? "rcu_search" : "mutex_search";
+            row->threads = threads[c];
+            if (runConcurrent(&run, threads[c], &row->result, &row->wrong) != 0) continue;
+            row->writes = run.writes;
+            n++;
+        }
+    }
+    rcuTrieFree(rcu);
+    pthread_mutex_destroy(&run.lock);
+    return n;
+}
+
+// Parse a comma-separated thread list such as "1,2,4,8"
+static int parseThreadList(const char *arg, int *threads) {
+    int n = 0;
+    while (*arg && n < MAX_THREAD_CONFIGS) {
+        int t = atoi(arg);
+        if (t > 0) threads[n++] = t;
+        const char *comma = strchr(arg, ',');
+        if (!comma) break;
+        arg = comma + 1;
+    }
+    return n;
+}
+
+// ---------- Paginated listing under a prefix ----------
+
+typedef struct {
+    const char *prefix;
+    size_t offset;       // files to skip before the page
+    size_t page;         // files to list
+    size_t total;        // files under the prefix
+    size_t listed;
+    BenchResult count;   // trieCountPrefix()
+    BenchResult fetch;   // reset + skip + copying the page out, printing excluded
+} PrefixListing;
+
+// Count the files under the prefix, then print one page of them
+static int listPrefix(TrieNode *root, PrefixListing *l) {
+    TrieIter *it = trieIterCreate();
+    size_t bufSize = TRIE_ITER_MAX_PATH * 16;
+    char *buf = (char*)malloc(bufSize);
+    if (!it || !buf) {
+        trieIterFree(it);
+        free(buf);
+        return -1;
+    }
+    uint64_t t0 = bench_now_ns();
+    l->total = trieCountPrefix(root, l->prefix);
+    bench_single(&l->count, bench_now_ns() - t0);
+
+    t0 = bench_now_ns();
+    trieIterReset(it, root, l->prefix);
+    trieIterSkip(it, l->offset);
+    uint64_t spent = bench_now_ns() - t0;
+    printf("Files under '%s': %zu; showing %zu from #%zu\n", l->prefix, l->total, l->page, l->offset);
+    l->listed = 0;
+    while (l->listed < l->page) {
+        t0 = bench_now_ns();
+        size_t n = trieIterNext(it, buf, bufSize, l->page - l->listed);
+        spent += bench_now_ns() - t0;
+        if (n == 0) {
+            // A path longer than buf is waiting: make room for it
+            char *grown = trieIterDone(it) ? NULL : (char*)realloc(buf, bufSize * 2);
+            if (!grown) break;
+            buf = grown;
+            bufSize *= 2;
+            continue;
+        }
+        for (const char *p = buf; n > 0; n--, l->listed++) {
+            printf("  %s\n", p);
+            p += strlen(p) + 1;
+        }
+    }
+    bench_single(&l->fetch, spent);
+    int failed = trieIterFailed(it) || (l->listed < l->page && !trieIterDone(it));
+    if (failed) fprintf(stderr, "Listing stopped after %zu files: out of memory\n", l->listed);
+    trieIterFree(it);
+    free(buf);
+    return failed ? -1 : 0;
+}
+
+static FILE* openBenchCsv(void) {
+    bench_ensure_dir("results");
+    FILE *f = fopen("results/bench_trie.csv", "w");
+    if (f) bench_csv_header(f);
+    return f;
+}
+
+// Answer queries from a memory-mapped index file instead of rebuilding
+static int run_from_index(const char *index_path, const char *query, const BenchConfig *cfg) {
+    // ---------- Load timing (map only, nothing is rebuilt) ----------
+    uint64_t t0 = bench_now_ns();
+    TrieIndex *index = trieIndexOpen(index_path);
+    uint64_t t1 = bench_now_ns();
+    if (!index) {
+        printf("Error: could not open index %s\n", index_path);
+        return 1;
+    }
+    double load_time = (t1 - t0) / 1e9;
+
+    if (query) {
+        printf("Searching for '%s'...\n", query);
+        printf("Result: %s\n", trieIndexSearch(index, query) ? "Found" : "Not Found");
+    }
+
+    // ---------- Lookup workload (keys sampled from the input list) ----------
+    Workload w;
+    if (buildWorkload(&w, cfg) != 0) {
+        printf("Error: could not sample lookup keys from %s\n", cfg->inputPath);
+        trieIndexClose(index);
+        return 1;
+    }
+    w.index = index;
+    BenchResult load, lookups;
+    char params[160];
+    bench_single(&load, t1 - t0);
+    runLookups(&w, cfg, indexSearchOp, 1, &lookups, params, sizeof(params));
+    double search_time = lookups.total_ns / 1e9 / (cfg->reps > 0 ? cfg->reps : 1);
+    const char *result = w.wrong ? "mismatch" : "ok";
+
+    bench_ensure_dir("results");
+    FILE *csv = fopen("results/output_trie.csv", "w");
+    if (csv) {
+        fprintf(csv, "LoadTime(s),SearchTime(s),Lookups,HitRatio,Files,IndexBytes\n%.6f,%.6f,%zu,%.2f,%zu,%zu\n",
+                load_time, search_time, w.count, cfg->hitRatio,
+                trieIndexFileCount(index), trieIndexBytes(index));
+        fclose(csv);
+    }
+    FILE *bench = openBenchCsv();
+    if (bench) {
+        bench_csv_row(bench, MODULE_NAME, "index_load", trieIndexFileCount(index), "", 1, &load, "ok");
+        bench_csv_row(bench, MODULE_NAME, "index_search", trieIndexFileCount(index), params,
+                      cfg->reps, &lookups, result);
+        fclose(bench);
+    }
+
+    printf("\nIndex load time: %.6f s (%zu files, %zu bytes mapped)\n",
+           load_time, trieIndexFileCount(index), trieIndexBytes(index));
+    printf("Search time (%zu lookups): %.6f s, p50 %llu ns, p99 %llu ns%s\n", w.count, search_time,
+           (unsigned long long)bench_hist_percentile(&lookups.hist, 0.50),
+           (unsigned long long)bench_hist_percentile(&lookups.hist, 0.99),
+           w.wrong ? " (MISMATCH)" : "");
+    printf("Results saved in results/output_trie.csv and results/bench_trie.csv\n");
+    freeWorkload(&w);
+    trieIndexClose(index);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *query = NULL;
+    const char *save_path = NULL;
+    const char *index_path = NULL;
+    int use_arena = 0;
+    int sorted_input = 0;
+    const char *gen_out = NULL;
+    int threads[MAX_THREAD_CONFIGS];
+    int thread_configs = 0;
+    PrefixListing listing;
+    memset(&listing, 0, sizeof(listing));
+    listing.page = DEFAULT_PAGE;
+    BenchConfig cfg = { "sample_files/sample.txt", 0, DEFAULT_LOOKUPS, DEFAULT_REPS,
+                        DEFAULT_WARMUP, DEFAULT_HIT_RATIO, 42, DEFAULT_BATCH };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--search") == 0 && i + 1 < argc)
+            query = argv[++i];
+        else if (strcmp(argv[i], "--arena") == 0)
+            use_arena = 1;
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            save_path = argv[++i];
+        else if (strcmp(argv[i], "--index") == 0 && i + 1 < argc)
+            index_path = argv[++i];
+        else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+            cfg.inputPath = argv[++i];
+        else if (strcmp(argv[i], "--sorted") == 0)
+            sorted_input = 1;
+        else if (strcmp(argv[i], "--lookups") == 0 && i + 1 < argc)
+            cfg.lookups = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+            cfg.reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            cfg.warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hit-ratio") == 0 && i + 1 < argc)
+            cfg.hitRatio = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            cfg.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc)
+            cfg.generate = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--gen-out") == 0 && i + 1 < argc)
+            gen_out = argv[++i];
+        else if (strcmp(argv[i], "--concurrent") == 0 && i + 1 < argc)
+            thread_configs = parseThreadList(argv[++i], threads);
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+            cfg.batch = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--list") == 0 && i + 1 < argc)
+            listing.prefix = argv[++i];
+        else if (strcmp(argv[i], "--page") == 0 && i + 1 < argc)
+            listing.page = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--offset") == 0 && i + 1 < argc)
+            listing.offset = (size_t)strtoull(argv[++i], NULL, 10);
+    }
+
+    // ---------- Optional: write the generated namespace, then load it ----------
+    if (cfg.generate && gen_out) {
+        NsGenConfig gc;
+        nsgen_defaults(&gc, cfg.seed, cfg.generate);
+        if (nsgen_write(&gc, gen_out) != 0) {
+            printf("Error: could not write %s\n", gen_out);
+            return 1;
+        }
+        printf("Generated %zu paths into %s\n", cfg.generate, gen_out);
+        cfg.inputPath = gen_out;
+        cfg.generate = 0;
+    }
+
+    if (index_path)
+        return run_from_index(index_path, query, &cfg);
+
+    Arena *arena = use_arena ? arenaCreate(ARENA_DEFAULT_BLOCK) : NULL;
+    trieSetArena(arena);
+    TrieNode *root = createNode();
+    if (!root) {
+        printf("Error: out of memory\n");
+        if (arena) arenaDestroy(arena);
+        return 1;
+    }
+
+    // ---------- Build timing (streaming bulk load, or straight from nsgen) ----------
+    uint64_t t0 = bench_now_ns();
+    TrieLoadStats load;
+    int rc;
+    if (cfg.generate) {
+        memset(&load, 0, sizeof(load));
+        GenLoad gen = { root, &load };
+        rc = forEachPath(&cfg, insertGenerated, &gen, &load.bytes);
+    } else {
+        rc = trieBulkLoad(root, cfg.inputPath, sorted_input, &load);
+    }
+    if (rc != 0) {
+        printf("Error: could not load %s\n", cfg.generate ? "the generated namespace" : cfg.inputPath);
+        return 1;
+    }
+    uint64_t t1 = bench_now_ns();
+    BenchResult build;
+    bench_single(&build, t1 - t0);
+    double build_time = (t1 - t0) / 1e9;
+    double paths_per_sec = build_time > 0 ? load.paths / build_time : 0.0;
+    double mb_per_sec = build_time > 0 ? load.bytes / build_time / 1e6 : 0.0;
+
+    size_t node_count, bytes_used;
+    trieStats(root, &node_count, &bytes_used);
+
+    // ---------- Optional: write the mmap-able index ----------
+    if (save_path) {
+        if (trieIndexWrite(root, save_path) == 0)
+            printf("Index written to %s\n", save_path);
+        else
+            printf("Error: could not write index %s\n", save_path);
+    }
+
+    // ---------- Search feature ----------
+    if (query) {
+        printf("Searching for '%s'...\n", query);
+        if (searchFile(root, query))
+            printf("Result: Found\n");
+        else
+            printf("Result: Not Found\n");
+    }
+
+    int have_listing = listing.prefix && listPrefix(root, &listing) == 0;
+
+    // ---------- Lookup workload: real keys, hit/miss mix ----------
+    Workload w;
+    BenchResult lookups, loop, batched;
+    char params[160] = "";
+    size_t loop_wrong = 0, batch_wrong = 0;
+    memset(&lookups, 0, sizeof(lookups));
+    int have_workload = buildWorkload(&w, &cfg) == 0;
+    if (have_workload) {
+        w.root = root;
+        runLookups(&w, &cfg, searchOp, 1, &lookups, params, sizeof(params));
+        // Single vs. batched lookups, both timed per group of w.batch keys
+        size_t wrong = w.wrong;
+        runLookups(&w, &cfg, searchOp, w.batch, &loop, params, sizeof(params));
+        loop_wrong = w.wrong - wrong;
+        wrong = w.wrong;
+        runLookups(&w, &cfg, batchSearchOp, w.batch, &batched, params, sizeof(params));
+        batch_wrong = w.wrong - wrong;
+        w.wrong -= loop_wrong + batch_wrong;
+    }
+    double search_time = lookups.total_ns / 1e9 / (cfg.reps > 0 ? cfg.reps : 1);
+
+    // ---------- Optional: concurrent readers, RCU trie vs. one mutex ----------
+    ConcurrentRow concurrent[MAX_THREAD_CONFIGS * 2];
+    BenchResult rcu_build;
+    size_t concurrent_rows = 0;
+    if (have_workload && thread_configs > 0)
+        concurrent_rows = benchConcurrent(&w, &cfg, root, threads, thread_configs,
+                                          concurrent, &rcu_build);
+
+    // ---------- Teardown timing ----------
+    size_t arena_reserved, arena_used;
+    arenaStats(arena, &arena_reserved, &arena_used);
+    t0 = bench_now_ns();
+    if (arena)
+        arenaDestroy(arena);
+    else
+        freeTrie(root);
+    t1 = bench_now_ns();
+    BenchResult teardown;
+    bench_single(&teardown, t1 - t0);
+    double teardown_time = (t1 - t0) / 1e9;
+    trieSetArena(NULL);
+
+    // ---------- Save results ----------
+    bench_ensure_dir("results");
+    FILE *csv = fopen("results/output_trie.csv", "w");
+    if (csv) {
+        fprintf(csv, "BuildTime(s),Paths,PathsPerSec,MBPerSec,Sorted,SearchTime(s),Lookups,HitRatio,"
+                     "TeardownTime(s),Nodes,Bytes,Allocator,ArenaReserved,ArenaUsed\n"
+                     "%.6f,%zu,%.0f,%.2f,%d,%.6f,%zu,%.2f,%.6f,%zu,%zu,%s,%zu,%zu\n",
+                build_time, load.paths, paths_per_sec, mb_per_sec, sorted_input,
+                search_time, have_workload ? w.count : 0, cfg.hitRatio, teardown_time,
+                node_count, bytes_used, use_arena ? "arena" : "malloc", arena_reserved, arena_used);
+        fclose(csv);
+    }
+
+    FILE *bench = openBenchCsv();
+    if (bench) {
+        char buildParams[128];
+        snprintf(buildParams, sizeof(buildParams), "source=%s;sorted=%d;allocator=%s;nodes=%zu;bytes=%zu",
+                 cfg.generate ? "nsgen" : "file", sorted_input && !cfg.generate,
+                 use_arena ? "arena" : "malloc", node_count, bytes_used);
+        bench_csv_row(bench, MODULE_NAME, "build", load.paths, buildParams, 1, &build, "ok");
+        if (have_workload) {
+            bench_csv_row(bench, MODULE_NAME, "search", load.paths, params, cfg.reps, &lookups,
+                          w.wrong ? "mismatch" : "ok");
+            char batchParams[192];
+            snprintf(batchParams, sizeof(batchParams), "batch=%zu;%s", w.batch, params);
+            bench_csv_row(bench, MODULE_NAME, "search_loop", load.paths, batchParams, cfg.reps, &loop,
+                          loop_wrong ? "mismatch" : "ok");
+            bench_csv_row(bench, MODULE_NAME, "search_batch", load.paths, batchParams, cfg.reps,
+                          &batched, batch_wrong ? "mismatch" : "ok");
+        }
+        bench_csv_row(bench, MODULE_NAME, "teardown", load.paths, buildParams, 1, &teardown, "ok");
+        if (have_listing) {
+            char listParams[256];
+            snprintf(listParams, sizeof(listParams), "prefix=%s;files=%zu;offset=%zu;page=%zu;counts=%s",
+                     listing.prefix, listing.total, listing.offset, listing.listed,
+#ifdef TRIE_COUNTS
+                     "node"
+#else
+                     "walk"
+#endif
+                     );
+            bench_csv_row(bench, MODULE_NAME, "prefix_count", load.paths, listParams, 1, &listing.count, "ok");
+            bench_csv_row(bench, MODULE_NAME, "prefix_page", load.paths, listParams, 1, &listing.fetch, "ok");
+        }
+        if (concurrent_rows > 0)
+            bench_csv_row(bench, MODULE_NAME, "rcu_build", load.paths, buildParams, 1, &rcu_build, "ok");
+        for (size_t i = 0; i < concurrent_rows; i++) {
+            char threadParams[256];
+            snprintf(threadParams, sizeof(threadParams), "threads=%d;writes=%zu;writer=insert_remove;backlog=%d;%s",
+                     concurrent[i].threads, concurrent[i].writes, WRITER_BACKLOG, params);
+            bench_csv_row(bench, MODULE_NAME, concurrent[i].op, load.paths, threadParams, cfg.reps,
+                          &concurrent[i].result, concurrent[i].wrong ? "mismatch" : "ok");
+        }
+        fclose(bench);
+    }
+
+    printf("\nBuild time: %.6f s (%zu paths, %.0f paths/s, %.2f MB/s%s)\n",
+           build_time, load.paths, paths_per_sec, mb_per_sec, sorted_input ? ", sorted" : "");
+    if (have_workload)
+        printf("Search time (%zu lookups, hit ratio %.2f): %.6f s, p50 %llu ns, p99 %llu ns%s\n",
+               w.count, cfg.hitRatio, search_time,
+               (unsigned long long)bench_hist_percentile(&lookups.hist, 0.50),
+               (unsigned long long)bench_hist_percentile(&lookups.hist, 0.99),
+               w.wrong ? " (MISMATCH)" : "");
+    if (have_workload)
+        printf("Groups of %zu: %.1f ns/lookup one by one, %.1f ns/lookup batched%s\n", w.batch,
+               bench_hist_mean(&loop.hist), bench_hist_mean(&batched.hist),
+               loop_wrong || batch_wrong ? " (MISMATCH)" : "");
+    for (size_t i = 0; i < concurrent_rows; i++) {
+        const BenchResult *r = &concurrent[i].result;
+        printf("%-12s %2d threads: %.0f lookups/s, p50 %llu ns, p99 %llu ns, %zu writes%s\n",
+               concurrent[i].op, concurrent[i].threads,
+               r->total_ns ? r->ops * 1e9 / r->total_ns : 0.0,
+               (unsigned long long)bench_hist_percentile(&r->hist, 0.50),
+               (unsigned long long)bench_hist_percentile(&r->hist, 0.99),
+               concurrent[i].writes, concurrent[i].wrong ? " (MISMATCH)" : "");
+    }
+    printf("Teardown time: %.6f s (%s)\n", teardown_time, use_arena ? "arena" : "malloc");
+    printf("Nodes: %zu, memory: %zu bytes\n", node_count, bytes_used);
+    printf("Results saved in results/output_trie.csv and results/bench_trie.csv\n");
+    if (have_workload) freeWorkload(&w);
+    return 0;
+}
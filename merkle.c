@@ -0,0 +1,568 @@
+/*
+ * merkle.c
+ *
+ * Leaf storage, the level-ordered digest array, build, verify and tamper
+ * for the Merkle tree (see merkle.h). Leaves and interior pairs are hashed
+ * MERKLE_HASH_BATCH messages at a time through sha256_mb_hash(), so the
+ * multi-buffer kernel compresses 4/8/16 of them in lockstep.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "merkle.h"
+
+#ifdef MERKLE_ODD_DUPLICATE
+#define MERKLE_ODD_RULE SNAPSHOT_ODD_DUPLICATE
+#else
+#define MERKLE_ODD_RULE SNAPSHOT_ODD_PROMOTE
+#endif
+
+int merkle_odd_rule(void) {
+    return MERKLE_ODD_RULE;
+}
+
+/* ---------- Storage ---------- */
+
+/* Level sizes and offsets for n > 0 leaves; returns the digest count */
+static size_t plan_levels(MerkleTree *tree, size_t n) {
+    size_t at = 0;
+    tree->levels = 0;
+    for (;;) {
+        tree->level_start[tree->levels] = at;
+        tree->level_size[tree->levels] = n;
+        tree->levels++;
+        at += n;
+        if (n == 1) break;
+        n = (n + 1) / 2;
+    }
+    return at;
+}
+
+/* Leaves with copied names and a digest array for every level */
+static int alloc_leaves(MerkleTree *tree, const char **filenames, size_t n) {
+    memset(tree, 0, sizeof(*tree));
+    if (n == 0) return -1;
+    size_t total = plan_levels(tree, n);
+    tree->nodes = calloc(n, sizeof(MerkleNode));
+    tree->leaves = malloc(n * sizeof(MerkleNode*));
+    tree->digests = malloc(total * SHA256_DIGEST_LEN);
+    if (!tree->nodes || !tree->leaves || !tree->digests) { free_tree(tree); return -1; }
+    tree->leaf_count = n;
+    tree->digest_count = total;
+
+    for (size_t i = 0; i < n; ++i) {
+        MerkleNode *leaf = &tree->nodes[i];
+        leaf->hash = tree->digests[i];
+        leaf->index = i;
+        leaf->filename = strdup(filenames[i]);
+        if (!leaf->filename) { free_tree(tree); return -1; }
+        tree->leaves[i] = leaf;
+    }
+    tree->top.hash = tree->digests[total - 1];
+    return 0;
+}
+
+void free_tree(MerkleTree *tree) {
+    if (!tree) return;
+    for (size_t i = 0; tree->nodes && i < tree->leaf_count; ++i) {
+        free(tree->nodes[i].filename);
+        free(tree->nodes[i].data);
+    }
+    free(tree->nodes);
+    free(tree->leaves);
+    free(tree->digests);
+    memset(tree, 0, sizeof(*tree));
+}
+
+size_t merkle_tree_bytes(const MerkleTree *tree) {
+    size_t bytes = tree->leaf_count * (sizeof(MerkleNode) + sizeof(MerkleNode*)) +
+                   tree->digest_count * SHA256_DIGEST_LEN;
+    for (size_t i = 0; i < tree->leaf_count; ++i) {
+        const MerkleNode *leaf = &tree->nodes[i];
+        bytes += strlen(leaf->filename) + 1;
+        if (leaf->data) bytes += strlen(leaf->data) + 1;
+    }
+    return bytes;
+}
+
+const uint8_t *merkle_digests(const MerkleTree *tree) {
+    return (const uint8_t*)tree->digests;
+}
+
+/* ---------- Hashing ---------- */
+
+#define MERKLE_HASH_BATCH 64     /* messages per sha256_mb_hash() call */
+
+/* Messages hashed together by the multi-buffer kernel, each digest going
+   to its own place in the digest array */
+typedef struct {
+    const uint8_t *msgs[MERKLE_HASH_BATCH];
+    size_t lens[MERKLE_HASH_BATCH];
+    uint8_t *dst[MERKLE_HASH_BATCH];
+    size_t count;
+} HashBatch;
+
+static void batch_flush(HashBatch *batch) {
+    uint8_t out[MERKLE_HASH_BATCH][SHA256_DIGEST_LEN];
+    if (batch->count == 0) return;
+    sha256_mb_hash(batch->msgs, batch->lens, out, batch->count);
+    for (size_t k = 0; k < batch->count; ++k) memcpy(batch->dst[k], out[k], SHA256_DIGEST_LEN);
+    batch->count = 0;
+}
+
+static void batch_add(HashBatch *batch, const void *msg, size_t len, uint8_t *dst) {
+    batch->msgs[batch->count] = (const uint8_t*)msg;
+    batch->lens[batch->count] = len;
+    batch->dst[batch->count++] = dst;
+    if (batch->count == MERKLE_HASH_BATCH) batch_flush(batch);
+}
+
+/* Digests of leaves [begin, end), or of leaves list[begin..end) when list
+   is not NULL, from their content (digest-only leaves are skipped) */
+static void hash_leaves(MerkleTree *tree, const size_t *list, size_t begin, size_t end) {
+    HashBatch batch;
+    batch.count = 0;
+    for (size_t i = begin; i < end; ++i) {
+        MerkleNode *leaf = &tree->nodes[list ? list[i] : i];
+        if (!leaf->data) continue;
+        batch_add(&batch, leaf->data, strlen(leaf->data), leaf->hash);
+        leaf->stale = 0;
+    }
+    batch_flush(&batch);
+}
+
+/* Unpaired parent j on level lv + 1: the odd rule decides */
+static void lift_odd(MerkleTree *tree, int lv, size_t j) {
+    const uint8_t *child = tree->digests[tree->level_start[lv] + 2 * j];
+    uint8_t *out = tree->digests[tree->level_start[lv + 1] + j];
+    if (MERKLE_ODD_RULE == SNAPSHOT_ODD_DUPLICATE) {
+        uint8_t pair[2 * SHA256_DIGEST_LEN];
+        memcpy(pair, child, SHA256_DIGEST_LEN);
+        memcpy(pair + SHA256_DIGEST_LEN, child, SHA256_DIGEST_LEN);
+        sha256_mb_single(pair, sizeof(pair), out);
+    } else {
+        memcpy(out, child, SHA256_DIGEST_LEN);
+    }
+}
+
+/* Parents [begin, end) on level lv + 1 (or parents list[begin..end)) from
+   their children on level lv; siblings are adjacent in the array, so each
+   pair is hashed where it lies */
+static void hash_parents(MerkleTree *tree, int lv, const size_t *list, size_t begin, size_t end) {
+    HashBatch batch;
+    batch.count = 0;
+    for (size_t i = begin; i < end; ++i) {
+        size_t j = list ? list[i] : i;
+        if (2 * j + 1 < tree->level_size[lv])
+            batch_add(&batch, tree->digests[tree->level_start[lv] + 2 * j], 2 * SHA256_DIGEST_LEN,
+                      tree->digests[tree->level_start[lv + 1] + j]);
+        else
+            lift_odd(tree, lv, j);
+    }
+    batch_flush(&batch);
+}
+
+/* ---------- Build ---------- */
+
+/* Smallest range worth handing to the pool; whole batches per chunk keep
+   the multi-buffer lanes full */
+#define MERKLE_PAR_MIN (4 * MERKLE_HASH_BATCH)
+
+typedef struct {
+    MerkleTree *tree;
+    int lv;                 /* children's level, for parent_body() */
+} BuildCtx;
+
+static void leaf_body(size_t begin, size_t end, void *ctx) {
+    hash_leaves(((BuildCtx*)ctx)->tree, NULL, begin, end);
+}
+
+/* Leaves tampered since the last build; the others keep their digest */
+static void stale_body(size_t begin, size_t end, void *ctx) {
+    MerkleTree *tree = ((BuildCtx*)ctx)->tree;
+    HashBatch batch;
+    batch.count = 0;
+    for (size_t i = begin; i < end; ++i) {
+        MerkleNode *leaf = &tree->nodes[i];
+        if (!leaf->stale) continue;
+        batch_add(&batch, leaf->data, strlen(leaf->data), leaf->hash);
+        leaf->stale = 0;
+    }
+    batch_flush(&batch);
+}
+
+static void parent_body(size_t begin, size_t end, void *ctx) {
+    BuildCtx *c = (BuildCtx*)ctx;
+    hash_parents(c->tree, c->lv, NULL, begin, end);
+}
+
+/* body over [0, n): inline when n is small or there is no pool, otherwise
+   in chunks of whole batches, about four per thread. Every index is
+   hashed the same way either way, so the digests do not depend on the
+   thread count. */
+static void run_range(ThreadPool *pool, size_t n, parallel_body_fn body, BuildCtx *ctx) {
+    if (!pool || n < MERKLE_PAR_MIN) { body(0, n, ctx); return; }
+    size_t chunk = n / ((size_t)threadpool_size(pool) * 4);
+    if (chunk < MERKLE_HASH_BATCH) chunk = MERKLE_HASH_BATCH;
+    chunk = (chunk + MERKLE_HASH_BATCH - 1) / MERKLE_HASH_BATCH * MERKLE_HASH_BATCH;
+    threadpool_parallel_for(pool, n, chunk, body, ctx);
+}
+
+int build_leaves_from_arrays_mt(MerkleTree *tree, const char **filenames,
+                                const char **contents, size_t n, ThreadPool *pool) {
+    if (alloc_leaves(tree, filenames, n) != 0) return -1;
+    for (size_t i = 0; i < n; ++i) {
+        tree->nodes[i].data = strdup(contents[i]);
+        if (!tree->nodes[i].data) { free_tree(tree); return -1; }
+    }
+    BuildCtx ctx = { tree, 0 };
+    run_range(pool, n, leaf_body, &ctx);
+    return 0;
+}
+
+int build_leaves_from_arrays(MerkleTree *tree, const char **filenames,
+                             const char **contents, size_t n) {
+    return build_leaves_from_arrays_mt(tree, filenames, contents, n, NULL);
+}
+
+int build_leaves_from_digests(MerkleTree *tree, const char **filenames,
+                              const uint8_t (*digests)[SHA256_DIGEST_LEN], size_t n) {
+    if (alloc_leaves(tree, filenames, n) != 0) return -1;
+    memcpy(tree->digests, digests, n * SHA256_DIGEST_LEN);
+    return 0;
+}
+
+/* Levels depend on each other, so only the work within one is split */
+int build_merkle_tree_mt(MerkleTree *tree, ThreadPool *pool) {
+    if (!tree->digests) return -1;
+    BuildCtx ctx = { tree, 0 };
+    run_range(pool, tree->leaf_count, stale_body, &ctx);
+    for (ctx.lv = 0; ctx.lv + 1 < tree->levels; ++ctx.lv)
+        run_range(pool, tree->level_size[ctx.lv + 1], parent_body, &ctx);
+    tree->root = &tree->top;
+    return 0;
+}
+
+int build_merkle_tree(MerkleTree *tree) {
+    return build_merkle_tree_mt(tree, NULL);
+}
+
+/* cur = H(cur || sib), or H(sib || cur) when cur is the right child (odd j) */
+static void hash_with_sibling(uint8_t *cur, const uint8_t *sib, uint64_t j) {
+    uint8_t pair[2 * SHA256_DIGEST_LEN];
+    memcpy(pair + ((j & 1) ? SHA256_DIGEST_LEN : 0), cur, SHA256_DIGEST_LEN);
+    memcpy(pair + ((j & 1) ? 0 : SHA256_DIGEST_LEN), sib, SHA256_DIGEST_LEN);
+    sha256_mb_single(pair, sizeof(pair), cur);
+}
+
+/* Lift an unpaired node to its parent under odd_rule, in place */
+static void lift_unpaired(uint8_t *cur, int odd_rule) {
+    if (odd_rule != SNAPSHOT_ODD_DUPLICATE) return;
+    uint8_t pair[2 * SHA256_DIGEST_LEN];
+    memcpy(pair, cur, SHA256_DIGEST_LEN);
+    memcpy(pair + SHA256_DIGEST_LEN, cur, SHA256_DIGEST_LEN);
+    sha256_mb_single(pair, sizeof(pair), cur);
+}
+
+/* ---------- Incremental update ---------- */
+
+static int owns_leaf(const MerkleTree *tree, const MerkleNode *leaf) {
+    return leaf && leaf->index < tree->leaf_count && tree->leaves[leaf->index] == leaf;
+}
+
+int merkle_update_leaf(MerkleTree *tree, MerkleNode *leaf) {
+    if (!tree->root || !owns_leaf(tree, leaf)) return -1;
+    size_t j = leaf->index;
+    hash_leaves(tree, &j, 0, 1);
+    for (int lv = 0; lv + 1 < tree->levels; ++lv) {
+        j /= 2;
+        hash_parents(tree, lv, &j, 0, 1);
+    }
+    return 0;
+}
+
+static int cmp_index(const void *a, const void *b) {
+    size_t x = *(const size_t*)a, y = *(const size_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+int merkle_update_leaves(MerkleTree *tree, MerkleNode **leaves, size_t k) {
+    if (!tree->root) return -1;
+    if (k == 0) return 0;
+    size_t *idx = malloc(k * sizeof(size_t));
+    if (!idx) return -1;
+    for (size_t i = 0; i < k; ++i) {
+        if (!owns_leaf(tree, leaves[i])) { free(idx); return -1; }
+        idx[i] = leaves[i]->index;
+    }
+
+    /* Sorted and distinct, so a level's parents come out sorted and the
+       two children of one parent are adjacent */
+    qsort(idx, k, sizeof(size_t), cmp_index);
+    size_t count = 0;
+    for (size_t i = 0; i < k; ++i)
+        if (count == 0 || idx[count - 1] != idx[i]) idx[count++] = idx[i];
+    hash_leaves(tree, idx, 0, count);
+
+    for (int lv = 0; lv + 1 < tree->levels; ++lv) {
+        size_t parents = 0;
+        for (size_t i = 0; i < count; ++i)
+            if (parents == 0 || idx[parents - 1] != idx[i] / 2) idx[parents++] = idx[i] / 2;
+        count = parents;
+        hash_parents(tree, lv, idx, 0, count);
+    }
+    free(idx);
+    return 0;
+}
+
+/* ---------- Verify / tamper ---------- */
+
+/* The leaf stored under filename, if it belongs to this tree */
+NameMap *merkle_name_index(const MerkleTree *tree) {
+    NameMap *map = namemap_create(tree->leaf_count);
+    if (!map) return NULL;
+    for (size_t i = 0; i < tree->leaf_count; ++i) {
+        if (namemap_put(map, tree->leaves[i]->filename, tree->leaves[i]) != 0) {
+            namemap_free(map);
+            return NULL;
+        }
+    }
+    return map;
+}
+
+static MerkleNode *find_leaf(NameMap *map, const MerkleTree *tree, const char *filename) {
+    MerkleNode *leaf = map ? namemap_get(map, filename) : NULL;
+    return owns_leaf(tree, leaf) ? leaf : NULL;
+}
+
+int verify_file(NameMap *map, MerkleTree *tree, const char *filename) {
+    MerkleNode *leaf = find_leaf(map, tree, filename);
+    if (!leaf || !tree->root) return -1;
+    uint8_t cur[SHA256_DIGEST_LEN];
+    if (leaf->data) sha256_mb_single(leaf->data, strlen(leaf->data), cur);
+    else memcpy(cur, leaf->hash, SHA256_DIGEST_LEN);
+    if (memcmp(cur, leaf->hash, SHA256_DIGEST_LEN) != 0) return 0;
+
+    /* Hash up to the root with the stored siblings */
+    size_t j = leaf->index;
+    for (int lv = 0; lv + 1 < tree->levels; ++lv, j /= 2) {
+        if ((j ^ 1) < tree->level_size[lv])
+            hash_with_sibling(cur, tree->digests[tree->level_start[lv] + (j ^ 1)], j);
+        else
+            lift_unpaired(cur, MERKLE_ODD_RULE);
+    }
+    return memcmp(cur, tree->root->hash, SHA256_DIGEST_LEN) == 0;
+}
+
+int tamper_file(NameMap *map, MerkleTree *tree, const char *filename, const char *content) {
+    MerkleNode *leaf = find_leaf(map, tree, filename);
+    if (!leaf) return -1;
+    char *copy = strdup(content);
+    if (!copy) return -1;
+    free(leaf->data);
+    leaf->data = copy;
+    leaf->stale = 1;
+    return 0;
+}
+
+/* ---------- Proofs ---------- */
+
+MerkleProof *get_proof(NameMap *map, MerkleTree *tree, const char *filename) {
+    MerkleNode *leaf = find_leaf(map, tree, filename);
+    if (!leaf || !tree->root) return NULL;
+    size_t count = 0, j = leaf->index;
+    for (int lv = 0; lv + 1 < tree->levels; ++lv, j /= 2)
+        count += (j ^ 1) < tree->level_size[lv];
+
+    MerkleProof *proof = malloc(sizeof(MerkleProof) + count * SHA256_DIGEST_LEN);
+    if (!proof) return NULL;
+    proof->leaf_count = tree->leaf_count;
+    proof->leaf_index = leaf->index;
+    proof->odd_rule = MERKLE_ODD_RULE;
+    proof->count = count;
+    count = 0;
+    j = leaf->index;
+    for (int lv = 0; lv + 1 < tree->levels; ++lv, j /= 2)
+        if ((j ^ 1) < tree->level_size[lv])
+            memcpy(proof->siblings[count++], tree->digests[tree->level_start[lv] + (j ^ 1)],
+                   SHA256_DIGEST_LEN);
+    return proof;
+}
+
+int verify_proof(const uint8_t *root_hash, const char *leaf_content, const MerkleProof *proof) {
+    if (!root_hash || !leaf_content || !proof || proof->leaf_index >= proof->leaf_count) return 0;
+    uint8_t cur[SHA256_DIGEST_LEN];
+    sha256_mb_single(leaf_content, strlen(leaf_content), cur);
+    uint64_t j = proof->leaf_index;
+    size_t used = 0;
+    for (uint64_t size = proof->leaf_count; size > 1; size = (size + 1) / 2, j /= 2) {
+        if ((j ^ 1) < size) {
+            if (used == proof->count) return 0;
+            hash_with_sibling(cur, proof->siblings[used++], j);
+        } else {
+            lift_unpaired(cur, proof->odd_rule);
+        }
+    }
+    return used == proof->count && memcmp(cur, root_hash, SHA256_DIGEST_LEN) == 0;
+}
+
+size_t proof_size_bytes(const MerkleProof *proof) {
+    return sizeof(MerkleProof) + proof->count * SHA256_DIGEST_LEN;
+}
+
+void free_proof(MerkleProof *proof) {
+    free(proof);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Walk the levels over the sorted, distinct leaf positions pos[0..m): two
+   proven siblings pair up, any other node needs its sibling from the proof
+   unless it is unpaired, and positions become their parents' in place.
+   Copies the needed siblings to out (when not NULL); returns how many.
+   verify_multiproof() consumes them in exactly this order. */
+static size_t collect_siblings(const MerkleTree *tree, uint64_t *pos, size_t m,
+                               uint8_t (*out)[SHA256_DIGEST_LEN]) {
+    size_t count = 0;
+    for (int lv = 0; lv + 1 < tree->levels; ++lv) {
+        size_t parents = 0;
+        for (size_t i = 0; i < m; ++i) {
+            uint64_t p = pos[i];
+            if (!(p & 1) && i + 1 < m && pos[i + 1] == p + 1) {
+                ++i;
+            } else if ((p ^ 1) < tree->level_size[lv]) {
+                if (out) memcpy(out[count], tree->digests[tree->level_start[lv] + (p ^ 1)],
+                                SHA256_DIGEST_LEN);
+                count++;
+            }
+            pos[parents++] = p / 2;
+        }
+        m = parents;
+    }
+    return count;
+}
+
+MerkleMultiProof *get_multiproof(NameMap *map, MerkleTree *tree, const char **filenames, size_t k) {
+    if (k == 0 || !tree->root) return NULL;
+    uint64_t *pos = malloc(2 * k * sizeof(uint64_t));
+    if (!pos) return NULL;
+    uint64_t *work = pos + k;
+    for (size_t i = 0; i < k; ++i) {
+        MerkleNode *leaf = find_leaf(map, tree, filenames[i]);
+        if (!leaf) { free(pos); return NULL; }
+        pos[i] = leaf->index;
+    }
+    MerkleMultiProof *proof = malloc(sizeof(MerkleMultiProof) + k * sizeof(uint64_t));
+    if (!proof) { free(pos); return NULL; }
+    memcpy(proof + 1, pos, k * sizeof(uint64_t));
+
+    qsort(pos, k, sizeof(uint64_t), cmp_u64);
+    size_t m = 0;
+    for (size_t i = 0; i < k; ++i)
+        if (m == 0 || pos[m - 1] != pos[i]) pos[m++] = pos[i];
+
+    /* Count the siblings, then lay them out after the indices */
+    memcpy(work, pos, m * sizeof(uint64_t));
+    size_t count = collect_siblings(tree, work, m, NULL);
+    MerkleMultiProof *grown = realloc(proof, sizeof(MerkleMultiProof) + k * sizeof(uint64_t) +
+                                             count * SHA256_DIGEST_LEN);
+    if (!grown) { free(proof); free(pos); return NULL; }
+    proof = grown;
+    proof->leaf_count = tree->leaf_count;
+    proof->odd_rule = MERKLE_ODD_RULE;
+    proof->k = k;
+    proof->indices = (uint64_t*)(proof + 1);
+    proof->count = count;
+    proof->siblings = (uint8_t (*)[SHA256_DIGEST_LEN])(proof->indices + k);
+    collect_siblings(tree, pos, m, proof->siblings);
+    free(pos);
+    return proof;
+}
+
+typedef struct {
+    uint64_t index;
+    uint8_t digest[SHA256_DIGEST_LEN];
+} ProvenNode;
+
+static int cmp_proven(const void *a, const void *b) {
+    return cmp_u64(&((const ProvenNode*)a)->index, &((const ProvenNode*)b)->index);
+}
+
+int verify_multiproof(const uint8_t *root_hash, const char **contents, size_t k,
+                      const MerkleMultiProof *proof) {
+    if (!root_hash || !contents || !proof || k == 0 || k != proof->k) return 0;
+    for (size_t i = 0; i < k; ++i)
+        if (proof->indices[i] >= proof->leaf_count) return 0;
+    ProvenNode *nodes = malloc(k * sizeof(ProvenNode));
+    uint8_t (*pairs)[2 * SHA256_DIGEST_LEN] = malloc(k * sizeof(*pairs));
+    if (!nodes || !pairs) { free(nodes); free(pairs); return -1; }
+
+    HashBatch batch;
+    batch.count = 0;
+    for (size_t i = 0; i < k; ++i) {
+        nodes[i].index = proof->indices[i];
+        batch_add(&batch, contents[i], strlen(contents[i]), nodes[i].digest);
+    }
+    batch_flush(&batch);
+
+    /* Sorted by position; a leaf given twice must have the same content */
+    qsort(nodes, k, sizeof(ProvenNode), cmp_proven);
+    int ok = 1;
+    size_t m = 0;
+    for (size_t i = 0; i < k; ++i) {
+        if (m > 0 && nodes[m - 1].index == nodes[i].index)
+            ok &= memcmp(nodes[m - 1].digest, nodes[i].digest, SHA256_DIGEST_LEN) == 0;
+        else
+            nodes[m++] = nodes[i];
+    }
+
+    /* Fold level by level as collect_siblings() walked; a level's pairs are
+       hashed in batches, each parent landing in a slot already consumed */
+    size_t used = 0;
+    for (uint64_t size = proof->leaf_count; ok && size > 1; size = (size + 1) / 2) {
+        size_t parents = 0;
+        for (size_t i = 0; i < m; ++i) {
+            uint64_t p = nodes[i].index;
+            uint8_t *msg = pairs[parents];
+            if (!(p & 1) && i + 1 < m && nodes[i + 1].index == p + 1) {
+                memcpy(msg, nodes[i].digest, SHA256_DIGEST_LEN);
+                memcpy(msg + SHA256_DIGEST_LEN, nodes[++i].digest, SHA256_DIGEST_LEN);
+            } else if ((p ^ 1) < size) {
+                if (used == proof->count) { ok = 0; break; }
+                memcpy(msg + ((p & 1) ? SHA256_DIGEST_LEN : 0), nodes[i].digest, SHA256_DIGEST_LEN);
+                memcpy(msg + ((p & 1) ? 0 : SHA256_DIGEST_LEN), proof->siblings[used++], SHA256_DIGEST_LEN);
+            } else if (proof->odd_rule == SNAPSHOT_ODD_DUPLICATE) {
+                memcpy(msg, nodes[i].digest, SHA256_DIGEST_LEN);
+                memcpy(msg + SHA256_DIGEST_LEN, nodes[i].digest, SHA256_DIGEST_LEN);
+            } else {
+                memmove(nodes[parents].digest, nodes[i].digest, SHA256_DIGEST_LEN);
+                nodes[parents++].index = p / 2;
+                continue;
+            }
+            batch_add(&batch, msg, 2 * SHA256_DIGEST_LEN, nodes[parents].digest);
+            nodes[parents++].index = p / 2;
+        }
+        batch_flush(&batch);
+        m = parents;
+    }
+    ok = ok && used == proof->count && m == 1 &&
+         memcmp(nodes[0].digest, root_hash, SHA256_DIGEST_LEN) == 0;
+    free(nodes);
+    free(pairs);
+    return ok;
+}
+
+size_t multiproof_size_bytes(const MerkleMultiProof *proof) {
+    return sizeof(MerkleMultiProof) + proof->k * sizeof(uint64_t) + proof->count * SHA256_DIGEST_LEN;
+}
+
+void free_multiproof(MerkleMultiProof *proof) {
+    free(proof);
+}
@@ -0,0 +1,145 @@
+/*
+ * merkle.h
+ *
+ * Merkle tree over named leaves. Node digests are raw 32-byte SHA-256
+ * values in one contiguous, level-ordered array: leaves first, root last,
+ * the layout snapshot.h keeps on disk. Level L+1 has ceil(size(L) / 2)
+ * nodes and node j's children are 2j and 2j+1, so a parent hashes the 64
+ * adjacent bytes left||right in place. A leaf digest is SHA-256 of the
+ * content and an unpaired node follows merkle_odd_rule(). Hex is produced
+ * only by callers, at output time.
+ *
+ * Leaves are found by name through the filename index of namemap.h.
+ */
+
+#ifndef MERKLE_H
+#define MERKLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sha256_mb.h"
+#include "snapshot.h"
+#include "namemap.h"
+#include "threadpool.h"
+
+typedef struct MerkleNode {
+    uint8_t *hash;          /* SHA256_DIGEST_LEN bytes inside the tree's digest array */
+    char *filename;         /* NULL for the root */
+    char *data;             /* leaf content; NULL if only the digest is known */
+    size_t index;           /* leaf position */
+    int stale;              /* content changed since the digest was computed */
+} MerkleNode;
+
+typedef struct {
+    MerkleNode **leaves;    /* leaves[i] is leaf i */
+    size_t leaf_count;
+    MerkleNode *root;       /* NULL until build_merkle_tree() */
+
+    /* storage; read through the functions below */
+    MerkleNode *nodes;      /* the leaves, one block */
+    uint8_t (*digests)[SHA256_DIGEST_LEN];
+    size_t digest_count;
+    int levels;
+    size_t level_start[SNAPSHOT_MAX_LEVELS];
+    size_t level_size[SNAPSHOT_MAX_LEVELS];
+    MerkleNode top;         /* what root points to */
+} MerkleTree;
+
+/* Inclusion proof: the sibling digests on the path from one leaf to the
+   root, lowest level first. A level whose node is unpaired has no sibling;
+   leaf_count tells the verifier which levels those are. */
+typedef struct {
+    uint64_t leaf_count;
+    uint64_t leaf_index;
+    int odd_rule;
+    size_t count;                                 /* siblings in use */
+    uint8_t siblings[][SHA256_DIGEST_LEN];
+} MerkleProof;
+
+/* One proof for k leaves. Siblings are listed level by level in position
+   order, and only where the verifier cannot derive them: a sibling that
+   is itself on another proven path (or is shared by two paths) is not
+   stored. */
+typedef struct {
+    uint64_t leaf_count;
+    int odd_rule;
+    size_t k;
+    uint64_t *indices;                            /* leaf index of each proven content */
+    size_t count;
+    uint8_t (*siblings)[SHA256_DIGEST_LEN];
+} MerkleMultiProof;
+
+/* Leaves with copied names and contents; their digests are computed here.
+   The tree must be zeroed or freed. Returns 0, or -1 (n == 0, no memory). */
+int build_leaves_from_arrays(MerkleTree *tree, const char **filenames,
+                             const char **contents, size_t n);
+
+/* Leaves whose digests were computed elsewhere (leafsource.c streams files
+   from disk); no content is kept in memory */
+int build_leaves_from_digests(MerkleTree *tree, const char **filenames,
+                              const uint8_t (*digests)[SHA256_DIGEST_LEN], size_t n);
+
+/* Rehash tampered leaves, then every interior level. Returns 0 or -1. */
+int build_merkle_tree(MerkleTree *tree);
+
+/* The same builds with each leaf range and each level split across the
+   pool (NULL runs inline); the digests are identical to the sequential
+   ones for any thread count */
+int build_leaves_from_arrays_mt(MerkleTree *tree, const char **filenames,
+                                const char **contents, size_t n, ThreadPool *pool);
+int build_merkle_tree_mt(MerkleTree *tree, ThreadPool *pool);
+
+/* Filename index over the leaves, created with room for leaf_count names
+   so filling it never grows the table; NULL if out of memory. Free with
+   namemap_free(). */
+NameMap *merkle_name_index(const MerkleTree *tree);
+
+/* Hash the leaf's current content and check it, with the stored sibling
+   digests, against the stored root: 1 = valid, 0 = tampered, -1 = unknown
+   name or unbuilt tree */
+int verify_file(NameMap *map, MerkleTree *tree, const char *filename);
+
+/* Replace a leaf's content without touching any digest. Returns 0 or -1. */
+int tamper_file(NameMap *map, MerkleTree *tree, const char *filename, const char *content);
+
+/* Rehash a leaf from its content, then only its ancestors up to the root
+   (O(log n) hashes) on a built tree. Returns 0 or -1. */
+int merkle_update_leaf(MerkleTree *tree, MerkleNode *leaf);
+
+/* Batched variant for k changed leaves: each level's changed parents are
+   hashed together, and an ancestor shared by several leaves only once */
+int merkle_update_leaves(MerkleTree *tree, MerkleNode **leaves, size_t k);
+
+/* Proof for a named leaf of a built tree, or NULL */
+MerkleProof *get_proof(NameMap *map, MerkleTree *tree, const char *filename);
+
+/* Standalone check, needs no tree: 1 = valid, 0 = invalid */
+int verify_proof(const uint8_t *root_hash, const char *leaf_content, const MerkleProof *proof);
+
+size_t proof_size_bytes(const MerkleProof *proof);
+void free_proof(MerkleProof *proof);
+
+/* Proof for k named leaves (NULL if a name is unknown or k == 0) */
+MerkleMultiProof *get_multiproof(NameMap *map, MerkleTree *tree, const char **filenames, size_t k);
+
+/* contents[i] is checked as the leaf filenames[i] named at generation;
+   1 = all valid, 0 = invalid, -1 = out of memory */
+int verify_multiproof(const uint8_t *root_hash, const char **contents, size_t k,
+                      const MerkleMultiProof *proof);
+
+size_t multiproof_size_bytes(const MerkleMultiProof *proof);
+void free_multiproof(MerkleMultiProof *proof);
+
+void free_tree(MerkleTree *tree);
+
+/* Heap bytes of the nodes, the digest array, names and contents */
+size_t merkle_tree_bytes(const MerkleTree *tree);
+
+/* The level-ordered digest array (leaves first, root last), for snapshot_write() */
+const uint8_t *merkle_digests(const MerkleTree *tree);
+
+/* SNAPSHOT_ODD_PROMOTE, or SNAPSHOT_ODD_DUPLICATE when built with
+   -DMERKLE_ODD_DUPLICATE */
+int merkle_odd_rule(void);
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * merkle_stream.c
+ *
+ * Frontier accumulator, post-order node log and consistency proofs (see
+ * merkle_stream.h).
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h>
+#include "merkle_stream.h"
+#include "snapshot.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+  #define log_seek _fseeki64
+#else
+  #define log_seek fseeko
+#endif
+
+/* out = H(left || right); out may alias either input */
+static void hash_pair(const uint8_t *left, const uint8_t *right, uint8_t *out) {
+    uint8_t pair[2 * SHA256_DIGEST_LEN];
+    memcpy(pair, left, SHA256_DIGEST_LEN);
+    memcpy(pair + SHA256_DIGEST_LEN, right, SHA256_DIGEST_LEN);
+    sha256_mb_single(pair, sizeof(pair), out);
+}
+
+static int popcount64(uint64_t x) {
+    int c = 0;
+    for (; x; x &= x - 1) c++;
+    return c;
+}
+
+/* Fold a frontier (perfect subtrees left to right, heights strictly
+   decreasing) into a root, lifting unpaired nodes by the odd rule */
+static void fold_peaks(const uint8_t (*peaks)[SHA256_DIGEST_LEN], const int *heights, size_t count,
+                       int odd_rule, uint8_t root[SHA256_DIGEST_LEN]) {
+    uint8_t acc[SHA256_DIGEST_LEN];
+    int acc_h = heights[count - 1];
+    memcpy(acc, peaks[count - 1], SHA256_DIGEST_LEN);
+    for (size_t i = count - 1; i-- > 0; ) {
+        if (odd_rule == SNAPSHOT_ODD_DUPLICATE)
+            for (; acc_h < heights[i]; acc_h++) hash_pair(acc, acc, acc);
+        hash_pair(peaks[i], acc, acc);
+        acc_h = heights[i] + 1;
+    }
+    memcpy(root, acc, SHA256_DIGEST_LEN);
+}
+
+void merkle_stream_init(MerkleStream *ms, int odd_rule, FILE *log) {
+    memset(ms, 0, sizeof(*ms));
+    ms->odd_rule = odd_rule;
+    ms->log = log;
+}
+
+static void log_node(MerkleStream *ms, const uint8_t *digest) {
+    if (ms->log && !ms->log_failed &&
+        fwrite(digest, SHA256_DIGEST_LEN, 1, ms->log) != 1)
+        ms->log_failed = 1;
+}
+
+int merkle_stream_append_digest(MerkleStream *ms, const uint8_t digest[SHA256_DIGEST_LEN]) {
+    uint8_t carry[SHA256_DIGEST_LEN];
+    memcpy(carry, digest, SHA256_DIGEST_LEN);
+    log_node(ms, carry);
+    /* Binary increment: every set low bit is a same-height subtree to merge */
+    int h = 0;
+    for (uint64_t c = ms->count; c & 1; c >>= 1, h++) {
+        hash_pair(ms->peaks[h], carry, carry);
+        log_node(ms, carry);
+    }
+    memcpy(ms->peaks[h], carry, SHA256_DIGEST_LEN);
+    ms->count++;
+    return ms->log_failed ? -1 : 0;
+}
+
+int merkle_stream_append(MerkleStream *ms, const void *content, size_t len) {
+    uint8_t digest[SHA256_DIGEST_LEN];
+    sha256_mb_single(content, len, digest);
+    return merkle_stream_append_digest(ms, digest);
+}
+
+int merkle_stream_root(const MerkleStream *ms, uint8_t root[SHA256_DIGEST_LEN]) {
+    uint8_t peaks[MERKLE_STREAM_MAX_LEVELS][SHA256_DIGEST_LEN];
+    int heights[MERKLE_STREAM_MAX_LEVELS];
+    size_t count = 0;
+    if (ms->count == 0) return -1;
+    for (int h = MERKLE_STREAM_MAX_LEVELS - 1; h >= 0; h--)
+        if ((ms->count >> h) & 1) {
+            memcpy(peaks[count], ms->peaks[h], SHA256_DIGEST_LEN);
+            heights[count++] = h;
+        }
+    fold_peaks((const uint8_t (*)[SHA256_DIGEST_LEN])peaks, heights, count, ms->odd_rule, root);
+    return 0;
+}
+
+/* ---------- Reading the node log ---------- */
+
+/* Read the perfect subtree of 2^h leaves that ends at leaf 'end'
+   (exclusive). Leaf end-1 was logged after 2(end-1) - popcount(end-1)
+   nodes, followed by the merges it triggered, lowest first. */
+static int read_subtree(MerkleStream *ms, uint64_t end, int h, uint8_t *out) {
+    uint64_t at = 2 * (end - 1) - (uint64_t)popcount64(end - 1) + (uint64_t)h;
+    if (log_seek(ms->log, (long long)(at * SHA256_DIGEST_LEN), SEEK_SET) != 0 ||
+        fread(out, SHA256_DIGEST_LEN, 1, ms->log) != 1)
+        return -1;
+    return 0;
+}
+
+/* Split leaves [lo, hi) into aligned perfect subtrees, left to right */
+static size_t aligned_blocks(uint64_t lo, uint64_t hi, uint64_t *ends, int *heights) {
+    size_t count = 0;
+    while (lo < hi) {
+        int h = 0;
+        while (h + 1 < MERKLE_STREAM_MAX_LEVELS && (lo & ((2ull << h) - 1)) == 0 &&
+               lo + (2ull << h) <= hi)
+            h++;
+        lo += 1ull << h;
+        ends[count] = lo;
+        heights[count++] = h;
+    }
+    return count;
+}
+
+/* Read the blocks of [lo, hi) into digests; returns how many, or -1 */
+static long read_blocks(MerkleStream *ms, uint64_t lo, uint64_t hi,
+                        uint8_t (*digests)[SHA256_DIGEST_LEN], int *heights) {
+    uint64_t ends[2 * MERKLE_STREAM_MAX_LEVELS];
+    size_t count = aligned_blocks(lo, hi, ends, heights);
+    for (size_t i = 0; i < count; i++)
+        if (read_subtree(ms, ends[i], heights[i], digests[i]) != 0) return -1;
+    return (long)count;
+}
+
+/* Make the log readable; appends continue at the end afterwards */
+static int log_ready(MerkleStream *ms) {
+    return ms->log && !ms->log_failed && fflush(ms->log) == 0 ? 0 : -1;
+}
+
+static void log_done(MerkleStream *ms) {
+    if (log_seek(ms->log, 0, SEEK_END) != 0) ms->log_failed = 1;
+}
+
+int merkle_stream_root_at(MerkleStream *ms, uint64_t size, uint8_t root[SHA256_DIGEST_LEN]) {
+    uint8_t peaks[MERKLE_STREAM_MAX_LEVELS][SHA256_DIGEST_LEN];
+    int heights[MERKLE_STREAM_MAX_LEVELS];
+    if (size == 0 || size > ms->count || log_ready(ms) != 0) return -1;
+    long count = read_blocks(ms, 0, size, peaks, heights);
+    log_done(ms);
+    if (count <= 0) return -1;
+    fold_peaks((const uint8_t (*)[SHA256_DIGEST_LEN])peaks, heights, (size_t)count, ms->odd_rule, root);
+    return 0;
+}
+
+int merkle_stream_consistency(MerkleStream *ms, uint64_t old_size, uint64_t new_size,
+                              MerkleConsistencyProof *proof) {
+    int heights[2 * MERKLE_STREAM_MAX_LEVELS];
+    if (old_size == 0 || old_size > new_size || new_size > ms->count || log_ready(ms) != 0)
+        return -1;
+    proof->old_size = old_size;
+    proof->new_size = new_size;
+    long old_peaks = read_blocks(ms, 0, old_size, proof->digests, heights);
+    long added = old_peaks < 0 ? -1 : read_blocks(ms, old_size, new_size, proof->digests + old_peaks, heights);
+    log_done(ms);
+    if (added < 0) return -1;
+    proof->old_peaks = (size_t)old_peaks;
+    proof->count = (size_t)(old_peaks + added);
+    return 0;
+}
+
+int merkle_consistency_verify(const uint8_t old_root[SHA256_DIGEST_LEN],
+                              const uint8_t new_root[SHA256_DIGEST_LEN],
+                              const MerkleConsistencyProof *proof, int odd_rule) {
+    uint8_t frontier[MERKLE_STREAM_MAX_LEVELS][SHA256_DIGEST_LEN], root[SHA256_DIGEST_LEN];
+    int heights[MERKLE_STREAM_MAX_LEVELS];
+    uint64_t ends[2 * MERKLE_STREAM_MAX_LEVELS];
+    int block_h[2 * MERKLE_STREAM_MAX_LEVELS];
+    if (proof->old_size == 0 || proof->old_size > proof->new_size) return 0;
+
+    /* The proof's shape follows from the two sizes alone */
+    size_t old_peaks = aligned_blocks(0, proof->old_size, ends, heights);
+    size_t added = aligned_blocks(proof->old_size, proof->new_size, ends, block_h);
+    if (old_peaks != proof->old_peaks || old_peaks + added != proof->count) return 0;
+
+    memcpy(frontier, proof->digests, old_peaks * SHA256_DIGEST_LEN);
+    fold_peaks((const uint8_t (*)[SHA256_DIGEST_LEN])frontier, heights, old_peaks, odd_rule, root);
+    if (memcmp(root, old_root, SHA256_DIGEST_LEN) != 0) return 0;
+
+    /* Append the new subtrees to the old frontier, merging equal heights */
+    size_t top = old_peaks;
+    for (size_t i = 0; i < added; i++) {
+        uint8_t carry[SHA256_DIGEST_LEN];
+        int h = block_h[i];
+        memcpy(carry, proof->digests[old_peaks + i], SHA256_DIGEST_LEN);
+        while (top > 0 && heights[top - 1] == h) {
+            hash_pair(frontier[--top], carry, carry);
+            h++;
+        }
+        memcpy(frontier[top], carry, SHA256_DIGEST_LEN);
+        heights[top++] = h;
+    }
+    fold_peaks((const uint8_t (*)[SHA256_DIGEST_LEN])frontier, heights, top, odd_rule, root);
+    return memcmp(root, new_root, SHA256_DIGEST_LEN) == 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * merkle_stream.h
+ *
+ * Append-only Merkle accumulator for leaves that arrive one at a time
+ * (ingest logs). Only the right-edge frontier is kept: one subtree root
+ * per set bit of the leaf count, so memory is O(log n) whatever n is, and
+ * the current root is available after every append. For the same leaves
+ * the root is byte-identical to build_merkle_tree(): leaves are SHA-256 of
+ * the content, parents hash left||right, and an unpaired node follows the
+ * tree's odd rule (snapshot.h).
+ *
+ * Consistency proofs ("the tree of size m is a prefix of the tree of size
+ * n") need interior nodes from the past. When a log file is attached,
+ * every completed node is appended to it in post-order (2 digests per
+ * leaf on disk) and proofs read the few nodes they need back from it.
+ *
+ * Proof layout: the frontier of the old tree (its perfect subtrees, left
+ * to right), then the aligned perfect subtrees covering leaves
+ * [old_size, new_size). The verifier folds the first part into the old
+ * root, then appends the second part to that frontier as whole subtrees
+ * and folds the result into the new root.
+ */
+
+#ifndef MERKLE_STREAM_H
+#define MERKLE_STREAM_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sha256_mb.h"
+
+#define MERKLE_STREAM_MAX_LEVELS 64
+#define MERKLE_PROOF_MAX_DIGESTS (3 * MERKLE_STREAM_MAX_LEVELS)
+
+typedef struct {
+    uint8_t peaks[MERKLE_STREAM_MAX_LEVELS][SHA256_DIGEST_LEN];
+                             /* peaks[h]: root of 2^h leaves, valid if bit h of count is set */
+    uint64_t count;          /* leaves appended */
+    int odd_rule;            /* SNAPSHOT_ODD_PROMOTE or SNAPSHOT_ODD_DUPLICATE */
+    FILE *log;               /* completed nodes in post-order, or NULL */
+    int log_failed;          /* a log write failed: proofs are disabled */
+} MerkleStream;
+
+typedef struct {
+    uint64_t old_size, new_size;
+    size_t old_peaks;        /* digests[0 .. old_peaks) fold into the old root */
+    size_t count;            /* digests in use */
+    uint8_t digests[MERKLE_PROOF_MAX_DIGESTS][SHA256_DIGEST_LEN];
+} MerkleConsistencyProof;
+
+/* Start an empty accumulator. log may be NULL (no proofs); otherwise it
+   must be an empty file opened for update ("w+b"), owned by the caller. */
+void merkle_stream_init(MerkleStream *ms, int odd_rule, FILE *log);
+
+/* Append one leaf: its content, or a digest computed elsewhere.
+   Returns 0, or -1 if the log could not be written (the root stays valid). */
+int merkle_stream_append(MerkleStream *ms, const void *content, size_t len);
+int merkle_stream_append_digest(MerkleStream *ms, const uint8_t digest[SHA256_DIGEST_LEN]);
+
+/* Root over all leaves so far; -1 while empty */
+int merkle_stream_root(const MerkleStream *ms, uint8_t root[SHA256_DIGEST_LEN]);
+
+/* Root the tree had after 'size' leaves (needs the log) */
+int merkle_stream_root_at(MerkleStream *ms, uint64_t size, uint8_t root[SHA256_DIGEST_LEN]);
+
+/* Prove that size old_size is a prefix of size new_size, with
+   0 < old_size <= new_size <= count (needs the log). Returns 0 or -1. */
+int merkle_stream_consistency(MerkleStream *ms, uint64_t old_size, uint64_t new_size,
+                              MerkleConsistencyProof *proof);
+
+/* Check a proof against the two published roots (1 = valid, 0 = invalid) */
+int merkle_consistency_verify(const uint8_t old_root[SHA256_DIGEST_LEN],
+                              const uint8_t new_root[SHA256_DIGEST_LEN],
+                              const MerkleConsistencyProof *proof, int odd_rule);
+
+#endif
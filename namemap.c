@@ -0,0 +1,219 @@
+/*
+ * namemap.c
+ *
+ * Slots are grouped 16 to a probe group. ctrl[i] is CTRL_EMPTY or the low
+ * 7 bits (h2) of the slot's hash; the remaining bits (h1) pick the first
+ * group, and probing moves to the next group by triangular steps, which
+ * visits every group when the group count is a power of two. A group is
+ * matched against h2 in one SSE2 compare where available. There is no
+ * removal, so a probe can stop at the first group with an empty slot.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "namemap.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define NAMEMAP_SSE2 1
+#endif
+
+#define GROUP 16
+#define CTRL_EMPTY 0x80
+#define NAME_BLOCK (64 * 1024)
+
+typedef struct {
+    uint64_t hash;               /* cached full hash */
+    const char *name;            /* copy owned by the map */
+    struct MerkleNode *node;
+} Slot;
+
+/* Names are copied into large blocks instead of one malloc each */
+typedef struct NameBlock {
+    struct NameBlock *next;
+    size_t used, size;
+    char data[];
+} NameBlock;
+
+struct NameMap {
+    unsigned char *ctrl;         /* groups * GROUP control bytes */
+    Slot *slots;
+    size_t groups;               /* power of two */
+    size_t count;
+    size_t limit;                /* grow when count reaches this (7/8 load) */
+    NameBlock *names;
+    size_t name_bytes;
+};
+
+/* FNV-1a followed by a final avalanche so h1 and h2 both vary */
+static uint64_t hash_name(const char *s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (; *s; ++s) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static unsigned char h2_of(uint64_t h) { return (unsigned char)(h & 0x7f); }
+static size_t h1_of(uint64_t h) { return (size_t)(h >> 7); }
+
+/* Bit i set where ctrl[i] == byte */
+static unsigned match_byte(const unsigned char *ctrl, unsigned char byte) {
+#ifdef NAMEMAP_SSE2
+    __m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)byte)));
+#else
+    unsigned mask = 0;
+    for (int i = 0; i < GROUP; ++i)
+        if (ctrl[i] == byte) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+static unsigned lowest_bit(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(mask);
+#else
+    unsigned i = 0;
+    while (!(mask & 1u)) { mask >>= 1; ++i; }
+    return i;
+#endif
+}
+
+/* Allocate empty tables with the given number of groups */
+static int alloc_tables(NameMap *map, size_t groups) {
+    unsigned char *ctrl = malloc(groups * GROUP);
+    Slot *slots = malloc(groups * GROUP * sizeof(Slot));
+    if (!ctrl || !slots) { free(ctrl); free(slots); return -1; }
+    memset(ctrl, CTRL_EMPTY, groups * GROUP);
+    map->ctrl = ctrl;
+    map->slots = slots;
+    map->groups = groups;
+    map->limit = groups * GROUP / 8 * 7;
+    return 0;
+}
+
+/* First empty slot on the probe sequence of hash h */
+static size_t find_empty(const NameMap *map, uint64_t h) {
+    size_t mask = map->groups - 1;
+    size_t g = h1_of(h) & mask;
+    for (size_t step = 1;; ++step) {
+        unsigned empty = match_byte(map->ctrl + g * GROUP, CTRL_EMPTY);
+        if (empty) return g * GROUP + lowest_bit(empty);
+        g = (g + step) & mask;
+    }
+}
+
+/* Double the table, reinserting slots by their cached hashes */
+static int grow(NameMap *map) {
+    NameMap old = *map;
+    if (alloc_tables(map, old.groups * 2) != 0) { *map = old; return -1; }
+    for (size_t i = 0; i < old.groups * GROUP; ++i) {
+        if (old.ctrl[i] == CTRL_EMPTY) continue;
+        size_t j = find_empty(map, old.slots[i].hash);
+        map->ctrl[j] = old.ctrl[i];
+        map->slots[j] = old.slots[i];
+    }
+    free(old.ctrl);
+    free(old.slots);
+    return 0;
+}
+
+/* Copy a name into the current block, starting a new one when full */
+static const char *copy_name(NameMap *map, const char *name) {
+    size_t len = strlen(name) + 1;
+    NameBlock *b = map->names;
+    if (!b || b->size - b->used < len) {
+        size_t size = len > NAME_BLOCK ? len : NAME_BLOCK;
+        b = malloc(sizeof(NameBlock) + size);
+        if (!b) return NULL;
+        b->next = map->names;
+        b->used = 0;
+        b->size = size;
+        map->names = b;
+        map->name_bytes += sizeof(NameBlock) + size;
+    }
+    char *dst = b->data + b->used;
+    memcpy(dst, name, len);
+    b->used += len;
+    return dst;
+}
+
+NameMap *namemap_create(size_t expected) {
+    NameMap *map = calloc(1, sizeof(NameMap));
+    if (!map) return NULL;
+    size_t groups = 1;
+    while (groups * GROUP / 8 * 7 < expected) groups *= 2;
+    if (alloc_tables(map, groups) != 0) { free(map); return NULL; }
+    return map;
+}
+
+/* Slot index holding name, or (size_t)-1 */
+static size_t find_slot(const NameMap *map, const char *name, uint64_t h) {
+    size_t mask = map->groups - 1;
+    size_t g = h1_of(h) & mask;
+    unsigned char tag = h2_of(h);
+    for (size_t step = 1;; ++step) {
+        const unsigned char *ctrl = map->ctrl + g * GROUP;
+        for (unsigned m = match_byte(ctrl, tag); m; m &= m - 1) {
+            size_t i = g * GROUP + lowest_bit(m);
+            if (map->slots[i].hash == h && strcmp(map->slots[i].name, name) == 0)
+                return i;
+        }
+        if (match_byte(ctrl, CTRL_EMPTY)) return (size_t)-1;
+        g = (g + step) & mask;
+    }
+}
+
+int namemap_put(NameMap *map, const char *name, struct MerkleNode *node) {
+    if (!map || !name) return -1;
+    uint64_t h = hash_name(name);
+    size_t i = find_slot(map, name, h);
+    if (i != (size_t)-1) {
+        map->slots[i].node = node;
+        return 0;
+    }
+    if (map->count >= map->limit && grow(map) != 0) return -1;
+    const char *copy = copy_name(map, name);
+    if (!copy) return -1;
+    i = find_empty(map, h);
+    map->ctrl[i] = h2_of(h);
+    map->slots[i].hash = h;
+    map->slots[i].name = copy;
+    map->slots[i].node = node;
+    map->count++;
+    return 0;
+}
+
+struct MerkleNode *namemap_get(const NameMap *map, const char *name) {
+    if (!map || !name) return NULL;
+    size_t i = find_slot(map, name, hash_name(name));
+    return i == (size_t)-1 ? NULL : map->slots[i].node;
+}
+
+size_t namemap_count(const NameMap *map) {
+    return map ? map->count : 0;
+}
+
+size_t namemap_bytes(const NameMap *map) {
+    if (!map) return 0;
+    return sizeof(NameMap) + map->groups * GROUP * (1 + sizeof(Slot)) + map->name_bytes;
+}
+
+void namemap_free(NameMap *map) {
+    if (!map) return;
+    NameBlock *b = map->names;
+    while (b) {
+        NameBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    free(map->ctrl);
+    free(map->slots);
+    free(map);
+}
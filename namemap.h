@@ -0,0 +1,40 @@
+/*
+ * namemap.h
+ *
+ * Filename -> leaf index for the Merkle tree. Open addressing in the style
+ * of a Swiss table: one control byte per slot holding 7 bits of the key's
+ * hash, probed 16 slots at a time, so a lookup usually touches a single
+ * group and compares one full key. The table doubles when it is 7/8 full;
+ * hashes are cached per slot, so growing never rehashes a filename.
+ *
+ * merkle.h includes this header; merkle_name_index() fills a map pre-sized
+ * with the tree's leaf count.
+ */
+
+#ifndef NAMEMAP_H
+#define NAMEMAP_H
+
+#include <stddef.h>
+
+struct MerkleNode;
+typedef struct NameMap NameMap;
+
+/* Create a map sized for 'expected' names without growing (0 = small) */
+NameMap *namemap_create(size_t expected);
+
+/* Map name -> node, replacing an existing entry. The name is copied.
+   Returns 0 on success, -1 if out of memory. */
+int namemap_put(NameMap *map, const char *name, struct MerkleNode *node);
+
+/* Node stored under name, or NULL */
+struct MerkleNode *namemap_get(const NameMap *map, const char *name);
+
+/* Number of names stored */
+size_t namemap_count(const NameMap *map);
+
+/* Bytes held by the slot table, control bytes and copied names */
+size_t namemap_bytes(const NameMap *map);
+
+void namemap_free(NameMap *map);
+
+#endif
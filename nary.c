@@ -1,66 +1,704 @@
-#include "nary.h"
-
-// Create a new node with the given data
-Node* createNode(const char* data) {
-    // Allocate memory for a new Node structure
-    Node* newNode = (Node*)malloc(sizeof(Node));
-    
-    // Copy the input data into the node's data field
-    // Note: Uses strcpy which assumes data fits in 50 chars (potential buffer overflow risk)
-    strcpy(newNode->data, data);
-    
-    // Initialize child count to 0 (no children yet)
-    newNode->childCount = 0;
-    
-    // Initialize all child pointers to NULL (no children connected)
-    for (int i = 0; i < 10; i++)
-        newNode->child[i] = NULL;
-    
-    return newNode;  // Return the newly created node
-}
-
-// Insert a new child node with given data under the specified parent node
-void insertChild(Node* parent, const char* data) {
-    // Check if parent already has maximum allowed children (10)
-    if (parent->childCount >= 10) {
-        printf("Cannot insert more than 10 children for %s\n", parent->data);
-        return;  // Exit early if limit reached
-    }
-    
-    // Create the new child node
-    Node* newChild = createNode(data);
-    
-    // Add the new child to the next available slot in parent's child array
-    // Then increment the childCount (post-increment: use current value, then add 1)
-    parent->child[parent->childCount++] = newChild;
-}
-
-// Search for a node containing the specified key in the tree
-// Uses depth-first search (DFS) recursion to traverse the entire tree
-Node* search(Node* root, const char* key) {
-    // Base case: if current node is NULL, return NULL (not found)
-    if (root == NULL) return NULL;
-    
-    // Check if current node's data matches the search key
-    if (strcmp(root->data, key) == 0) 
-        return root;  // Found it! Return this node
-    
-    // Recursively search through all children of current node
-    for (int i = 0; i < root->childCount; i++) {
-        Node* found = search(root->child[i], key);  // Search in each child's subtree
-        if (found != NULL) 
-            return found;  // If found in child subtree, return it immediately
-    }
-    
-    return NULL;  // Key not found in this subtree
-}
-
-// Perform preorder traversal of the tree (Root -> Children)
-// Visits: Current node first, then recursively visits all children
-void traverse(Node* root) {
-    if (root == NULL) return;
-    for (int i = 0; i < root->childCount; i++) {
-        traverse(root->child[i]);
-    }
-}
-
+#include "nary.h"
+
+// Allocator used by createNode(); NULL means plain malloc/free
+static Arena* nodeArena = NULL;
+
+// Route node allocation through an arena (or back to malloc with NULL)
+void narySetArena(Arena* arena) {
+    nodeArena = arena;
+}
+
+// Allocate / release memory from the arena if attached, else the heap
+static void* naryAlloc(size_t size) {
+    return nodeArena ? arenaAlloc(nodeArena, size) : malloc(size);
+}
+
+static void naryRelease(void* ptr, size_t size) {
+    if (nodeArena)
+        arenaRelease(nodeArena, ptr, size);
+    else
+        free(ptr);
+}
+
+// One slot of the child hash index: cached name hash + child pointer
+typedef struct {
+    unsigned int hash;
+    Node* node;              // NULL marks an empty slot
+} ChildSlot;
+
+// Open-addressing (linear probing) table over a directory's children
+typedef struct ChildIndex {
+    int capacity;            // power of two, kept at least twice childCount
+    ChildSlot slots[];
+} ChildIndex;
+
+// Place a child into the index (the table is never full: load <= 1/2)
+static void indexPut(ChildIndex* index, Node* child) {
+    unsigned int hash = strpoolHash(child->data);
+    int mask = index->capacity - 1;
+    int i = (int)(hash & (unsigned int)mask);
+    while (index->slots[i].node != NULL)
+        i = (i + 1) & mask;
+    index->slots[i].hash = hash;
+    index->slots[i].node = child;
+}
+
+// Take a child out of the index, re-placing the rest of its probe cluster
+// so later lookups do not stop early at the hole
+static void indexRemove(ChildIndex* index, const Node* child) {
+    int mask = index->capacity - 1;
+    int i = (int)(strpoolHash(child->data) & (unsigned int)mask);
+    while (index->slots[i].node != child) {
+        if (index->slots[i].node == NULL) return;
+        i = (i + 1) & mask;
+    }
+    index->slots[i].node = NULL;
+    for (i = (i + 1) & mask; index->slots[i].node != NULL; i = (i + 1) & mask) {
+        Node* moved = index->slots[i].node;
+        index->slots[i].node = NULL;
+        indexPut(index, moved);
+    }
+}
+
+// (Re)build a parent's index with room for at least 2x its children
+static int indexRebuild(Node* parent) {
+    int capacity = 2 * NARY_HASH_THRESHOLD;
+    while (capacity < 2 * (parent->childCount + 1))
+        capacity *= 2;
+
+    size_t bytes = sizeof(ChildIndex) + (size_t)capacity * sizeof(ChildSlot);
+    ChildIndex* index = (ChildIndex*)naryAlloc(bytes);
+    if (index == NULL) return -1;
+    index->capacity = capacity;
+    memset(index->slots, 0, (size_t)capacity * sizeof(ChildSlot));
+
+    for (int i = 0; i < parent->childCount; i++)
+        indexPut(index, parent->child[i]);
+
+    if (parent->index != NULL)
+        naryRelease(parent->index, sizeof(ChildIndex) +
+                    (size_t)parent->index->capacity * sizeof(ChildSlot));
+    parent->index = index;
+    return 0;
+}
+
+// Path index kept up to date by appendChild(); NULL when none is attached
+static PathIndex* activeIndex = NULL;
+static int pathIndexAddTree(PathIndex* index, Node* node);
+static void pathIndexRemoveTree(PathIndex* index, const Node* node);
+
+// Create a new node with the given data
+Node* createNode(const char* data) {
+    // Allocate memory for a new Node structure (from the arena if attached)
+    Node* newNode = (Node*)naryAlloc(sizeof(Node));
+    if (newNode == NULL) return NULL;
+    
+    // Point the node at the shared interned copy of its name
+    // (any length; repeated names like "file1.txt" are stored only once)
+    newNode->data = strpoolIntern(data);
+    if (newNode->data == NULL) {
+        naryRelease(newNode, sizeof(Node));
+        return NULL;
+    }
+    
+    // No children yet: the child array and hash index are allocated lazily
+    newNode->child = NULL;
+    newNode->childCount = 0;
+    newNode->childCapacity = 0;
+    newNode->index = NULL;
+    newNode->parent = NULL;
+
+    // No digest yet: it is computed on first use by naryDigest()
+    newNode->content = 0;
+    newNode->digest = 0;
+    newNode->dirty = 1;
+
+    // A new node is a single empty file
+    newNode->size = 0;
+    newNode->files = 1;
+    newNode->bytes = 0;
+    newNode->height = 0;
+    
+    return newNode;  // Return the newly created node
+}
+
+// Mark 'node' and its ancestors dirty, up to the first one already dirty
+static void markDirty(Node* node) {
+    while (node != NULL && !node->dirty) {
+        node->dirty = 1;
+        node = node->parent;
+    }
+}
+
+// Add a change in files / bytes to 'node' and every ancestor, raising
+// heights along the way ('height' is the new height of 'node' at most)
+static void addAggregates(Node* node, size_t files, uint64_t bytes, int height) {
+    for (; node != NULL; node = node->parent, height++) {
+        node->files += files;
+        node->bytes += bytes;
+        if (node->height < height) node->height = height;
+    }
+}
+
+// Attach an existing node as the last child of 'parent'
+// On failure nothing is linked: 'parent', its indexes and aggregates are unchanged
+int appendChild(Node* parent, Node* child) {
+    // Grow the child array by doubling when it is full
+    if (parent->childCount == parent->childCapacity) {
+        int newCapacity = parent->childCapacity ? 2 * parent->childCapacity : 4;
+        Node** grown = (Node**)naryAlloc((size_t)newCapacity * sizeof(Node*));
+        if (grown == NULL) return -1;
+        if (parent->childCount > 0)
+            memcpy(grown, parent->child, (size_t)parent->childCount * sizeof(Node*));
+        if (parent->child != NULL)
+            naryRelease(parent->child, (size_t)parent->childCapacity * sizeof(Node*));
+        parent->child = grown;
+        parent->childCapacity = newCapacity;
+    }
+
+    // Keep the hash index at load factor <= 1/2 once the fanout is large
+    // (an index outlives removals that shrink the directory, so keep it current)
+    int hashed = parent->index != NULL || parent->childCount + 1 > NARY_HASH_THRESHOLD;
+    if (hashed && (parent->index == NULL || 2 * (parent->childCount + 1) > parent->index->capacity)) {
+        if (indexRebuild(parent) != 0) return -1;
+    }
+
+    // Register the new node (and anything already below it) in the path index
+    // before linking it, so a failure can be undone without touching 'parent'
+    Node* oldParent = child->parent;
+    child->parent = parent;
+    if (activeIndex != NULL && pathIndexAddTree(activeIndex, child) != 0) {
+        pathIndexRemoveTree(activeIndex, child);
+        child->parent = oldParent;
+        return -1;
+    }
+
+    if (hashed) indexPut(parent->index, child);
+
+    // A file that gets its first child stops counting as a file itself
+    size_t files = child->files - (parent->childCount == 0);
+    parent->child[parent->childCount++] = child;
+    addAggregates(parent, files, child->bytes, child->height + 1);
+    markDirty(parent);
+    return 0;
+}
+
+// Find the direct child whose interned name handle is 'name'
+static Node* findChildInterned(const Node* parent, const char* name) {
+    if (parent->index != NULL) {
+        // Hashed lookup: the hash is stored with the interned name
+        unsigned int hash = strpoolHash(name);
+        int mask = parent->index->capacity - 1;
+        for (int i = (int)(hash & (unsigned int)mask); parent->index->slots[i].node != NULL;
+             i = (i + 1) & mask) {
+            if (parent->index->slots[i].node->data == name)
+                return parent->index->slots[i].node;
+        }
+        return NULL;
+    }
+
+    // Small directory: a linear scan of handle comparisons is cheapest
+    for (int i = 0; i < parent->childCount; i++)
+        if (parent->child[i]->data == name)
+            return parent->child[i];
+    return NULL;
+}
+
+// Find the direct child of 'parent' whose name equals 'name'
+Node* findChild(const Node* parent, const char* name) {
+    // A name that was never interned cannot belong to any node
+    const char* handle = strpoolFind(name);
+    return handle ? findChildInterned(parent, handle) : NULL;
+}
+
+// Insert a new child node with given data under the specified parent node
+Node* insertChild(Node* parent, const char* data) {
+    // Create the new child node
+    Node* newChild = createNode(data);
+    if (newChild == NULL) return NULL;
+    
+    // Add the new child after the existing ones (the array grows as needed)
+    if (appendChild(parent, newChild) != 0) {
+        printf("Cannot insert child %s under %s: out of memory\n", data, parent->data);
+        freeTree(newChild);
+        return NULL;
+    }
+    return newChild;
+}
+
+// Detach a child, fix the ancestors' aggregates, then free the subtree
+int removeChild(Node* parent, const char* name) {
+    Node* child = findChild(parent, name);
+    if (child == NULL) return -1;
+
+    // Drop the subtree's paths while its parent pointers still lead to the root
+    if (activeIndex != NULL)
+        pathIndexRemoveTree(activeIndex, child);
+    if (parent->index != NULL)
+        indexRemove(parent->index, child);
+
+    // Close the gap, keeping the remaining children in order
+    int pos = 0;
+    while (parent->child[pos] != child) pos++;
+    memmove(parent->child + pos, parent->child + pos + 1,
+            (size_t)(parent->childCount - pos - 1) * sizeof(Node*));
+    parent->childCount--;
+
+    // Subtract the subtree; an emptied directory counts as a file again
+    size_t files = child->files - (parent->childCount == 0);
+    for (Node* n = parent; n != NULL; n = n->parent) {
+        n->files -= files;
+        n->bytes -= child->bytes;
+    }
+
+    // Heights only drop if the removed child was on the deepest path
+    if (child->height + 1 == parent->height) {
+        for (Node* n = parent; n != NULL; n = n->parent) {
+            int height = 0;
+            for (int i = 0; i < n->childCount; i++)
+                if (n->child[i]->height + 1 > height)
+                    height = n->child[i]->height + 1;
+            if (height == n->height) break;
+            n->height = height;
+        }
+    }
+    markDirty(parent);
+
+    child->parent = NULL;
+    freeTree(child);
+    return 0;
+}
+
+// DFS for a node whose interned name handle equals 'key'
+static Node* searchInterned(Node* root, const char* key) {
+    // Base case: if current node is NULL, return NULL (not found)
+    if (root == NULL) return NULL;
+    
+    // Names are interned, so equal names have equal pointers
+    if (root->data == key) 
+        return root;  // Found it! Return this node
+    
+    // Recursively search through all children of current node
+    for (int i = 0; i < root->childCount; i++) {
+        Node* found = searchInterned(root->child[i], key);  // Search in each child's subtree
+        if (found != NULL) 
+            return found;  // If found in child subtree, return it immediately
+    }
+    
+    return NULL;  // Key not found in this subtree
+}
+
+// Search for a node containing the specified key in the tree
+// Uses depth-first search (DFS) recursion to traverse the entire tree
+Node* search(Node* root, const char* key) {
+    // Intern lookup once; a key that was never interned is in no tree
+    const char* handle = strpoolFind(key);
+    return handle ? searchInterned(root, handle) : NULL;
+}
+
+// Perform preorder traversal of the tree (Root -> Children)
+// Visits: Current node first, then recursively visits all children
+void traverse(Node* root) {
+    if (root == NULL) return;
+    for (int i = 0; i < root->childCount; i++) {
+        traverse(root->child[i]);
+    }
+}
+
+
+// Finalizer of splitmix64: spreads every input bit over the whole word
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// 64-bit FNV-1a over an interned name
+static uint64_t nameHash64(const char* name) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    size_t len = strpoolLength(name);
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)name[i]) * 0x100000001b3ull;
+    return h;
+}
+
+void narySetSize(Node* node, uint64_t bytes) {
+    // Unsigned wraparound makes a shrinking file a negative difference
+    addAggregates(node, 0, bytes - node->size, 0);
+    node->size = bytes;
+}
+
+void narySetContent(Node* node, uint64_t content) {
+    node->content = content;
+    node->dirty = 0;         // force the walk up even if it was already dirty
+    markDirty(node);
+}
+
+// Rehash the dirty part of the subtree; clean children are read, not entered
+uint64_t naryDigest(Node* node) {
+    if (!node->dirty) return node->digest;
+
+    // Summing mixed child digests makes the result independent of child order
+    uint64_t children = 0;
+    for (int i = 0; i < node->childCount; i++)
+        children += mix64(naryDigest(node->child[i]));
+
+    node->digest = mix64(nameHash64(node->data) ^ mix64(node->content + 0x9e3779b97f4a7c15ull)
+                         ^ mix64(children ^ (uint64_t)node->childCount));
+    node->dirty = 0;
+    return node->digest;
+}
+
+typedef struct {
+    void (*report)(const Node* a, const Node* b, void* ctx);
+    void* ctx;
+    size_t found;
+} DiffCtx;
+
+static void diffReport(DiffCtx* d, const Node* a, const Node* b) {
+    d->found++;
+    if (d->report) d->report(a, b, d->ctx);
+}
+
+// Descend only where digests differ; children are matched by name
+static void diffNodes(Node* a, Node* b, DiffCtx* d) {
+    if (naryDigest(a) == naryDigest(b)) return;
+    if (a->content != b->content)
+        diffReport(d, a, b);
+    for (int i = 0; i < a->childCount; i++) {
+        Node* other = findChildInterned(b, a->child[i]->data);
+        if (other == NULL)
+            diffReport(d, a->child[i], NULL);
+        else
+            diffNodes(a->child[i], other, d);
+    }
+    for (int i = 0; i < b->childCount; i++)
+        if (findChildInterned(a, b->child[i]->data) == NULL)
+            diffReport(d, NULL, b->child[i]);
+}
+
+size_t naryDiff(Node* a, Node* b,
+                void (*report)(const Node* a, const Node* b, void* ctx), void* ctx) {
+    DiffCtx d = { report, ctx, 0 };
+    diffNodes(a, b, &d);
+    return d.found;
+}
+
+// Free a node and all of its descendants (postorder)
+void freeTree(Node* root) {
+    if (root == NULL) return;
+    for (int i = 0; i < root->childCount; i++)
+        freeTree(root->child[i]);
+
+    // Arena memory goes back to the arena's free lists; heap memory to free()
+    if (root->index != NULL)
+        naryRelease(root->index, sizeof(ChildIndex) +
+                    (size_t)root->index->capacity * sizeof(ChildSlot));
+    if (root->child != NULL)
+        naryRelease(root->child, (size_t)root->childCapacity * sizeof(Node*));
+    naryRelease(root, sizeof(Node));
+}
+
+// Resolve "/a/b/c" by walking one component at a time from 'root'
+Node* resolvePath(Node* root, const char* path) {
+    Node* curr = root;
+
+    while (curr != NULL && *path != '\0') {
+        // Skip separators, then look the next component up in place
+        while (*path == '/') path++;
+        if (*path == '\0') break;
+        size_t len = strcspn(path, "/");
+        const char* name = strpoolFindN(path, len);
+        if (name == NULL) return NULL;  // no node has this name
+        path += len;
+
+        curr = findChildInterned(curr, name);
+    }
+    return curr;
+}
+
+// Build the absolute path of 'node' by walking parent pointers to the root
+int nodePath(const Node* node, char* buf, size_t size) {
+    if (size == 0) return -1;
+
+    // Measure first so the path can be written right to left in one pass
+    size_t len = 0;
+    for (const Node* n = node; n->parent != NULL; n = n->parent)
+        len += 1 + strpoolLength(n->data);
+    if (len == 0) len = 1;                  // the root itself is "/"
+    if (len + 1 > size) return -1;
+
+    buf[len] = '\0';
+    buf[0] = '/';
+    size_t pos = len;
+    for (const Node* n = node; n->parent != NULL; n = n->parent) {
+        size_t nameLen = strpoolLength(n->data);
+        pos -= nameLen;
+        memcpy(buf + pos, n->data, nameLen);
+        buf[--pos] = '/';
+    }
+    return (int)len;
+}
+
+// Full path of 'node' in a malloc'd string sized to fit (NULL if out of
+// memory); *len gets its length. Names are unbounded, so paths are too
+static char* nodePathDup(const Node* node, size_t* len) {
+    size_t size = 2;                        // "/" for the root, and the NUL
+    for (const Node* n = node; n->parent != NULL; n = n->parent)
+        size += 1 + strpoolLength(n->data);
+    char* path = (char*)malloc(size);
+    if (path == NULL) return NULL;
+    *len = (size_t)nodePath(node, path, size);
+    return path;
+}
+
+// One slot of the path index: cached hash, owned key, node
+typedef struct {
+    unsigned int hash;
+    char* path;              // NULL marks an empty slot
+    Node* node;
+} PathSlot;
+
+struct PathIndex {
+    Node* root;              // tree the index describes
+    size_t count;
+    size_t capacity;         // power of two, load factor kept <= 1/2
+    PathSlot* slots;
+};
+
+// Count the nodes in a subtree
+static size_t countNodes(const Node* node) {
+    size_t total = 1;
+    for (int i = 0; i < node->childCount; i++)
+        total += countNodes(node->child[i]);
+    return total;
+}
+
+// Insert a (hash, path) entry into a table known to have a free slot
+static void pathSlotPut(PathSlot* slots, size_t capacity, PathSlot entry) {
+    size_t mask = capacity - 1;
+    size_t i = entry.hash & mask;
+    while (slots[i].path != NULL)
+        i = (i + 1) & mask;
+    slots[i] = entry;
+}
+
+// Double the table when it would pass a load factor of 1/2
+static int pathIndexReserve(PathIndex* index, size_t needed) {
+    if (2 * needed <= index->capacity) return 0;
+    size_t capacity = index->capacity ? index->capacity : 64;
+    while (2 * needed > capacity) capacity *= 2;
+
+    PathSlot* slots = (PathSlot*)calloc(capacity, sizeof(PathSlot));
+    if (slots == NULL) return -1;
+    for (size_t i = 0; i < index->capacity; i++)
+        if (index->slots[i].path != NULL)
+            pathSlotPut(slots, capacity, index->slots[i]);
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = capacity;
+    return 0;
+}
+
+// Add one node under its full path (nodes outside index->root are ignored)
+static int pathIndexAdd(PathIndex* index, Node* node) {
+    const Node* top = node;
+    while (top->parent != NULL) top = top->parent;
+    if (top != index->root) return 0;
+
+    if (pathIndexReserve(index, index->count + 1) != 0) return -1;
+
+    PathSlot entry;
+    size_t len;
+    entry.path = nodePathDup(node, &len);
+    if (entry.path == NULL) return -1;
+    entry.hash = strpoolHashN(entry.path, len);
+    entry.node = node;
+    pathSlotPut(index->slots, index->capacity, entry);
+    index->count++;
+    return 0;
+}
+
+// Add a node and all of its descendants
+static int pathIndexAddTree(PathIndex* index, Node* node) {
+    if (pathIndexAdd(index, node) != 0) return -1;
+    for (int i = 0; i < node->childCount; i++)
+        if (pathIndexAddTree(index, node->child[i]) != 0) return -1;
+    return 0;
+}
+
+// Empty slot 'i' and re-place the rest of its probe cluster
+static void pathSlotDelete(PathIndex* index, size_t i) {
+    size_t mask = index->capacity - 1;
+    free(index->slots[i].path);
+    index->slots[i].path = NULL;
+    index->slots[i].node = NULL;
+    index->count--;
+    for (i = (i + 1) & mask; index->slots[i].path != NULL; i = (i + 1) & mask) {
+        PathSlot moved = index->slots[i];
+        index->slots[i].path = NULL;
+        index->slots[i].node = NULL;
+        pathSlotPut(index->slots, index->capacity, moved);
+    }
+}
+
+// Remove one node's entry (nodes not in the index are ignored)
+static void pathIndexRemove(PathIndex* index, const Node* node) {
+    if (index->capacity == 0) return;
+    size_t len;
+    char* path = nodePathDup(node, &len);
+    if (path == NULL) {
+        // Cannot rehash the key: find the entry by node instead
+        for (size_t i = 0; i < index->capacity; i++)
+            if (index->slots[i].path != NULL && index->slots[i].node == node) {
+                pathSlotDelete(index, i);
+                return;
+            }
+        return;
+    }
+    unsigned int hash = strpoolHashN(path, len);
+    free(path);
+
+    size_t mask = index->capacity - 1;
+    size_t i = hash & mask;
+    // An empty slot ends the cluster, whatever node it last held
+    for (; index->slots[i].path != NULL; i = (i + 1) & mask)
+        if (index->slots[i].node == node) {
+            pathSlotDelete(index, i);
+            return;
+        }
+}
+
+// Remove a node and all of its descendants (nodes outside index->root are ignored)
+static void pathIndexRemoveTree(PathIndex* index, const Node* node) {
+    pathIndexRemove(index, node);
+    for (int i = 0; i < node->childCount; i++)
+        pathIndexRemoveTree(index, node->child[i]);
+}
+
+// Index every node of the tree under 'root' by its full path
+PathIndex* pathIndexCreate(Node* root, size_t expectedNodes) {
+    PathIndex* index = (PathIndex*)calloc(1, sizeof(PathIndex));
+    if (index == NULL) return NULL;
+    index->root = root;
+    if (expectedNodes == 0) expectedNodes = countNodes(root);
+    if (pathIndexReserve(index, expectedNodes) != 0 || pathIndexAddTree(index, root) != 0) {
+        pathIndexFree(index);
+        return NULL;
+    }
+    return index;
+}
+
+// Look up a full path: hash once, then compare cached hashes while probing
+Node* pathIndexLookup(const PathIndex* index, const char* path) {
+    if (index == NULL || index->capacity == 0) return NULL;
+    unsigned int hash = strpoolHashN(path, strlen(path));
+    size_t mask = index->capacity - 1;
+    for (size_t i = hash & mask; index->slots[i].path != NULL; i = (i + 1) & mask) {
+        if (index->slots[i].hash == hash && strcmp(index->slots[i].path, path) == 0)
+            return index->slots[i].node;
+    }
+    return NULL;
+}
+
+// Free the index and the path strings it owns
+void pathIndexFree(PathIndex* index) {
+    if (index == NULL) return;
+    if (activeIndex == index) activeIndex = NULL;
+    for (size_t i = 0; i < index->capacity; i++)
+        free(index->slots[i].path);
+    free(index->slots);
+    free(index);
+}
+
+// Attach (or detach with NULL) the index that appendChild() keeps current
+void narySetPathIndex(PathIndex* index) {
+    activeIndex = index;
+}
+
+// Freeze the tree into preorder arrays using an explicit stack
+FlatTree* freezeTree(const Node* root) {
+    if (root == NULL) return NULL;
+    int count = (int)countNodes(root);
+
+    FlatTree* flat = (FlatTree*)calloc(1, sizeof(FlatTree));
+    const Node** stack = (const Node**)malloc((size_t)count * sizeof(Node*));
+    int* stackParent = (int*)malloc((size_t)count * sizeof(int));
+    if (flat != NULL) {
+        flat->count = count;
+        flat->parent = (int*)malloc((size_t)count * sizeof(int));
+        flat->firstChild = (int*)malloc((size_t)count * sizeof(int));
+        flat->subtreeSize = (int*)malloc((size_t)count * sizeof(int));
+        flat->name = (const char**)malloc((size_t)count * sizeof(const char*));
+    }
+    if (flat == NULL || stack == NULL || stackParent == NULL || flat->parent == NULL ||
+        flat->firstChild == NULL || flat->subtreeSize == NULL || flat->name == NULL) {
+        free(stack);
+        free(stackParent);
+        freeFlatTree(flat);
+        return NULL;
+    }
+
+    // Preorder: pop a node, give it the next index, push children reversed
+    int top = 0, next = 0;
+    stack[top] = root;
+    stackParent[top++] = -1;
+    while (top > 0) {
+        const Node* node = stack[--top];
+        int parent = stackParent[top];
+        int i = next++;
+        flat->parent[i] = parent;
+        flat->name[i] = node->data;
+        flat->subtreeSize[i] = 1;
+        for (int c = node->childCount - 1; c >= 0; c--) {
+            stack[top] = node->child[c];
+            stackParent[top++] = i;
+        }
+    }
+
+    // Children always follow their parent, so one backward pass sums sizes
+    for (int i = count - 1; i > 0; i--)
+        flat->subtreeSize[flat->parent[i]] += flat->subtreeSize[i];
+    for (int i = 0; i < count; i++)
+        flat->firstChild[i] = flat->subtreeSize[i] > 1 ? i + 1 : -1;
+
+    free(stack);
+    free(stackParent);
+    return flat;
+}
+
+void freeFlatTree(FlatTree* flat) {
+    if (flat == NULL) return;
+    free(flat->parent);
+    free(flat->firstChild);
+    free(flat->subtreeSize);
+    free(flat->name);
+    free(flat);
+}
+
+// A subtree is a contiguous index range, so a scan is a plain loop
+void flatScan(const FlatTree* flat, int node,
+              void (*visit)(const FlatTree* flat, int i, void* ctx), void* ctx) {
+    int end = node + flat->subtreeSize[node];
+    for (int i = node; i < end; i++)
+        visit(flat, i, ctx);
+}
+
+// Linear scan of the name array comparing interned handles
+int flatSearch(const FlatTree* flat, const char* key) {
+    const char* handle = strpoolFind(key);
+    if (handle == NULL) return -1;
+    for (int i = 0; i < flat->count; i++)
+        if (flat->name[i] == handle)
+            return i;
+    return -1;
+}
+
+// Sum name lengths over the subtree's index range
+size_t flatNameBytes(const FlatTree* flat, int node) {
+    size_t total = 0;
+    int end = node + flat->subtreeSize[node];
+    for (int i = node; i < end; i++)
+        total += strpoolLength(flat->name[i]);
+    return total;
+}
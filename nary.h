@@ -1,43 +1,167 @@
-// Header guard - prevents this file from being included multiple times
-// This avoids duplicate definition errors during compilation
-#ifndef NARY_H
-#define NARY_H
-
-// Standard C library includes:
-#include <stdio.h>   // For input/output functions (printf, etc.)
-#include <stdlib.h>  // For memory allocation (malloc, free) and other utilities
-#include <string.h>  // For string manipulation functions (strcpy, strcmp, etc.)
-#include <time.h>   // for clock()
-
-// N-ary Tree Node structure definition
-// Each node in our tree can store data and have multiple children
-typedef struct Node {
-    char data[50];           // Stores the node's content (filename or other data)
-                             // Fixed size of 50 characters for simplicity
-    
-    struct Node *child[10];  // Array of pointers to child nodes
-                             // Maximum of 10 children per node for simplicity
-                             // This limits the tree's branching factor
-    
-    int childCount;          // Tracks how many children this node currently has
-                             // Helps know which positions in 'child' array are used
-} Node;
-
-// Function declarations (prototypes) - these tell the compiler what functions exist
-// Actual implementation will be in nary.c
-
-// Creates and returns a new node with the given data
-Node* createNode(const char* data);
-
-// Adds a new child node with the given data to the specified parent node
-void insertChild(Node* parent, const char* data);
-
-// Searches the entire tree starting from 'root' for a node containing 'key'
-// Returns pointer to the node if found, NULL otherwise
-Node* search(Node* root, const char* key);
-
-// Traverses and prints all nodes in the tree starting from 'root'
-// uses depth-first traversal to visit all nodes
-void traverse(Node* root);
-
-#endif // End of header guard
+// Header guard - prevents this file from being included multiple times
+// This avoids duplicate definition errors during compilation
+#ifndef NARY_H
+#define NARY_H
+
+// Standard C library includes:
+#include <stdio.h>   // For input/output functions (printf, etc.)
+#include <stdlib.h>  // For memory allocation (malloc, free) and other utilities
+#include <string.h>  // For string manipulation functions (strcpy, strcmp, etc.)
+#include <stdint.h>  // for the 64-bit subtree digests
+#include <time.h>   // for clock()
+#include "arena.h"  // optional arena/slab allocator for nodes
+#include "strpool.h" // shared interning pool for node names
+
+// Fanout above which a directory also keeps a hash index over its children
+// Below it, a linear scan of a few names is faster than hashing
+#define NARY_HASH_THRESHOLD 16
+
+// Per-directory hash index over child names (defined in nary.c)
+struct ChildIndex;
+
+// N-ary Tree Node structure definition
+// Each node in our tree can store data and have multiple children
+typedef struct Node {
+    const char *data;        // Stores the node's content (filename or other data)
+                             // Interned handle from strpool: any length, shared
+                             // between equal names and compared with ==
+    
+    struct Node **child;     // Growable array of pointers to child nodes
+                             // Doubles in size when full, so fanout is unbounded
+    
+    int childCount;          // Tracks how many children this node currently has
+                             // Helps know which positions in 'child' array are used
+
+    int childCapacity;       // Number of slots currently allocated in 'child'
+
+    struct ChildIndex *index; // Name -> child hash index, built once childCount
+                              // exceeds NARY_HASH_THRESHOLD (NULL before that)
+
+    struct Node *parent;     // Directory containing this node (NULL for root)
+
+    uint64_t content;        // Digest of a file's content (narySetContent), 0 = none
+
+    uint64_t digest;         // Hash of the name, content and every child's digest
+                             // Only valid while 'dirty' is clear (see naryDigest)
+
+    int dirty;               // Set on a change here or below; every ancestor of a
+                             // dirty node is dirty too, so marking stops early
+
+    uint64_t size;           // Bytes of this file (narySetSize), 0 by default
+
+    // Subtree aggregates, kept current on every insert, removal and resize
+    // by walking the ancestor path, so reading them is O(1)
+    size_t files;            // Files (nodes with no children) in this subtree
+    uint64_t bytes;          // Sum of 'size' over this subtree
+    int height;              // Levels below this node (0 for a file)
+} Node;
+
+// Global full-path -> Node* hash index (defined in nary.c)
+typedef struct PathIndex PathIndex;
+
+// Frozen, read-only snapshot of a tree in preorder struct-of-arrays form
+// Node i's subtree occupies indices [i, i + subtreeSize[i]), its first
+// child (if any) is i + 1, and its next sibling is i + subtreeSize[i]
+typedef struct FlatTree {
+    int count;               // number of nodes (index 0 is the root)
+    int *parent;             // preorder index of the parent (-1 for the root)
+    int *firstChild;         // preorder index of the first child (-1 for a leaf)
+    int *subtreeSize;        // nodes in the subtree, including the node itself
+    const char **name;       // interned name handles (see strpool.h)
+} FlatTree;
+
+// Function declarations (prototypes) - these tell the compiler what functions exist
+// Actual implementation will be in nary.c
+
+// Creates and returns a new node with the given data
+Node* createNode(const char* data);
+
+// Adds a new child node with the given data to the specified parent node
+// Returns the new child (NULL if memory could not be allocated)
+Node* insertChild(Node* parent, const char* data);
+
+// Attaches an already created node as the last child of 'parent'
+// Returns 0 on success, -1 if memory could not be allocated
+int appendChild(Node* parent, Node* child);
+
+// Detaches the child named 'name' from 'parent' and frees it with everything
+// below it, updating the aggregates and digests of every ancestor
+// Returns 0 on success, -1 if 'parent' has no such child
+int removeChild(Node* parent, const char* name);
+
+// Finds the direct child of 'parent' named 'name'
+// Uses the hash index when present (O(1) expected), else a linear scan
+Node* findChild(const Node* parent, const char* name);
+
+// Searches the entire tree starting from 'root' for a node containing 'key'
+// Returns pointer to the node if found, NULL otherwise
+Node* search(Node* root, const char* key);
+
+// Traverses and prints all nodes in the tree starting from 'root'
+// uses depth-first traversal to visit all nodes
+void traverse(Node* root);
+
+// Resolves an absolute path such as "/a/b/c" below 'root' one component
+// at a time ("/" is the root itself). Returns NULL if any component is missing
+Node* resolvePath(Node* root, const char* path);
+
+// Writes the absolute path of 'node' (relative to its tree root) into 'buf'
+// Returns the path length, or -1 if it does not fit in 'size' bytes
+int nodePath(const Node* node, char* buf, size_t size);
+
+// Builds an open-addressing index from full path to node for the tree under
+// 'root'; 'expectedNodes' pre-sizes the table (0 = count the tree)
+PathIndex* pathIndexCreate(Node* root, size_t expectedNodes);
+
+// Looks up a full path in the index in O(1) expected time
+Node* pathIndexLookup(const PathIndex* index, const char* path);
+
+// Frees the index (the tree itself is left untouched)
+void pathIndexFree(PathIndex* index);
+
+// Makes insertChild()/appendChild() keep 'index' up to date (NULL detaches)
+void narySetPathIndex(PathIndex* index);
+
+// Converts the tree under 'root' into a FlatTree (NULL on allocation failure)
+FlatTree* freezeTree(const Node* root);
+
+// Frees a FlatTree created by freezeTree()
+void freeFlatTree(FlatTree* flat);
+
+// Calls visit(flat, i, ctx) for every node in the subtree of 'node', in
+// preorder, as one linear scan of the arrays (no recursion)
+void flatScan(const FlatTree* flat, int node,
+              void (*visit)(const FlatTree* flat, int i, void* ctx), void* ctx);
+
+// Iterative equivalent of search(): returns the preorder index or -1
+int flatSearch(const FlatTree* flat, const char* key);
+
+// Total bytes of the names in the subtree of 'node' (size accounting)
+size_t flatNameBytes(const FlatTree* flat, int node);
+
+// Allocates nodes from 'arena' instead of malloc (NULL restores malloc)
+// With an arena attached, arenaDestroy() frees the whole tree in one call
+void narySetArena(Arena* arena);
+
+// Sets the size of a file node and adds the difference to every ancestor
+void narySetSize(Node* node, uint64_t bytes);
+
+// Sets the content digest of a file node and marks it and its ancestors dirty
+void narySetContent(Node* node, uint64_t content);
+
+// 64-bit digest of the subtree under 'node': names, contents and structure
+// Children are combined order-independently, so two directories with the
+// same entries match however they were built. Only dirty nodes are rehashed
+uint64_t naryDigest(Node* node);
+
+// Compares two trees of the same namespace (e.g. two snapshots) and calls
+// report(a, b, ctx) for each difference: a node only in 'a' (b is NULL), only
+// in 'b' (a is NULL), or in both with different contents. Subtrees whose
+// digests match are skipped without being visited. Returns the differences
+size_t naryDiff(Node* a, Node* b,
+                void (*report)(const Node* a, const Node* b, void* ctx), void* ctx);
+
+// Frees 'root' and every node below it
+void freeTree(Node* root);
+
+#endif // End of header guard
@@ -1,95 +1,675 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include "nary.h"
-
-#define MODULE_NAME "nary"
-#define DEFAULT_NODES 1000
-#define DEFAULT_RUNS 5
-
-/* Simple portable timer (seconds) */
-static double now_seconds(void) {
-    return (double)clock() / CLOCKS_PER_SEC;
-}
-
-/* Build a sample N-ary tree fully in memory */
-Node* build_sample_tree(size_t n) {
-    Node* root = createNode("Root");
-    Node** nodes = malloc(sizeof(Node*) * n);
-    if (!nodes) return root;
-
-    nodes[0] = root;
-    size_t count = 1;
-
-    // Each node gets up to 3 children until we reach 'n' total nodes
-    for (size_t i = 0; i < n && count < n; i++) {
-        for (int j = 0; j < 3 && count < n; j++) {
-            char name[32];
-            snprintf(name, sizeof(name), "Node%zu", count);
-            Node* newNode = createNode(name);
-            nodes[i]->child[nodes[i]->childCount++] = newNode;
-            nodes[count++] = newNode;
-        }
-    }
-
-    free(nodes);
-    return root;
-}
-
-/* Perform one experiment run */
-void run_one(FILE* csv, int run_id, size_t n) {
-    double t0, t1;
-
-    // Build tree
-    t0 = now_seconds();
-    Node* root = build_sample_tree(n);
-    t1 = now_seconds();
-    double build_ms = (t1 - t0) * 1000.0;
-
-    // Traversal
-    t0 = now_seconds();
-    traverse(root); // traversal without printing
-    t1 = now_seconds();
-    double traverse_ms = (t1 - t0) * 1000.0;
-
-    // Search for a specific node
-    t0 = now_seconds();
-    Node* found = search(root, "Node500");
-    t1 = now_seconds();
-    double search_ms = (t1 - t0) * 1000.0;
-
-    const char* result = found ? "found" : "not_found";
-
-    // Write results to CSV
-    fprintf(csv, "%s,%d,%zu,%.3f,%.3f,%.3f,%s\n",
-            MODULE_NAME, run_id, n, build_ms, traverse_ms, search_ms, result);
-    fflush(csv);
-
-    printf("Run %d build complete\n", run_id);
-}
-
-/* Main program */
-int main(int argc, char** argv) {
-    size_t n = DEFAULT_NODES;
-    int runs = DEFAULT_RUNS;
-
-    if (argc >= 2) n = (size_t)atoi(argv[1]);
-    if (argc >= 3) runs = atoi(argv[2]);
-
-    FILE* csv = fopen("results_nary.csv", "w");
-    if (!csv) {
-        perror("Error opening results_nary.csv");
-        return 1;
-    }
-
-    fprintf(csv, "module,run_id,n,build_ms,traverse_ms,search_ms,result\n");
-
-    for (int i = 1; i <= runs; i++) {
-        run_one(csv, i, n);
-    }
-
-    fclose(csv);
-    printf("Results stored in CSV\n");
-    return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nary.h"
+#include "bench.h"
+#include "nsgen.h"
+
+#define MODULE_NAME "nary"
+#define DEFAULT_NODES 1000
+#define DEFAULT_RUNS 5
+#define DEFAULT_FANOUT 3
+#define DFS_REPS 10        /* full-tree DFS is O(n): keep repetitions low */
+#define LOOKUP_REPS 10000  /* component walk and indexed lookup */
+#define DEFAULT_LOOKUPS 10000
+#define DEFAULT_LOOKUP_REPS 3
+#define DEFAULT_HIT_RATIO 0.5
+#define MISS_NAME "Node1"  /* a real name, but only ever a child of Root */
+#define MAX_FILE_SIZE 65536
+#define DEFAULT_REMOVALS 1000
+
+/* Portable wall-clock timer (seconds) */
+static double now_seconds(void) {
+    return bench_now_ns() / 1e9;
+}
+
+/* Workload knobs and per-op results accumulated across runs */
+typedef struct {
+    size_t lookups;
+    int reps;
+    double hit_ratio;
+    unsigned long long seed;
+    double avg_depth;
+    BenchResult build, walk, indexed, child, teardown;
+    size_t walk_wrong, indexed_wrong, child_wrong;   /* lookups with the wrong answer */
+    size_t diff_changes;                             /* --diff K: 0 = off */
+    BenchResult digest, diff, walk_diff;
+    size_t diff_wrong;                               /* diffs missing or inventing changes */
+    BenchResult agg_read, agg_walk, root_read, root_walk, remove;
+    size_t agg_wrong;                                /* aggregates disagreeing with a walk */
+} BenchTotals;
+
+/* Random real paths (hits) and real names under the wrong directory (misses) */
+typedef struct {
+    char** paths;
+    Node** parents;       /* directory searched for the last component */
+    const char** names;   /* last component */
+    Node** expect;        /* NULL for a miss */
+    size_t count;
+    Node* root;
+    PathIndex* index;
+    size_t wrong;
+} LookupSet;
+
+/* Build a sample N-ary tree fully in memory (each node gets 'fanout' children).
+   Returns NULL if any node cannot be created or linked. */
+Node* build_sample_tree(size_t n, int fanout) {
+    Node* root = createNode("Root");
+    Node** nodes = malloc(sizeof(Node*) * n);
+    if (!root || !nodes) {
+        free(nodes);
+        freeTree(root);
+        return NULL;
+    }
+
+    nodes[0] = root;
+    size_t count = 1;
+
+    // Each node gets up to 'fanout' children until we reach 'n' total nodes
+    for (size_t i = 0; i < n && count < n; i++) {
+        for (int j = 0; j < fanout && count < n; j++) {
+            char name[32];
+            snprintf(name, sizeof(name), "Node%zu", count);
+            Node* newNode = createNode(name);
+            if (!newNode || appendChild(nodes[i], newNode) != 0) {
+                freeTree(newNode);     // never linked, so not reachable from root
+                free(nodes);
+                freeTree(root);
+                return NULL;
+            }
+            nodes[count++] = newNode;
+        }
+    }
+
+    free(nodes);
+    return root;
+}
+
+/* Build a tree from a generated namespace (nsgen.h): each path component
+   becomes a node, directories are shared through findChild(). Returns the
+   root; *nodes gets the node count and *last the node created last. */
+static Node* build_generated_tree(const NsGenConfig* cfg, size_t* nodes, Node** last) {
+    Node* root = createNode("Root");
+    *nodes = 1;
+    *last = root;
+    NsGen* gen = nsgen_create(cfg);
+    if (!root || !gen) {
+        nsgen_free(gen);
+        return root;
+    }
+    char buf[NSGEN_MAX_PATH];
+    const char* path;
+    size_t len;
+    while ((path = nsgen_next(gen, &len)) != NULL) {
+        memcpy(buf, path, len + 1);
+        Node* curr = root;
+        char* comp = buf + 1;                 // skip the leading '/'
+        while (curr && *comp) {
+            char* slash = strchr(comp, '/');
+            if (slash) *slash = '\0';
+            Node* child = findChild(curr, comp);
+            if (!child) {
+                child = insertChild(curr, comp);
+                if (child) {
+                    (*nodes)++;
+                    *last = child;
+                }
+            }
+            curr = child;
+            comp = slash ? slash + 1 : comp + strlen(comp);
+        }
+    }
+    nsgen_free(gen);
+    return root;
+}
+
+/* Pointer-tree size accounting: total name bytes via recursive DFS */
+static size_t pointer_name_bytes(const Node* node) {
+    size_t total = strpoolLength(node->data);
+    for (int i = 0; i < node->childCount; i++)
+        total += pointer_name_bytes(node->child[i]);
+    return total;
+}
+
+static void free_lookups(LookupSet* set) {
+    for (size_t i = 0; set->paths && i < set->count; i++) free(set->paths[i]);
+    free(set->paths);
+    free(set->parents);
+    free(set->names);
+    free(set->expect);
+}
+
+/* Sample totals->lookups random nodes (never the root) from the first n
+   nodes in breadth-first order, which for build_sample_tree() is the
+   order they were created in */
+static int build_lookups(LookupSet* set, Node* root, size_t n, BenchTotals* totals) {
+    memset(set, 0, sizeof(*set));
+    set->root = root;
+    if (n < 2 || totals->lookups == 0) return -1;
+    Node** order = malloc(sizeof(Node*) * n);
+    set->paths = calloc(totals->lookups, sizeof(char*));
+    set->parents = calloc(totals->lookups, sizeof(Node*));
+    set->names = calloc(totals->lookups, sizeof(char*));
+    set->expect = calloc(totals->lookups, sizeof(Node*));
+    if (!order || !set->paths || !set->parents || !set->names || !set->expect) {
+        free(order);
+        free_lookups(set);
+        return -1;
+    }
+    size_t head = 0, tail = 0;
+    order[tail++] = root;
+    for (; head < tail; head++)
+        for (int i = 0; i < order[head]->childCount && tail < n; i++)
+            order[tail++] = order[head]->child[i];
+
+    uint64_t rng = totals->seed;
+    size_t depth = 0;
+    char buf[4096];
+    for (size_t i = 0; i < totals->lookups; i++) {
+        Node* node = order[1 + bench_rand(&rng) % (tail - 1)];
+        int hit = bench_chance(&rng, totals->hit_ratio);
+        int len = nodePath(node, buf, sizeof(buf) - sizeof(MISS_NAME) - 1);
+        if (len < 0) continue;                       /* deeper than any path buffer */
+        if (!hit) snprintf(buf + len, sizeof(buf) - (size_t)len, "/%s", MISS_NAME);
+        char* path = malloc(strlen(buf) + 1);
+        if (!path) break;
+        strcpy(path, buf);
+        for (const char* c = path; *c; c++) depth += *c == '/';
+        set->paths[set->count] = path;
+        set->parents[set->count] = hit ? node->parent : node;
+        set->names[set->count] = hit ? node->data : MISS_NAME;
+        set->expect[set->count] = hit ? node : NULL;
+        set->count++;
+    }
+    free(order);
+    totals->avg_depth = set->count ? (double)depth / set->count : 0.0;
+    return set->count ? 0 : -1;
+}
+
+static void walk_op(void* ctx, size_t i) {
+    LookupSet* set = ctx;
+    set->wrong += resolvePath(set->root, set->paths[i]) != set->expect[i];
+}
+
+static void index_op(void* ctx, size_t i) {
+    LookupSet* set = ctx;
+    set->wrong += pathIndexLookup(set->index, set->paths[i]) != set->expect[i];
+}
+
+static void child_op(void* ctx, size_t i) {
+    LookupSet* set = ctx;
+    set->wrong += findChild(set->parents[i], set->names[i]) != set->expect[i];
+}
+
+/* Time one lookup workload and fold it into the run totals */
+static void time_lookups(LookupSet* set, bench_op_fn op, const BenchTotals* totals,
+                         BenchResult* into, size_t* wrong) {
+    BenchSpec spec = { set->count, 1, totals->reps, 1, NULL };
+    BenchResult r;
+    set->wrong = 0;
+    bench_run(&spec, op, set, &r);
+    bench_merge(into, &r);
+    *wrong += set->wrong;
+}
+
+/* Breadth-first list of every node under root; *count gets its length */
+static Node** collect_nodes(Node* root, size_t n, size_t* count) {
+    Node** order = malloc(sizeof(Node*) * n);
+    size_t head = 0, tail = 0;
+    if (order) {
+        order[tail++] = root;
+        for (; head < tail; head++)
+            for (int i = 0; i < order[head]->childCount && tail < n; i++)
+                order[tail++] = order[head]->child[i];
+    }
+    *count = tail;
+    return order;
+}
+
+/* Baseline change detection with no digests: visit every pair of nodes */
+static size_t walk_diff(const Node* a, const Node* b) {
+    size_t found = a->content != b->content;
+    for (int i = 0; i < a->childCount; i++) {
+        Node* other = findChild(b, a->child[i]->data);
+        found += other ? walk_diff(a->child[i], other) : 1;
+    }
+    for (int i = 0; i < b->childCount; i++)
+        found += findChild(a, b->child[i]->data) == NULL;
+    return found;
+}
+
+/* Snapshot comparison: build a second copy of the tree, change K nodes in
+   it (content updates and new entries, alternating), then find the changes
+   with naryDiff() and with a full walk. Both must report exactly K. */
+static void run_diff(Node* root, size_t n, int fanout, Arena* arena, BenchTotals* totals,
+                     const NsGenConfig* gen) {
+    BenchResult single;
+    size_t nodes = n;
+    Node* last = NULL;
+    uint64_t rng = totals->seed;
+
+    narySetArena(NULL);   // the copy is freed on its own, before the arena
+    Node* copy = gen ? build_generated_tree(gen, &nodes, &last) : build_sample_tree(n, fanout);
+    size_t count = 0;
+    Node** order = copy ? collect_nodes(copy, nodes, &count) : NULL;
+    size_t changes = totals->diff_changes;
+    if (!order || count < 2) goto done;
+    if (changes > count - 1) changes = count - 1;
+
+    // First digest of a freshly built tree: every node is dirty
+    uint64_t t0 = bench_now_ns();
+    naryDigest(root);
+    bench_single(&single, bench_now_ns() - t0);
+    bench_merge(&totals->digest, &single);
+    naryDigest(copy);
+
+    // One change per stride of the breadth-first order, never the root
+    size_t stride = (count - 1) / changes;
+    for (size_t i = 0; i < changes; i++) {
+        Node* node = order[1 + i * stride + bench_rand(&rng) % stride];
+        if (i % 2 == 0) narySetContent(node, bench_rand(&rng) | 1);
+        else if (!insertChild(node, "diff.added")) totals->diff_wrong++;
+    }
+
+    t0 = bench_now_ns();
+    size_t found = naryDiff(root, copy, NULL, NULL);
+    bench_single(&single, bench_now_ns() - t0);
+    bench_merge(&totals->diff, &single);
+    totals->diff_wrong += found != changes;
+
+    t0 = bench_now_ns();
+    found = walk_diff(root, copy);
+    bench_single(&single, bench_now_ns() - t0);
+    bench_merge(&totals->walk_diff, &single);
+    totals->diff_wrong += found != changes;
+
+done:
+    free(order);
+    freeTree(copy);
+    narySetArena(arena);
+}
+
+/* Directories queried for their file count, byte total and depth */
+typedef struct {
+    Node** dirs;
+    size_t count;
+    size_t wrong;
+    uint64_t sink;        /* keeps the O(1) reads from being optimized away */
+} StatsSet;
+
+/* On-demand aggregates: a full walk of the subtree; returns its height */
+static int walk_stats(const Node* node, size_t* files, uint64_t* bytes) {
+    *bytes += node->size;
+    if (node->childCount == 0) {
+        (*files)++;
+        return 0;
+    }
+    int height = 0;
+    for (int i = 0; i < node->childCount; i++) {
+        int h = walk_stats(node->child[i], files, bytes) + 1;
+        if (h > height) height = h;
+    }
+    return height;
+}
+
+/* 1 if the stored aggregates of 'node' match a walk of its subtree */
+static int stats_agree(const Node* node) {
+    size_t files = 0;
+    uint64_t bytes = 0;
+    int height = walk_stats(node, &files, &bytes);
+    return files == node->files && bytes == node->bytes && height == node->height;
+}
+
+static void agg_read_op(void* ctx, size_t i) {
+    StatsSet* set = ctx;
+    const Node* dir = set->dirs[i];
+    set->sink += dir->files + dir->bytes + (uint64_t)dir->height;
+}
+
+static void agg_walk_op(void* ctx, size_t i) {
+    StatsSet* set = ctx;
+    set->wrong += !stats_agree(set->dirs[i]);
+}
+
+static void remove_op(void* ctx, size_t i) {
+    StatsSet* set = ctx;
+    Node* node = set->dirs[i];
+    set->wrong += removeChild(node->parent, node->data) != 0;
+}
+
+/* Time one query workload over a set of nodes and fold it into the totals */
+static void time_stats(StatsSet* set, bench_op_fn op, int warmup, int reps,
+                       BenchResult* into, size_t* wrong) {
+    BenchSpec spec = { set->count, warmup, reps, 1, NULL };
+    BenchResult r;
+    set->wrong = 0;
+    bench_run(&spec, op, set, &r);
+    bench_merge(into, &r);
+    *wrong += set->wrong;
+}
+
+/* Subtree aggregates: give every file a size, then answer "files, bytes and
+   depth under this directory" from the stored counters and by walking, for
+   the root and for random directories. Finally remove files and check the
+   root's counters against a walk. */
+static void run_aggregates(Node* root, size_t n, BenchTotals* totals) {
+    uint64_t rng = totals->seed;
+    size_t count = 0, dirs = 0;
+    Node** order = collect_nodes(root, n, &count);
+    StatsSet set = { NULL, 0, 0, 0 };
+    if (!order || count < 2) goto done;
+
+    for (size_t i = 0; i < count; i++) {
+        if (order[i]->childCount == 0)
+            narySetSize(order[i], bench_rand(&rng) % MAX_FILE_SIZE);
+        else
+            order[dirs++] = order[i];     // directories, in place
+    }
+
+    // The whole tree: the worst case for a walk
+    Node* roots[DFS_REPS];
+    for (int i = 0; i < DFS_REPS; i++) roots[i] = root;
+    set.dirs = roots;
+    set.count = DFS_REPS;
+    time_stats(&set, agg_read_op, 1, 1, &totals->root_read, &totals->agg_wrong);
+    time_stats(&set, agg_walk_op, 1, 1, &totals->root_walk, &totals->agg_wrong);
+
+    // Random directories
+    set.dirs = malloc(sizeof(Node*) * (totals->lookups ? totals->lookups : 1));
+    if (!set.dirs) goto done;
+    set.count = totals->lookups;
+    for (size_t i = 0; i < set.count; i++)
+        set.dirs[i] = order[bench_rand(&rng) % dirs];
+    if (set.count) {
+        time_stats(&set, agg_read_op, 1, totals->reps, &totals->agg_read, &totals->agg_wrong);
+        time_stats(&set, agg_walk_op, 1, totals->reps, &totals->agg_walk, &totals->agg_wrong);
+    }
+    free(set.dirs);
+
+    // Remove distinct files, one per stride of the breadth-first order
+    set.dirs = collect_nodes(root, n, &count);
+    if (!set.dirs) goto done;
+    size_t files = 0;
+    for (size_t i = 1; i < count; i++)
+        if (set.dirs[i]->childCount == 0) set.dirs[files++] = set.dirs[i];
+    size_t removals = files < DEFAULT_REMOVALS ? files : DEFAULT_REMOVALS;
+    size_t stride = removals ? files / removals : 0;
+    for (size_t i = 0; i < removals; i++)
+        set.dirs[i] = set.dirs[i * stride + bench_rand(&rng) % stride];
+    set.count = removals;
+    if (removals)
+        time_stats(&set, remove_op, 0, 1, &totals->remove, &totals->agg_wrong);
+    totals->agg_wrong += !stats_agree(root);
+    free(set.dirs);
+
+done:
+    free(order);
+}
+
+/* Perform one experiment run (optionally allocating nodes from an arena) */
+void run_one(FILE* csv, int run_id, size_t n, int fanout, int use_arena, BenchTotals* totals,
+             const NsGenConfig* gen) {
+    double t0, t1;
+    Arena* arena = use_arena ? arenaCreate(ARENA_DEFAULT_BLOCK) : NULL;
+    narySetArena(arena);
+
+    // Build tree: NodeK names with a fixed fanout, or a generated namespace
+    size_t nodes = n;
+    Node* last = NULL;
+    t0 = now_seconds();
+    Node* root = gen ? build_generated_tree(gen, &nodes, &last) : build_sample_tree(n, fanout);
+    t1 = now_seconds();
+    if (!root) {
+        fprintf(stderr, "Run %d: out of memory building the tree\n", run_id);
+        arenaDestroy(arena);
+        narySetArena(NULL);
+        return;
+    }
+    double build_ms = (t1 - t0) * 1000.0;
+    BenchResult single;
+    bench_single(&single, (uint64_t)((t1 - t0) * 1e9));
+    bench_merge(&totals->build, &single);
+
+    // Traversal
+    t0 = now_seconds();
+    traverse(root); // traversal without printing
+    t1 = now_seconds();
+    double traverse_ms = (t1 - t0) * 1000.0;
+
+    // Search for a specific node
+    t0 = now_seconds();
+    Node* found = search(root, gen ? last->data : "Node500");
+    t1 = now_seconds();
+    double search_ms = (t1 - t0) * 1000.0;
+
+    const char* result = found ? "found" : "not_found";
+
+    // Resolve every child name of the root: one path component per lookup
+    t0 = now_seconds();
+    int hits = 0;
+    for (int i = 0; i < root->childCount; i++)
+        hits += findChild(root, root->child[i]->data) != NULL;
+    t1 = now_seconds();
+    double child_lookup_ns = root->childCount
+        ? (t1 - t0) * 1e9 / root->childCount : 0.0;
+    if (hits != root->childCount) result = "lookup_error";
+
+    // Point lookup of the last node three ways: DFS, component walk, index
+    char target_name[128], target_path[4096];
+    if (gen) snprintf(target_name, sizeof(target_name), "%s", last->data);
+    else if (n > 1) snprintf(target_name, sizeof(target_name), "Node%zu", n - 1);
+    else snprintf(target_name, sizeof(target_name), "Root");
+    Node* target = search(root, target_name);
+    if (!target || nodePath(target, target_path, sizeof(target_path)) < 0) {
+        target_path[0] = '\0';
+        result = "lookup_error";
+    }
+
+    int ok = 0;
+    t0 = now_seconds();
+    for (int r = 0; r < DFS_REPS; r++)
+        ok += search(root, target_name) == target;
+    t1 = now_seconds();
+    double dfs_ns = (t1 - t0) * 1e9 / DFS_REPS;
+
+    t0 = now_seconds();
+    for (int r = 0; r < LOOKUP_REPS; r++)
+        ok += resolvePath(root, target_path) == target;
+    t1 = now_seconds();
+    double walk_ns = (t1 - t0) * 1e9 / LOOKUP_REPS;
+
+    t0 = now_seconds();
+    PathIndex* index = pathIndexCreate(root, nodes);
+    t1 = now_seconds();
+    double index_build_ms = (t1 - t0) * 1000.0;
+
+    t0 = now_seconds();
+    for (int r = 0; r < LOOKUP_REPS; r++)
+        ok += pathIndexLookup(index, target_path) == target;
+    t1 = now_seconds();
+    double indexed_ns = (t1 - t0) * 1e9 / LOOKUP_REPS;
+
+    // Random hit/miss workload: component walk, path index, single findChild
+    LookupSet set;
+    if (build_lookups(&set, root, nodes, totals) == 0) {
+        set.index = index;
+        time_lookups(&set, walk_op, totals, &totals->walk, &totals->walk_wrong);
+        time_lookups(&set, index_op, totals, &totals->indexed, &totals->indexed_wrong);
+        time_lookups(&set, child_op, totals, &totals->child, &totals->child_wrong);
+        size_t wrong = totals->walk_wrong + totals->indexed_wrong + totals->child_wrong;
+        if (wrong) result = "lookup_error";
+        free_lookups(&set);
+    }
+    pathIndexFree(index);
+    if (ok != DFS_REPS + 2 * LOOKUP_REPS) result = "lookup_error";
+
+    // Pointer tree vs. frozen preorder arrays: full scan and DFS search
+    t0 = now_seconds();
+    FlatTree* flat = freezeTree(root);
+    t1 = now_seconds();
+    double freeze_ms = (t1 - t0) * 1000.0;
+
+    size_t ptr_bytes = 0, flat_bytes = 0;
+    t0 = now_seconds();
+    for (int r = 0; r < DFS_REPS; r++)
+        ptr_bytes += pointer_name_bytes(root);
+    t1 = now_seconds();
+    double ptr_scan_ms = (t1 - t0) * 1000.0 / DFS_REPS;
+
+    t0 = now_seconds();
+    for (int r = 0; r < DFS_REPS; r++)
+        flat_bytes += flat ? flatNameBytes(flat, 0) : 0;
+    t1 = now_seconds();
+    double flat_scan_ms = (t1 - t0) * 1000.0 / DFS_REPS;
+
+    int flat_hits = 0;
+    t0 = now_seconds();
+    for (int r = 0; r < DFS_REPS; r++)
+        flat_hits += flat && flatSearch(flat, target_name) >= 0;
+    t1 = now_seconds();
+    double flat_search_ns = (t1 - t0) * 1e9 / DFS_REPS;
+    if (ptr_bytes != flat_bytes || flat_hits != DFS_REPS) result = "flat_mismatch";
+    freeFlatTree(flat);
+
+    // Snapshot diff: subtree digests vs. a full walk (--diff K)
+    if (totals->diff_changes)
+        run_diff(root, nodes, fanout, arena, totals, gen);
+
+    // Subtree aggregates vs. on-demand walks, then removals (changes the tree)
+    run_aggregates(root, nodes, totals);
+
+    size_t reserved = 0, used = 0, names = 0, name_bytes = 0;
+    arenaStats(arena, &reserved, &used);
+    strpoolStats(&names, &name_bytes);
+
+    // Teardown: one arena release vs. a recursive free() walk
+    t0 = now_seconds();
+    if (arena)
+        arenaDestroy(arena);
+    else
+        freeTree(root);
+    t1 = now_seconds();
+    double teardown_ms = (t1 - t0) * 1000.0;
+    bench_single(&single, (uint64_t)((t1 - t0) * 1e9));
+    bench_merge(&totals->teardown, &single);
+    narySetArena(NULL);
+
+    // Write results to CSV
+    fprintf(csv, "%s,%d,%zu,%d,%s,%.3f,%.3f,%.3f,%.1f,%.1f,%.1f,%.3f,%.1f,%.3f,%.3f,%.3f,%.1f,%.3f,%zu,%zu,%zu,%zu,%s\n",
+            MODULE_NAME, run_id, n, fanout, use_arena ? "arena" : "malloc",
+            build_ms, traverse_ms, search_ms, child_lookup_ns,
+            dfs_ns, walk_ns, index_build_ms, indexed_ns,
+            freeze_ms, ptr_scan_ms, flat_scan_ms, flat_search_ns, teardown_ms,
+            reserved, used, names, name_bytes, result);
+    fflush(csv);
+
+    printf("Run %d build complete\n", run_id);
+}
+
+/* Write the per-op rows in the shared benchmark schema (bench.h);
+   fanout 0 marks a generated (Zipf fanout) tree */
+static void write_bench_csv(const char* path, const BenchTotals* t, size_t n, int fanout,
+                            int use_arena, int runs) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror("Error opening bench CSV");
+        return;
+    }
+    char params[192], shape[16] = "zipf";
+    if (fanout > 0) snprintf(shape, sizeof(shape), "%d", fanout);
+    snprintf(params, sizeof(params),
+             "fanout=%s;depth=%.1f;hit_ratio=%.2f;allocator=%s;lookups=%zu;seed=%llu",
+             shape, t->avg_depth, t->hit_ratio, use_arena ? "arena" : "malloc",
+             t->lookups, t->seed);
+    int lookup_reps = runs * t->reps;
+    bench_csv_header(f);
+    bench_csv_row(f, MODULE_NAME, "build", n, params, runs, &t->build, "ok");
+    if (t->walk.ops) {
+        bench_csv_row(f, MODULE_NAME, "resolve_path", n, params, lookup_reps, &t->walk, t->walk_wrong ? "lookup_error" : "ok");
+        bench_csv_row(f, MODULE_NAME, "path_index_lookup", n, params, lookup_reps, &t->indexed, t->indexed_wrong ? "lookup_error" : "ok");
+        bench_csv_row(f, MODULE_NAME, "find_child", n, params, lookup_reps, &t->child, t->child_wrong ? "lookup_error" : "ok");
+    }
+    bench_csv_row(f, MODULE_NAME, "teardown", n, params, runs, &t->teardown, "ok");
+    const char* agg_status = t->agg_wrong ? "aggregate_error" : "ok";
+    bench_csv_row(f, MODULE_NAME, "stats_root_read", n, params, runs, &t->root_read, agg_status);
+    bench_csv_row(f, MODULE_NAME, "stats_root_walk", n, params, runs, &t->root_walk, agg_status);
+    if (t->agg_read.ops) {
+        bench_csv_row(f, MODULE_NAME, "stats_dir_read", n, params, lookup_reps, &t->agg_read, agg_status);
+        bench_csv_row(f, MODULE_NAME, "stats_dir_walk", n, params, lookup_reps, &t->agg_walk, agg_status);
+    }
+    if (t->remove.ops)
+        bench_csv_row(f, MODULE_NAME, "remove_child", n, params, runs, &t->remove, agg_status);
+    if (t->digest.ops) {
+        char diff_params[224];
+        const char* status = t->diff_wrong ? "diff_error" : "ok";
+        snprintf(diff_params, sizeof(diff_params), "%s;changes=%zu", params, t->diff_changes);
+        bench_csv_row(f, MODULE_NAME, "digest_full", n, diff_params, runs, &t->digest, "ok");
+        bench_csv_row(f, MODULE_NAME, "diff_digest", n, diff_params, runs, &t->diff, status);
+        bench_csv_row(f, MODULE_NAME, "diff_walk", n, diff_params, runs, &t->walk_diff, status);
+    }
+    fclose(f);
+}
+
+/* Main program */
+int main(int argc, char** argv) {
+    size_t n = DEFAULT_NODES;
+    int runs = DEFAULT_RUNS;
+    int use_arena = 0;
+    int fanout = DEFAULT_FANOUT;
+    BenchTotals totals;
+    memset(&totals, 0, sizeof(totals));
+    totals.lookups = DEFAULT_LOOKUPS;
+    totals.reps = DEFAULT_LOOKUP_REPS;
+    totals.hit_ratio = DEFAULT_HIT_RATIO;
+    totals.seed = 42;
+
+    int generate = 0;     /* --generate: n paths from nsgen instead of NodeK names */
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lookups") == 0 && i + 1 < argc)
+            totals.lookups = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+            totals.reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hit-ratio") == 0 && i + 1 < argc)
+            totals.hit_ratio = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            totals.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--generate") == 0)
+            generate = 1;
+        else if (strcmp(argv[i], "--diff") == 0 && i + 1 < argc)
+            totals.diff_changes = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (positional == 0 && ++positional)
+            n = (size_t)strtoull(argv[i], NULL, 10);
+        else if (positional == 1 && ++positional)
+            runs = atoi(argv[i]);
+        else if (positional == 2 && ++positional)
+            use_arena = strcmp(argv[i], "arena") == 0;
+        else if (positional == 3 && ++positional)
+            fanout = atoi(argv[i]);
+    }
+    if (n < 1) n = 1;
+    if (fanout < 1) fanout = 1;
+    NsGenConfig gen;
+    nsgen_defaults(&gen, totals.seed, n);
+
+    FILE* csv = fopen("results_nary.csv", "w");
+    if (!csv) {
+        perror("Error opening results_nary.csv");
+        return 1;
+    }
+
+    fprintf(csv, "module,run_id,n,fanout,allocator,build_ms,traverse_ms,search_ms,"
+                 "child_lookup_ns,dfs_lookup_ns,walk_lookup_ns,index_build_ms,"
+                 "index_lookup_ns,freeze_ms,ptr_scan_ms,flat_scan_ms,flat_search_ns,teardown_ms,arena_reserved,arena_used,"
+                 "interned_names,name_pool_bytes,result\n");
+
+    for (int i = 1; i <= runs; i++) {
+        run_one(csv, i, n, fanout, use_arena, &totals, generate ? &gen : NULL);
+    }
+
+    fclose(csv);
+    write_bench_csv("results_nary_bench.csv", &totals, n, generate ? 0 : fanout, use_arena, runs);
+    strpoolReset();
+    printf("Results stored in results_nary.csv and results_nary_bench.csv\n");
+    return 0;
+}
@@ -0,0 +1,371 @@
+/*
+ * nsgen.c
+ *
+ * Depth-first namespace generator behind nsgen.h. One frame per open
+ * directory holds what is left to emit in it; the path buffer is shared,
+ * each frame owning the prefix up to its own length.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nsgen.h"
+
+/* room for one component: name, numbered series digits, dedup suffix, ext */
+#define COMPONENT_MAX (NSGEN_MAX_NAME + 24)
+#if (NSGEN_MAX_DEPTH + 1) * (COMPONENT_MAX + 1) + 1 > NSGEN_MAX_PATH
+#error "NSGEN_MAX_PATH is too small"
+#endif
+
+typedef struct {
+    size_t len;           /* length of this directory's path */
+    long files_left;
+    long dirs_left;
+    long next_index;      /* ordinal of the next series file */
+    int series;           /* SERIES[] stem of this directory's files, or -1 */
+    int series_ext;
+    uint64_t *seen;       /* hashes of child names (0 = empty slot) */
+    size_t seen_cap;      /* active slots, a power of two */
+    size_t seen_alloc;    /* slots allocated */
+    size_t seen_count;
+} Frame;
+
+struct NsGen {
+    NsGenConfig cfg;
+    uint64_t rng;
+    double *fanout_cdf;
+    double *files_cdf;
+    double ext_cdf[20];
+    double fanout_mean;   /* mean of one fanout_cdf draw */
+    double level_fanout[NSGEN_MAX_DEPTH + 1];   /* target subdirectories per directory, by depth */
+    Frame frames[NSGEN_MAX_DEPTH + 1];
+    int top;
+    size_t emitted;
+    size_t dirs;
+    char path[NSGEN_MAX_PATH];
+};
+
+static const char *const DIR_WORDS[] = {
+    "src", "lib", "include", "docs", "test", "tests", "build", "bin", "data",
+    "assets", "images", "config", "scripts", "vendor", "cache", "logs", "tmp",
+    "backup", "archive", "share", "local", "projects", "users", "home",
+    "photos", "music", "videos", "downloads", "reports", "2022", "2023",
+    "2024", "2025", "modules", "resources", "static", "templates", "db"
+};
+static const char *const SERIES[] = {
+    "IMG_", "DSC", "part-", "report_", "log.", "chunk_", "frame", "page",
+    "v", "backup-"
+};
+/* most common first: picked with a Zipf(1) law */
+static const char *const EXTS[] = {
+    "txt", "c", "h", "json", "jpg", "png", "log", "md", "py", "js",
+    "html", "pdf", "o", "csv", "xml", "so", "gz", "cpp", "go", "yaml"
+};
+static const char CONSONANTS[] = "bcdfghjklmnprstvwxz";
+static const char VOWELS[] = "aeiou";
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+/* splitmix64 */
+static uint64_t next_u64(NsGen *g) {
+    uint64_t z = (g->rng += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static double uniform(NsGen *g) {
+    return (double)(next_u64(g) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int chance(NsGen *g, double p) {
+    return uniform(g) < p;
+}
+
+/* CDF of a Zipf law over 1..n with exponent s */
+static void zipf_fill(double *cdf, int n, double s) {
+    double sum = 0.0;
+    for (int k = 1; k <= n; ++k) {
+        sum += pow((double)k, -s);
+        cdf[k - 1] = sum;
+    }
+    for (int k = 0; k < n; ++k) cdf[k] /= sum;
+}
+
+static double zipf_mean(const double *cdf, int n) {
+    double mean = cdf[0];
+    for (int k = 1; k < n; ++k) mean += (double)(k + 1) * (cdf[k] - cdf[k - 1]);
+    return mean;
+}
+
+/* Value in 1..n drawn from a CDF built by zipf_fill */
+static long zipf_draw(NsGen *g, const double *cdf, int n) {
+    double u = uniform(g);
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (cdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo + 1;
+}
+
+static uint64_t name_hash(const char *s, size_t n) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; ++i) h = (h ^ (unsigned char)s[i]) * 1099511628211ull;
+    return h ? h : 1;
+}
+
+/* Size the child-name set for 'expected' names; slots are reused between
+   directories and only the active part is cleared */
+static int seen_reset(Frame *f, size_t expected) {
+    size_t cap = 16;
+    while (cap < 2 * expected + 2) cap <<= 1;
+    if (cap > f->seen_alloc) {
+        uint64_t *grown = realloc(f->seen, cap * sizeof(uint64_t));
+        if (!grown) return -1;
+        f->seen = grown;
+        f->seen_alloc = cap;
+    }
+    f->seen_cap = cap;
+    f->seen_count = 0;
+    memset(f->seen, 0, cap * sizeof(uint64_t));
+    return 0;
+}
+
+/* Insert a hash; returns 0 if it was already present, 1 if added, -1 on OOM */
+static int seen_add(Frame *f, uint64_t h) {
+    if (2 * (f->seen_count + 1) > f->seen_cap) {
+        /* only the root, which has no child limit, ever grows */
+        size_t cap = f->seen_cap * 2;
+        uint64_t *slots = calloc(cap, sizeof(uint64_t));
+        if (!slots) return -1;
+        for (size_t i = 0; i < f->seen_cap; ++i) {
+            uint64_t v = f->seen[i];
+            if (!v) continue;
+            size_t j = (size_t)v & (cap - 1);
+            while (slots[j]) j = (j + 1) & (cap - 1);
+            slots[j] = v;
+        }
+        free(f->seen);
+        f->seen = slots;
+        f->seen_cap = f->seen_alloc = cap;
+    }
+    size_t j = (size_t)h & (f->seen_cap - 1);
+    while (f->seen[j]) {
+        if (f->seen[j] == h) return 0;
+        j = (j + 1) & (f->seen_cap - 1);
+    }
+    f->seen[j] = h;
+    f->seen_count++;
+    return 1;
+}
+
+/* Make name[0..n) unique in the directory by appending _2, _3, ... */
+static size_t make_unique(Frame *f, char *name, size_t n) {
+    size_t base = n;
+    for (int k = 2; seen_add(f, name_hash(name, n)) == 0; ++k)
+        n = base + (size_t)sprintf(name + base, "_%d", k);
+    return n;
+}
+
+/* Pronounceable word of about name_mean letters */
+static size_t random_word(NsGen *g, char *out) {
+    double mean = g->cfg.name_mean;
+    long len = lround(mean * (uniform(g) + uniform(g)));    /* triangular around mean */
+    if (len < 2) len = 2;
+    if (len > NSGEN_MAX_NAME) len = NSGEN_MAX_NAME;
+    int vowel = chance(g, 0.3);
+    for (long i = 0; i < len; ++i) {
+        if (i >= 3 && i < len - 2 && chance(g, 0.08)) {
+            out[i] = chance(g, 0.5) ? '_' : '-';
+            vowel = chance(g, 0.3);
+            continue;
+        }
+        out[i] = vowel ? VOWELS[next_u64(g) % (COUNT_OF(VOWELS) - 1)]
+                       : CONSONANTS[next_u64(g) % (COUNT_OF(CONSONANTS) - 1)];
+        vowel = !vowel;
+    }
+    return (size_t)len;
+}
+
+static int draw_ext(NsGen *g) {
+    return (int)zipf_draw(g, g->ext_cdf, (int)COUNT_OF(EXTS)) - 1;
+}
+
+static size_t dir_name(NsGen *g, Frame *f, char *out) {
+    size_t n;
+    if (chance(g, g->cfg.shared_prefix)) {
+        const char *w = DIR_WORDS[next_u64(g) % COUNT_OF(DIR_WORDS)];
+        n = strlen(w);
+        memcpy(out, w, n);
+    } else {
+        n = random_word(g, out);
+    }
+    return make_unique(f, out, n);
+}
+
+static size_t file_name(NsGen *g, Frame *f, char *out) {
+    size_t n;
+    int ext;
+    if (f->series >= 0) {
+        n = (size_t)sprintf(out, "%s%04ld", SERIES[f->series], ++f->next_index);
+        ext = f->series_ext;
+    } else {
+        n = random_word(g, out);
+        ext = draw_ext(g);
+    }
+    n += (size_t)sprintf(out + n, ".%s", EXTS[ext]);
+    return make_unique(f, out, n);
+}
+
+/* Enter a new directory at 'depth' whose path is path[0..len) */
+static int open_frame(NsGen *g, int depth, size_t len) {
+    Frame *f = &g->frames[depth];
+    f->len = len;
+    f->next_index = 0;
+    if (depth == 0) {
+        f->files_left = 0;          /* nothing directly under "/" */
+        f->dirs_left = 0;           /* the root is refilled on demand */
+    } else {
+        f->files_left = zipf_draw(g, g->files_cdf, g->cfg.max_files) - 1;
+        /* keep the Zipf shape, scaled to this depth's target mean: below
+           the Zipf mean some directories get none, above it draws stretch */
+        double scale = g->level_fanout[depth] / g->fanout_mean;
+        if (scale <= 1.0) {
+            f->dirs_left = chance(g, scale) ? zipf_draw(g, g->fanout_cdf, g->cfg.max_fanout) : 0;
+        } else {
+            f->dirs_left = lround(scale * (double)zipf_draw(g, g->fanout_cdf, g->cfg.max_fanout));
+            if (f->dirs_left > g->cfg.max_fanout) f->dirs_left = g->cfg.max_fanout;
+        }
+    }
+    f->series = -1;
+    if (f->files_left > 1 && chance(g, g->cfg.shared_prefix)) {
+        f->series = (int)(next_u64(g) % COUNT_OF(SERIES));
+        f->series_ext = draw_ext(g);
+    }
+    if (seen_reset(f, (size_t)(f->files_left + f->dirs_left)) != 0) return -1;
+    g->top = depth;
+    g->dirs++;
+    return 0;
+}
+
+/* Directories per level grow by a factor 'grow' down to depth_mean and
+   halve below it, with 'grow' chosen so the tree holds about as many
+   directories as the file budget needs. The root is refilled on demand. */
+static void plan_levels(NsGen *g) {
+    g->fanout_mean = zipf_mean(g->fanout_cdf, g->cfg.max_fanout);
+    double files_mean = zipf_mean(g->files_cdf, g->cfg.max_files) - 1.0;
+    double dirs = (double)g->cfg.paths / (files_mean > 1.0 ? files_mean : 1.0);
+    int peak = (int)lround(g->cfg.depth_mean);
+    if (peak > g->cfg.max_depth) peak = g->cfg.max_depth;
+    double grow = pow(dirs / 3.0, 1.0 / peak);
+    if (grow < 1.0) grow = 1.0;
+    for (int d = 0; d <= NSGEN_MAX_DEPTH; ++d)
+        g->level_fanout[d] = d >= g->cfg.max_depth ? 0.0 : d < peak ? grow : 0.5;
+}
+
+void nsgen_defaults(NsGenConfig *cfg, uint64_t seed, size_t paths) {
+    cfg->seed = seed;
+    cfg->paths = paths;
+    cfg->depth_mean = 5.0;
+    cfg->max_depth = 16;
+    cfg->fanout_skew = 2.0;
+    cfg->max_fanout = 1000;
+    cfg->files_skew = 1.6;
+    cfg->max_files = 10000;
+    cfg->name_mean = 10.0;
+    cfg->shared_prefix = 0.3;
+}
+
+NsGen *nsgen_create(const NsGenConfig *cfg) {
+    NsGen *g = calloc(1, sizeof(NsGen));
+    if (!g) return NULL;
+    g->cfg = *cfg;
+    if (g->cfg.max_depth < 1) g->cfg.max_depth = 1;
+    if (g->cfg.max_depth > NSGEN_MAX_DEPTH) g->cfg.max_depth = NSGEN_MAX_DEPTH;
+    if (g->cfg.depth_mean < 1.0) g->cfg.depth_mean = 1.0;
+    if (g->cfg.max_fanout < 1) g->cfg.max_fanout = 1;
+    if (g->cfg.max_files < 1) g->cfg.max_files = 1;
+    if (g->cfg.name_mean < 2.0) g->cfg.name_mean = 2.0;
+    g->rng = cfg->seed;
+    g->fanout_cdf = malloc((size_t)g->cfg.max_fanout * sizeof(double));
+    g->files_cdf = malloc((size_t)g->cfg.max_files * sizeof(double));
+    if (!g->fanout_cdf || !g->files_cdf) {
+        nsgen_free(g);
+        return NULL;
+    }
+    zipf_fill(g->fanout_cdf, g->cfg.max_fanout, g->cfg.fanout_skew);
+    zipf_fill(g->files_cdf, g->cfg.max_files, g->cfg.files_skew);
+    zipf_fill(g->ext_cdf, (int)COUNT_OF(EXTS), 1.0);
+    plan_levels(g);
+    if (open_frame(g, 0, 0) != 0) {
+        nsgen_free(g);
+        return NULL;
+    }
+    g->dirs = 0;                    /* the root is not counted */
+    return g;
+}
+
+const char *nsgen_next(NsGen *g, size_t *len) {
+    while (g->emitted < g->cfg.paths) {
+        Frame *f = &g->frames[g->top];
+        char *name = g->path + f->len + 1;
+        if (f->files_left > 0) {
+            f->files_left--;
+            size_t total = f->len + 1 + file_name(g, f, name);
+            g->path[f->len] = '/';
+            g->path[total] = '\0';
+            g->emitted++;
+            if (len) *len = total;
+            return g->path;
+        }
+        if (f->dirs_left > 0 || g->top == 0) {
+            if (g->top > 0) f->dirs_left--;
+            size_t n = dir_name(g, f, name);
+            g->path[f->len] = '/';
+            if (open_frame(g, g->top + 1, f->len + 1 + n) != 0) return NULL;
+            continue;
+        }
+        g->top--;                   /* directory done: back to its parent */
+    }
+    return NULL;
+}
+
+size_t nsgen_emitted(const NsGen *g) {
+    return g->emitted;
+}
+
+size_t nsgen_directories(const NsGen *g) {
+    return g->dirs;
+}
+
+void nsgen_free(NsGen *g) {
+    if (!g) return;
+    for (int i = 0; i <= NSGEN_MAX_DEPTH; ++i) free(g->frames[i].seen);
+    free(g->fanout_cdf);
+    free(g->files_cdf);
+    free(g);
+}
+
+int nsgen_write(const NsGenConfig *cfg, const char *path) {
+    NsGen *g = nsgen_create(cfg);
+    if (!g) return -1;
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        nsgen_free(g);
+        return -1;
+    }
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+    int rc = 0;
+    const char *p;
+    size_t n;
+    while (rc == 0 && (p = nsgen_next(g, &n)) != NULL) {
+        if (fwrite(p, 1, n, f) != n || fputc('\n', f) == EOF) rc = -1;
+    }
+    if (nsgen_emitted(g) != cfg->paths) rc = -1;
+    if (fclose(f) != 0) rc = -1;
+    nsgen_free(g);
+    return rc;
+}
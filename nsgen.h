@@ -0,0 +1,68 @@
+/*
+ * nsgen.h
+ *
+ * Seeded generator of realistic file-system namespaces for scale tests.
+ * Paths come out one at a time in depth-first order ("/a/b/c.txt"), the
+ * way `find` lists a tree, so millions of them can be streamed to disk or
+ * straight into the trie, N-ary and Merkle builders without holding the
+ * list in memory. The same config and seed always give the same paths.
+ *
+ * Shape:
+ *  - depth: the number of directories per level grows down to depth_mean
+ *    and halves below it (never deeper than max_depth), sized so that the
+ *    tree holds about as many directories as the path budget needs
+ *  - fanout: subdirectories and files per directory follow Zipf laws, so
+ *    most directories are small and a few are very wide
+ *  - names: pronounceable words whose length averages name_mean; a
+ *    shared_prefix share reuse common directory names (src, docs, ...) or
+ *    numbered series (IMG_0001.jpg, part-00002.log) within a directory
+ *
+ * Names are unique within their directory, so every emitted path is unique.
+ */
+
+#ifndef NSGEN_H
+#define NSGEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NSGEN_MAX_DEPTH 64
+#define NSGEN_MAX_NAME 48
+/* longest path nsgen_next() can return, including the terminator */
+#define NSGEN_MAX_PATH ((NSGEN_MAX_DEPTH + 1) * (NSGEN_MAX_NAME + 25) + 1)
+
+typedef struct {
+    uint64_t seed;
+    size_t paths;            /* file paths to emit */
+    double depth_mean;       /* depth holding the most directories */
+    int max_depth;           /* hard limit, <= NSGEN_MAX_DEPTH */
+    double fanout_skew;      /* Zipf exponent, subdirectories per directory */
+    int max_fanout;
+    double files_skew;       /* Zipf exponent, files per directory */
+    int max_files;
+    double name_mean;        /* mean name length in characters */
+    double shared_prefix;    /* share of names drawn from common stems */
+} NsGenConfig;
+
+typedef struct NsGen NsGen;
+
+/* Defaults: depth 5, fanout Zipf(2.0) up to 1000, files Zipf(1.6) up to
+   10000 (about 40 per directory), 10-character names, 30% shared stems */
+void nsgen_defaults(NsGenConfig *cfg, uint64_t seed, size_t paths);
+
+NsGen *nsgen_create(const NsGenConfig *cfg);
+
+/* Next path, or NULL after cfg->paths paths. The string stays valid until
+   the next call; *len (optional) receives its length. */
+const char *nsgen_next(NsGen *g, size_t *len);
+
+/* Paths emitted so far, and directories opened to hold them */
+size_t nsgen_emitted(const NsGen *g);
+size_t nsgen_directories(const NsGen *g);
+
+void nsgen_free(NsGen *g);
+
+/* Stream the whole namespace to a file, one path per line (0 on success) */
+int nsgen_write(const NsGenConfig *cfg, const char *path);
+
+#endif
@@ -0,0 +1,431 @@
+/*
+ * sha256_mb.c
+ *
+ * Scalar SHA-256 plus SSE2 / AVX2 / AVX-512 multi-buffer kernels.
+ * Each kernel runs the 64 rounds on L messages at once: vector lane j
+ * holds the working variables of message j. Messages of different lengths
+ * share the loop; a lane whose message has no more blocks keeps its state.
+ */
+
+#include <string.h>
+#include <stdatomic.h>
+#include "sha256_mb.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define SHA256_MB_X86 1
+  #include <immintrin.h>
+#endif
+
+#define MAX_LANES 16
+
+static const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t H256[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+/* Number of 64-byte blocks after padding (0x80, zeros, 64-bit length) */
+static size_t padded_blocks(size_t len) {
+    return (len + 9 + 63) / 64;
+}
+
+/* Copy block b of the padded message into out[64] */
+static void padded_block(const uint8_t *msg, size_t len, size_t b, uint8_t out[64]) {
+    size_t off = b * 64;
+    size_t take = off < len ? (len - off < 64 ? len - off : 64) : 0;
+    if (take) memcpy(out, msg + off, take);
+    memset(out + take, 0, 64 - take);
+    if (off + take == len && take < 64 && off <= len)
+        out[take] = 0x80;                       /* block holding the terminator */
+    if (b == padded_blocks(len) - 1) {
+        uint64_t bits = (uint64_t)len * 8;
+        for (int i = 0; i < 8; ++i) out[63 - i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+/* ---------- Scalar ---------- */
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void compress_scalar(uint32_t s[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int t = 0; t < 16; ++t) w[t] = load_be32(block + 4 * t);
+    for (int t = 16; t < 64; ++t) {
+        uint32_t s0 = ROR32(w[t-15], 7) ^ ROR32(w[t-15], 18) ^ (w[t-15] >> 3);
+        uint32_t s1 = ROR32(w[t-2], 17) ^ ROR32(w[t-2], 19) ^ (w[t-2] >> 10);
+        w[t] = w[t-16] + s0 + w[t-7] + s1;
+    }
+    uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int t = 0; t < 64; ++t) {
+        uint32_t t1 = h + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) + ((e & f) ^ (~e & g)) + K256[t] + w[t];
+        uint32_t t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d; s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+static void blocks_scalar(uint32_t s[8], const uint8_t *data, size_t blocks) {
+    for (size_t b = 0; b < blocks; ++b) compress_scalar(s, data + 64 * b);
+}
+
+/* ---------- SHA-NI (one message, hardware rounds) ---------- */
+
+#ifdef SHA256_MB_X86
+/*
+ * State is kept as ABEF/CDGH for sha256rnds2. Each 4-round group j uses
+ * message words W[j]; from group 4 on they come from
+ * W[j] = msg2(msg1(W[j-4], W[j-3]) + alignr(W[j-1], W[j-2]), W[j-1]).
+ */
+__attribute__((target("sha,sse4.1")))
+static void blocks_shani(uint32_t s[8], const uint8_t *data, size_t blocks) {
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&s[0]), 0xB1);   /* CDAB */
+    __m128i st1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&s[4]), 0x1B);   /* EFGH */
+    __m128i st0 = _mm_alignr_epi8(tmp, st1, 8);                                       /* ABEF */
+    st1 = _mm_blend_epi16(st1, tmp, 0xF0);                                            /* CDGH */
+
+    for (; blocks; --blocks, data += 64) {
+        __m128i save0 = st0, save1 = st1, w[4];
+        for (int j = 0; j < 16; ++j) {
+            if (j < 4) {
+                w[j] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16 * j)), bswap);
+            } else {
+                __m128i x = _mm_sha256msg1_epu32(w[j & 3], w[(j + 1) & 3]);
+                x = _mm_add_epi32(x, _mm_alignr_epi8(w[(j + 3) & 3], w[(j + 2) & 3], 4));
+                w[j & 3] = _mm_sha256msg2_epu32(x, w[(j + 3) & 3]);
+            }
+            __m128i m = _mm_add_epi32(w[j & 3], _mm_loadu_si128((const __m128i *)&K256[4 * j]));
+            st1 = _mm_sha256rnds2_epu32(st1, st0, m);
+            st0 = _mm_sha256rnds2_epu32(st0, st1, _mm_shuffle_epi32(m, 0x0E));
+        }
+        st0 = _mm_add_epi32(st0, save0);
+        st1 = _mm_add_epi32(st1, save1);
+    }
+
+    tmp = _mm_shuffle_epi32(st0, 0x1B);                                               /* FEBA */
+    st1 = _mm_shuffle_epi32(st1, 0xB1);                                               /* DCHG */
+    _mm_storeu_si128((__m128i *)&s[0], _mm_blend_epi16(tmp, st1, 0xF0));              /* DCBA */
+    _mm_storeu_si128((__m128i *)&s[4], _mm_alignr_epi8(st1, tmp, 8));                 /* HGFE */
+}
+#endif
+
+typedef void (*blocks_fn)(uint32_t s[8], const uint8_t *data, size_t blocks);
+
+static atomic_int single_impl = -1;   /* -1 = not probed, 0 = scalar, 1 = SHA-NI */
+
+static int have_shani(void) {
+    int v = atomic_load(&single_impl);
+    if (v < 0) {
+        v = 0;
+#ifdef SHA256_MB_X86
+        __builtin_cpu_init();
+        v = __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+#endif
+        atomic_store(&single_impl, v);
+    }
+    return v;
+}
+
+/* Single-message block function: SHA-NI when present, else scalar */
+static blocks_fn single_blocks(void) {
+#ifdef SHA256_MB_X86
+    if (have_shani()) return blocks_shani;
+#endif
+    return blocks_scalar;
+}
+
+/* ---------- Incremental (streaming) ---------- */
+
+void sha256_mb_init(Sha256Ctx *ctx) {
+    memcpy(ctx->state, H256, sizeof(ctx->state));
+    ctx->bytes = 0;
+    ctx->buf_len = 0;
+}
+
+void sha256_mb_update(Sha256Ctx *ctx, const void *data, size_t len) {
+    const uint8_t *p = data;
+    blocks_fn blocks = single_blocks();
+    ctx->bytes += len;
+    if (ctx->buf_len) {
+        size_t take = 64 - ctx->buf_len < len ? 64 - ctx->buf_len : len;
+        memcpy(ctx->buf + ctx->buf_len, p, take);
+        ctx->buf_len += take;
+        p += take;
+        len -= take;
+        if (ctx->buf_len < 64) return;
+        blocks(ctx->state, ctx->buf, 1);
+        ctx->buf_len = 0;
+    }
+    if (len >= 64) {
+        blocks(ctx->state, p, len / 64);   /* whole blocks straight from the input */
+        p += len / 64 * 64;
+        len %= 64;
+    }
+    memcpy(ctx->buf, p, len);
+    ctx->buf_len = len;
+}
+
+void sha256_mb_final(Sha256Ctx *ctx, uint8_t digest[SHA256_DIGEST_LEN]) {
+    uint8_t block[128];
+    size_t n = padded_blocks(ctx->buf_len);   /* 1 or 2 */
+    memcpy(block, ctx->buf, ctx->buf_len);
+    memset(block + ctx->buf_len, 0, sizeof(block) - ctx->buf_len);
+    block[ctx->buf_len] = 0x80;
+    uint64_t bits = ctx->bytes * 8;
+    for (int i = 0; i < 8; ++i) block[n * 64 - 1 - i] = (uint8_t)(bits >> (8 * i));
+    single_blocks()(ctx->state, block, n);
+    for (int i = 0; i < 8; ++i) store_be32(digest + 4 * i, ctx->state[i]);
+}
+
+void sha256_mb_single(const void *data, size_t len, uint8_t digest[SHA256_DIGEST_LEN]) {
+    Sha256Ctx ctx;
+    sha256_mb_init(&ctx);
+    sha256_mb_update(&ctx, data, len);
+    sha256_mb_final(&ctx, digest);
+}
+
+static void hash_group_scalar(const uint8_t *const *msgs, const size_t *lens,
+                              uint8_t (*digests)[SHA256_DIGEST_LEN], size_t count) {
+    for (size_t i = 0; i < count; ++i) sha256_mb_single(msgs[i], lens[i], digests[i]);
+}
+
+/* ---------- SIMD kernels ---------- */
+
+#ifdef SHA256_MB_X86
+
+/*
+ * One lockstep compression over all lanes. Expects the vector primitives
+ * V, V_LOAD, V_STORE, V_ADD, V_XOR, V_AND, V_OR, V_ANDN (~a & b), V_SRL,
+ * V_SLL and V_SET1 to be defined for the target ISA; st/w are lane-major
+ * [word][lane] arrays.
+ */
+#define V_ROR(x, n) V_OR(V_SRL(x, n), V_SLL(x, 32 - (n)))
+#define MB_COMPRESS_BODY(st, w)                                                        \
+    do {                                                                               \
+        V W[16];                                                                       \
+        for (int t = 0; t < 16; ++t) W[t] = V_LOAD(w[t]);                              \
+        V a = V_LOAD(st[0]), b = V_LOAD(st[1]), c = V_LOAD(st[2]), d = V_LOAD(st[3]);  \
+        V e = V_LOAD(st[4]), f = V_LOAD(st[5]), g = V_LOAD(st[6]), h = V_LOAD(st[7]);  \
+        for (int t = 0; t < 64; ++t) {                                                 \
+            if (t >= 16) {                                                             \
+                V x15 = W[(t - 15) & 15], x2 = W[(t - 2) & 15];                        \
+                V s0 = V_XOR(V_XOR(V_ROR(x15, 7), V_ROR(x15, 18)), V_SRL(x15, 3));     \
+                V s1 = V_XOR(V_XOR(V_ROR(x2, 17), V_ROR(x2, 19)), V_SRL(x2, 10));      \
+                W[t & 15] = V_ADD(V_ADD(W[t & 15], s0), V_ADD(W[(t - 7) & 15], s1));   \
+            }                                                                          \
+            V S1 = V_XOR(V_XOR(V_ROR(e, 6), V_ROR(e, 11)), V_ROR(e, 25));              \
+            V ch = V_XOR(V_AND(e, f), V_ANDN(e, g));                                   \
+            V t1 = V_ADD(V_ADD(V_ADD(h, S1), V_ADD(ch, V_SET1(K256[t]))), W[t & 15]);  \
+            V S0 = V_XOR(V_XOR(V_ROR(a, 2), V_ROR(a, 13)), V_ROR(a, 22));              \
+            V maj = V_XOR(V_XOR(V_AND(a, b), V_AND(a, c)), V_AND(b, c));               \
+            h = g; g = f; f = e; e = V_ADD(d, t1);                                     \
+            d = c; c = b; b = a; a = V_ADD(t1, V_ADD(S0, maj));                        \
+        }                                                                              \
+        V_STORE(st[0], V_ADD(V_LOAD(st[0]), a)); V_STORE(st[1], V_ADD(V_LOAD(st[1]), b)); \
+        V_STORE(st[2], V_ADD(V_LOAD(st[2]), c)); V_STORE(st[3], V_ADD(V_LOAD(st[3]), d)); \
+        V_STORE(st[4], V_ADD(V_LOAD(st[4]), e)); V_STORE(st[5], V_ADD(V_LOAD(st[5]), f)); \
+        V_STORE(st[6], V_ADD(V_LOAD(st[6]), g)); V_STORE(st[7], V_ADD(V_LOAD(st[7]), h)); \
+    } while (0)
+
+/* SSE2: 4 lanes */
+#define V __m128i
+#define V_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define V_STORE(p, x) _mm_storeu_si128((__m128i *)(p), x)
+#define V_ADD _mm_add_epi32
+#define V_XOR _mm_xor_si128
+#define V_AND _mm_and_si128
+#define V_OR _mm_or_si128
+#define V_ANDN _mm_andnot_si128
+#define V_SRL _mm_srli_epi32
+#define V_SLL _mm_slli_epi32
+#define V_SET1(k) _mm_set1_epi32((int)(k))
+__attribute__((target("sse2")))
+static void compress_x4(uint32_t st[8][MAX_LANES], uint32_t w[16][MAX_LANES]) {
+    MB_COMPRESS_BODY(st, w);
+}
+#undef V
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_XOR
+#undef V_AND
+#undef V_OR
+#undef V_ANDN
+#undef V_SRL
+#undef V_SLL
+#undef V_SET1
+
+/* AVX2: 8 lanes */
+#define V __m256i
+#define V_LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define V_STORE(p, x) _mm256_storeu_si256((__m256i *)(p), x)
+#define V_ADD _mm256_add_epi32
+#define V_XOR _mm256_xor_si256
+#define V_AND _mm256_and_si256
+#define V_OR _mm256_or_si256
+#define V_ANDN _mm256_andnot_si256
+#define V_SRL _mm256_srli_epi32
+#define V_SLL _mm256_slli_epi32
+#define V_SET1(k) _mm256_set1_epi32((int)(k))
+__attribute__((target("avx2")))
+static void compress_x8(uint32_t st[8][MAX_LANES], uint32_t w[16][MAX_LANES]) {
+    MB_COMPRESS_BODY(st, w);
+}
+#undef V
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_XOR
+#undef V_AND
+#undef V_OR
+#undef V_ANDN
+#undef V_SRL
+#undef V_SLL
+#undef V_SET1
+
+/* AVX-512: 16 lanes (native rotate) */
+#undef V_ROR
+#define V_ROR(x, n) _mm512_ror_epi32(x, n)
+#define V __m512i
+#define V_LOAD(p) _mm512_loadu_si512((const void *)(p))
+#define V_STORE(p, x) _mm512_storeu_si512((void *)(p), x)
+#define V_ADD _mm512_add_epi32
+#define V_XOR _mm512_xor_si512
+#define V_AND _mm512_and_si512
+#define V_OR _mm512_or_si512
+#define V_ANDN _mm512_andnot_si512
+#define V_SRL _mm512_srli_epi32
+#define V_SLL _mm512_slli_epi32
+#define V_SET1(k) _mm512_set1_epi32((int)(k))
+__attribute__((target("avx512f")))
+static void compress_x16(uint32_t st[8][MAX_LANES], uint32_t w[16][MAX_LANES]) {
+    MB_COMPRESS_BODY(st, w);
+}
+#undef V
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_XOR
+#undef V_AND
+#undef V_OR
+#undef V_ANDN
+#undef V_SRL
+#undef V_SLL
+#undef V_SET1
+#undef V_ROR
+
+typedef void (*compress_fn)(uint32_t st[8][MAX_LANES], uint32_t w[16][MAX_LANES]);
+
+/* Hash up to 'lanes' messages together; idle lanes are simply ignored */
+static void hash_group_simd(compress_fn compress, int lanes,
+                            const uint8_t *const *msgs, const size_t *lens,
+                            uint8_t (*digests)[SHA256_DIGEST_LEN], size_t count) {
+    uint32_t st[8][MAX_LANES], next[8][MAX_LANES], w[16][MAX_LANES];
+    size_t blocks[MAX_LANES], max_blocks = 0;
+    uint8_t block[64];
+
+    memset(w, 0, sizeof(w));
+    for (int l = 0; l < lanes; ++l) {
+        for (int i = 0; i < 8; ++i) st[i][l] = H256[i];
+        blocks[l] = (size_t)l < count ? padded_blocks(lens[l]) : 0;
+        if (blocks[l] > max_blocks) max_blocks = blocks[l];
+    }
+
+    for (size_t b = 0; b < max_blocks; ++b) {
+        /* Transpose block b of every live message into word-major order */
+        for (int l = 0; l < lanes; ++l) {
+            if (b >= blocks[l]) continue;
+            const uint8_t *src;
+            if ((b + 1) * 64 <= lens[l]) {
+                src = msgs[l] + 64 * b;          /* full block: read in place */
+            } else {
+                padded_block(msgs[l], lens[l], b, block);
+                src = block;
+            }
+            for (int t = 0; t < 16; ++t) w[t][l] = load_be32(src + 4 * t);
+        }
+        memcpy(next, st, sizeof(st));
+        compress(next, w);
+        /* Lanes whose message already ended keep their final state */
+        for (int l = 0; l < lanes; ++l)
+            if (b < blocks[l])
+                for (int i = 0; i < 8; ++i) st[i][l] = next[i][l];
+    }
+
+    for (size_t l = 0; l < count; ++l)
+        for (int i = 0; i < 8; ++i) store_be32(digests[l] + 4 * i, st[i][l]);
+}
+
+#endif /* SHA256_MB_X86 */
+
+/* ---------- Dispatch ---------- */
+
+static atomic_int active_lanes = 0;   /* 0 = not selected yet */
+
+static int best_lanes(void) {
+#ifdef SHA256_MB_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return 16;
+    if (__builtin_cpu_supports("avx2")) return 8;
+    if (__builtin_cpu_supports("sse2")) return 4;
+#endif
+    return 1;
+}
+
+int sha256_mb_select(int lanes) {
+    int best = best_lanes();
+    if (lanes == 1 || (lanes > 1 && lanes <= best && (lanes == 4 || lanes == 8 || lanes == 16)))
+        active_lanes = lanes;
+    else
+        active_lanes = best;
+    return active_lanes;
+}
+
+int sha256_mb_lanes(void) {
+    if (!active_lanes) sha256_mb_select(0);
+    return active_lanes;
+}
+
+const char *sha256_mb_impl_name(void) {
+    switch (sha256_mb_lanes()) {
+        case 16: return "avx512";
+        case 8:  return "avx2";
+        case 4:  return "sse2";
+        default: return have_shani() ? "shani" : "scalar";
+    }
+}
+
+void sha256_mb_hash(const uint8_t *const *msgs, const size_t *lens,
+                    uint8_t (*digests)[SHA256_DIGEST_LEN], size_t count) {
+    int lanes = sha256_mb_lanes();
+#ifdef SHA256_MB_X86
+    compress_fn compress = lanes == 16 ? compress_x16 : lanes == 8 ? compress_x8 :
+                           lanes == 4 ? compress_x4 : NULL;
+    if (compress) {
+        for (size_t i = 0; i < count; i += (size_t)lanes) {
+            size_t group = count - i < (size_t)lanes ? count - i : (size_t)lanes;
+            hash_group_simd(compress, lanes, msgs + i, lens + i, digests + i, group);
+        }
+        return;
+    }
+#endif
+    (void)lanes;
+    hash_group_scalar(msgs, lens, digests, count);
+}
@@ -0,0 +1,52 @@
+/*
+ * sha256_mb.h
+ *
+ * Multi-buffer SHA-256: hashes many independent short messages in lockstep,
+ * one message per SIMD lane (4 lanes SSE2, 8 lanes AVX2, 16 lanes AVX-512).
+ * The widest kernel the CPU supports is picked at runtime; a portable
+ * scalar path is always available. Digests are bit-for-bit standard
+ * SHA-256 (identical to OpenSSL's SHA256()).
+ *
+ * Intended for Merkle leaf hashing (20-220 byte contents) and interior
+ * pair hashing (64-byte left||right digests), where per-call overhead and
+ * serial compression dominate.
+ */
+
+#ifndef SHA256_MB_H
+#define SHA256_MB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_LEN 32
+
+/* Incremental hashing of one long message (e.g. a file read in blocks);
+   uses the SHA-NI instructions when the CPU has them */
+typedef struct {
+    uint32_t state[8];
+    uint64_t bytes;
+    uint8_t buf[64];
+    size_t buf_len;
+} Sha256Ctx;
+
+void sha256_mb_init(Sha256Ctx *ctx);
+void sha256_mb_update(Sha256Ctx *ctx, const void *data, size_t len);
+void sha256_mb_final(Sha256Ctx *ctx, uint8_t digest[SHA256_DIGEST_LEN]);
+
+/* Hash one message (init + update + final) */
+void sha256_mb_single(const void *data, size_t len, uint8_t digest[SHA256_DIGEST_LEN]);
+
+/* Hash count messages: digests[i] = SHA-256(msgs[i][0..lens[i])) */
+void sha256_mb_hash(const uint8_t *const *msgs, const size_t *lens,
+                    uint8_t (*digests)[SHA256_DIGEST_LEN], size_t count);
+
+/* Force a kernel: 0 = auto (default), 1 = scalar, 4/8/16 = lane count;
+   unsupported choices fall back to auto. Returns the lanes now in use. */
+int sha256_mb_select(int lanes);
+
+/* Lanes of the active kernel and its name ("scalar" or "shani" for one
+   lane, "sse2", "avx2", "avx512") */
+int sha256_mb_lanes(void);
+const char *sha256_mb_impl_name(void);
+
+#endif
@@ -0,0 +1,362 @@
+/*
+ * snapshot.c
+ *
+ * Writer, read-only mapping, single-leaf verification and top-down diff
+ * for Merkle snapshot files (see snapshot.h for the layout).
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+struct Snapshot {
+    const unsigned char *base;           /* start of the mapping */
+    size_t size;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+    const SnapshotHeader *hdr;
+    const uint8_t (*digests)[SHA256_DIGEST_LEN];
+    const uint32_t *name_at;
+    const uint32_t *by_name;
+    const char *names;
+    size_t level_start[SNAPSHOT_MAX_LEVELS];
+    size_t level_size[SNAPSHOT_MAX_LEVELS];
+    int levels;
+};
+
+/* Node counts per level for n leaves; returns the number of levels */
+static int level_shape(size_t n, size_t *start, size_t *size, size_t *total) {
+    int levels = 0;
+    size_t at = 0;
+    if (n == 0) { *total = 0; return 0; }
+    for (;;) {
+        if (levels == SNAPSHOT_MAX_LEVELS) return -1;
+        start[levels] = at;
+        size[levels] = n;
+        at += n;
+        levels++;
+        if (n == 1) break;
+        n = (n + 1) / 2;
+    }
+    *total = at;
+    return levels;
+}
+
+static size_t pad64(size_t n) {
+    return (n + 63) & ~(size_t)63;
+}
+
+/* ---------- Writer ---------- */
+
+typedef struct {
+    const char *name;
+    uint32_t leaf;
+} NameRef;
+
+static int cmp_name_ref(const void *a, const void *b) {
+    return strcmp(((const NameRef*)a)->name, ((const NameRef*)b)->name);
+}
+
+/* Write len bytes, then zero padding up to 'to' bytes in total */
+static int write_padded(FILE *f, const void *data, size_t len, size_t to) {
+    static const unsigned char zeros[64];
+    if (len && fwrite(data, 1, len, f) != len) return -1;
+    while (len < to) {
+        size_t chunk = to - len < sizeof(zeros) ? to - len : sizeof(zeros);
+        if (fwrite(zeros, 1, chunk, f) != chunk) return -1;
+        len += chunk;
+    }
+    return 0;
+}
+
+/* Emit header and sections in file order */
+static int write_file(const char *path, const SnapshotHeader *hdr,
+                      const uint8_t (*digests)[SHA256_DIGEST_LEN],
+                      const uint32_t *name_at, const uint32_t *by_name, const char *blob) {
+    size_t total = (size_t)hdr->digest_count, n = (size_t)hdr->leaf_count;
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int rc = write_padded(f, hdr, sizeof(*hdr), (size_t)hdr->digests_offset) == 0 &&
+             write_padded(f, digests, total * SHA256_DIGEST_LEN, total * SHA256_DIGEST_LEN) == 0 &&
+             write_padded(f, name_at, n * sizeof(uint32_t), n * sizeof(uint32_t)) == 0 &&
+             write_padded(f, by_name, n * sizeof(uint32_t), n * sizeof(uint32_t)) == 0 &&
+             write_padded(f, blob, (size_t)hdr->names_bytes, (size_t)hdr->names_bytes) == 0 ? 0 : -1;
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+int snapshot_write(const char *path, const uint8_t (*digests)[SHA256_DIGEST_LEN],
+                   size_t leaf_count, const char *const *names, int odd_rule) {
+    size_t start[SNAPSHOT_MAX_LEVELS], size[SNAPSHOT_MAX_LEVELS], total;
+    int levels = level_shape(leaf_count, start, size, &total);
+    if (levels < 0 || leaf_count > UINT32_MAX) return -1;
+
+    size_t names_bytes = 0;
+    for (size_t i = 0; i < leaf_count; ++i) names_bytes += strlen(names[i]) + 1;
+    if (names_bytes > UINT32_MAX) return -1;
+
+    size_t slots = leaf_count ? leaf_count : 1;
+    char *blob = malloc(names_bytes ? names_bytes : 1);
+    uint32_t *name_at = malloc(slots * sizeof(uint32_t));
+    uint32_t *by_name = malloc(slots * sizeof(uint32_t));
+    NameRef *refs = malloc(slots * sizeof(NameRef));
+    int rc = -1;
+    if (blob && name_at && by_name && refs) {
+        size_t off = 0;
+        for (size_t i = 0; i < leaf_count; ++i) {
+            size_t len = strlen(names[i]) + 1;
+            memcpy(blob + off, names[i], len);
+            name_at[i] = (uint32_t)off;
+            refs[i].name = names[i];
+            refs[i].leaf = (uint32_t)i;
+            off += len;
+        }
+        qsort(refs, leaf_count, sizeof(NameRef), cmp_name_ref);
+        for (size_t i = 0; i < leaf_count; ++i) by_name[i] = refs[i].leaf;
+
+        SnapshotHeader hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, SNAPSHOT_MAGIC, 4);
+        hdr.version = SNAPSHOT_VERSION;
+        hdr.odd_rule = (uint32_t)odd_rule;
+        hdr.level_count = (uint32_t)levels;
+        hdr.leaf_count = leaf_count;
+        hdr.digest_count = total;
+        hdr.digests_offset = pad64(sizeof(SnapshotHeader));
+        hdr.name_at_offset = hdr.digests_offset + total * SHA256_DIGEST_LEN;
+        hdr.by_name_offset = hdr.name_at_offset + leaf_count * sizeof(uint32_t);
+        hdr.names_offset = hdr.by_name_offset + leaf_count * sizeof(uint32_t);
+        hdr.names_bytes = names_bytes;
+        hdr.file_size = hdr.names_offset + names_bytes;
+        sha256_mb_single(blob, names_bytes, hdr.names_digest);
+
+        rc = write_file(path, &hdr, digests, name_at, by_name, blob);
+    }
+    free(blob);
+    free(name_at);
+    free(by_name);
+    free(refs);
+    return rc;
+}
+
+/* ---------- Reader ---------- */
+
+/* count elements of 'elem' bytes starting at 'off' end at or before
+   'limit', without overflowing */
+static int section_fits(uint64_t off, uint64_t count, uint64_t elem, uint64_t limit) {
+    return off <= limit && count <= (limit - off) / elem;
+}
+
+/* Every name offset lands inside 'names' (whose last byte is NUL, so each
+   name is terminated) and every by_name entry is a leaf index. Checked
+   once here, so lookups and diffs index the tables without checks. */
+static int tables_valid(const Snapshot *snap) {
+    size_t n = (size_t)snap->hdr->leaf_count;
+    uint64_t names_bytes = snap->hdr->names_bytes;
+    for (size_t i = 0; i < n; ++i) {
+        if (snap->name_at[i] >= names_bytes || snap->by_name[i] >= n) return 0;
+    }
+    return 1;
+}
+
+Snapshot *snapshot_open(const char *path) {
+    Snapshot *snap = calloc(1, sizeof(Snapshot));
+    if (!snap) return NULL;
+
+#if defined(_WIN32) || defined(_WIN64)
+    snap->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (snap->file == INVALID_HANDLE_VALUE) { free(snap); return NULL; }
+    LARGE_INTEGER size;
+    GetFileSizeEx(snap->file, &size);
+    snap->size = (size_t)size.QuadPart;
+    snap->mapping = CreateFileMappingA(snap->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (snap->mapping)
+        snap->base = (const unsigned char*)MapViewOfFile(snap->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!snap->base) { snapshot_close(snap); return NULL; }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { free(snap); return NULL; }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        snap->size = (size_t)st.st_size;
+        void *map = mmap(NULL, snap->size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) snap->base = (const unsigned char*)map;
+    }
+    close(fd);   /* the mapping stays valid after the descriptor is closed */
+    if (!snap->base) { free(snap); return NULL; }
+#endif
+
+    const SnapshotHeader *hdr = (const SnapshotHeader*)snap->base;
+    size_t total = 0;
+    if (snap->size < sizeof(SnapshotHeader) ||
+        memcmp(hdr->magic, SNAPSHOT_MAGIC, 4) != 0 || hdr->version != SNAPSHOT_VERSION ||
+        hdr->odd_rule > SNAPSHOT_ODD_DUPLICATE ||
+        hdr->file_size != snap->size || hdr->leaf_count > UINT32_MAX ||
+        (snap->levels = level_shape((size_t)hdr->leaf_count, snap->level_start,
+                                    snap->level_size, &total)) < 0 ||
+        (uint32_t)snap->levels != hdr->level_count || total != hdr->digest_count ||
+        hdr->digests_offset < sizeof(SnapshotHeader) ||
+        !section_fits(hdr->digests_offset, total, SHA256_DIGEST_LEN, hdr->name_at_offset) ||
+        hdr->name_at_offset % sizeof(uint32_t) != 0 || hdr->by_name_offset % sizeof(uint32_t) != 0 ||
+        !section_fits(hdr->name_at_offset, hdr->leaf_count, sizeof(uint32_t), hdr->by_name_offset) ||
+        !section_fits(hdr->by_name_offset, hdr->leaf_count, sizeof(uint32_t), hdr->names_offset) ||
+        hdr->names_offset > snap->size || hdr->names_bytes != snap->size - hdr->names_offset ||
+        (hdr->names_bytes && snap->base[snap->size - 1] != '\0')) {
+        snapshot_close(snap);
+        return NULL;
+    }
+    snap->hdr = hdr;
+    snap->digests = (const uint8_t (*)[SHA256_DIGEST_LEN])(snap->base + hdr->digests_offset);
+    snap->name_at = (const uint32_t*)(snap->base + hdr->name_at_offset);
+    snap->by_name = (const uint32_t*)(snap->base + hdr->by_name_offset);
+    snap->names = (const char*)snap->base + hdr->names_offset;
+    if (!tables_valid(snap)) {
+        snapshot_close(snap);
+        return NULL;
+    }
+    return snap;
+}
+
+void snapshot_close(Snapshot *snap) {
+    if (!snap) return;
+#if defined(_WIN32) || defined(_WIN64)
+    if (snap->base) UnmapViewOfFile(snap->base);
+    if (snap->mapping) CloseHandle(snap->mapping);
+    if (snap->file != INVALID_HANDLE_VALUE) CloseHandle(snap->file);
+#else
+    if (snap->base) munmap((void*)snap->base, snap->size);
+#endif
+    free(snap);
+}
+
+size_t snapshot_leaf_count(const Snapshot *snap) {
+    return (size_t)snap->hdr->leaf_count;
+}
+
+size_t snapshot_bytes(const Snapshot *snap) {
+    return snap->size;
+}
+
+const uint8_t *snapshot_root(const Snapshot *snap) {
+    return snap->levels ? snap->digests[snap->hdr->digest_count - 1] : NULL;
+}
+
+/* Filename of leaf i */
+static const char *leaf_name(const Snapshot *snap, size_t i) {
+    return snap->names + snap->name_at[i];
+}
+
+long snapshot_find(const Snapshot *snap, const char *name) {
+    size_t lo = 0, hi = (size_t)snap->hdr->leaf_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t leaf = snap->by_name[mid];
+        int c = strcmp(leaf_name(snap, leaf), name);
+        if (c == 0) return (long)leaf;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return -1;
+}
+
+int snapshot_verify_leaf(const Snapshot *snap, size_t leaf, const void *content, size_t len) {
+    if (leaf >= snap->hdr->leaf_count) return -1;
+    uint8_t cur[SHA256_DIGEST_LEN], pair[2 * SHA256_DIGEST_LEN];
+    sha256_mb_single(content, len, cur);
+    if (memcmp(cur, snap->digests[leaf], SHA256_DIGEST_LEN) != 0) return 0;
+
+    /* Hash up to the root with the stored siblings */
+    size_t j = leaf;
+    for (int lv = 0; lv + 1 < snap->levels; ++lv) {
+        size_t sib = j ^ 1;
+        if (sib < snap->level_size[lv]) {
+            const uint8_t *other = snap->digests[snap->level_start[lv] + sib];
+            memcpy(pair + ((j & 1) ? SHA256_DIGEST_LEN : 0), cur, SHA256_DIGEST_LEN);
+            memcpy(pair + ((j & 1) ? 0 : SHA256_DIGEST_LEN), other, SHA256_DIGEST_LEN);
+            sha256_mb_single(pair, sizeof(pair), cur);
+        } else if (snap->hdr->odd_rule == SNAPSHOT_ODD_DUPLICATE) {
+            memcpy(pair, cur, SHA256_DIGEST_LEN);
+            memcpy(pair + SHA256_DIGEST_LEN, cur, SHA256_DIGEST_LEN);
+            sha256_mb_single(pair, sizeof(pair), cur);
+        }
+        j /= 2;
+    }
+    return memcmp(cur, snapshot_root(snap), SHA256_DIGEST_LEN) == 0;
+}
+
+/* ---------- Diff ---------- */
+
+typedef struct {
+    const Snapshot *a, *b;
+    void (*fn)(const char *name, int kind, void *ctx);
+    void *ctx;
+    size_t found;
+} DiffCtx;
+
+static void report(DiffCtx *d, const char *name, int kind) {
+    d->found++;
+    if (d->fn) d->fn(name, kind, d->ctx);
+}
+
+/* Same shape: descend only where node digests differ */
+static void diff_node(DiffCtx *d, int lv, size_t j) {
+    const Snapshot *a = d->a, *b = d->b;
+    if (memcmp(a->digests[a->level_start[lv] + j], b->digests[b->level_start[lv] + j],
+               SHA256_DIGEST_LEN) == 0)
+        return;
+    if (lv == 0) {
+        report(d, leaf_name(b, j), SNAPSHOT_CHANGED);
+        return;
+    }
+    diff_node(d, lv - 1, 2 * j);
+    if (2 * j + 1 < a->level_size[lv - 1])
+        diff_node(d, lv - 1, 2 * j + 1);
+}
+
+/* Different files: merge the two sorted name tables */
+static void diff_merge(DiffCtx *d) {
+    const Snapshot *a = d->a, *b = d->b;
+    size_t i = 0, j = 0, na = (size_t)a->hdr->leaf_count, nb = (size_t)b->hdr->leaf_count;
+    while (i < na || j < nb) {
+        const char *an = i < na ? leaf_name(a, a->by_name[i]) : NULL;
+        const char *bn = j < nb ? leaf_name(b, b->by_name[j]) : NULL;
+        int c = !an ? 1 : !bn ? -1 : strcmp(an, bn);
+        if (c < 0) { report(d, an, SNAPSHOT_REMOVED); i++; }
+        else if (c > 0) { report(d, bn, SNAPSHOT_ADDED); j++; }
+        else {
+            if (memcmp(a->digests[a->by_name[i]], b->digests[b->by_name[j]], SHA256_DIGEST_LEN) != 0)
+                report(d, bn, SNAPSHOT_CHANGED);
+            i++; j++;
+        }
+    }
+}
+
+size_t snapshot_diff(const Snapshot *old_snap, const Snapshot *new_snap,
+                     void (*fn)(const char *name, int kind, void *ctx), void *ctx) {
+    DiffCtx d = { old_snap, new_snap, fn, ctx, 0 };
+    const SnapshotHeader *ha = old_snap->hdr, *hb = new_snap->hdr;
+    if (ha->leaf_count == hb->leaf_count && ha->odd_rule == hb->odd_rule &&
+        memcmp(ha->names_digest, hb->names_digest, SHA256_DIGEST_LEN) == 0) {
+        if (old_snap->levels) diff_node(&d, old_snap->levels - 1, 0);
+    } else {
+        diff_merge(&d);
+    }
+    return d.found;
+}
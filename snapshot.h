@@ -0,0 +1,91 @@
+/*
+ * snapshot.h
+ *
+ * Persistent Merkle snapshot: leaf digests, every interior level and the
+ * filename table in one binary file that is mapped read-only on load, so a
+ * later run can look up and verify a file without regenerating or
+ * rebuilding the tree.
+ *
+ * Layout (all integers little-endian host order, offsets from file start):
+ *   SnapshotHeader
+ *   digests   level 0 (leaves) .. root, 32 bytes each; level L+1 has
+ *             ceil(size(L) / 2) nodes and node j's children are 2j, 2j+1
+ *   name_at   uint32[leaf_count], offset of leaf i's name in 'names'
+ *   by_name   uint32[leaf_count], leaf indices sorted by filename
+ *   names     NUL-terminated filenames, in leaf order
+ * The header carries a SHA-256 of 'names', so two snapshots over the same
+ * files are recognised without comparing the tables.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sha256_mb.h"
+
+#define SNAPSHOT_MAGIC "MSNP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_MAX_LEVELS 64
+
+/* How a level with an odd node count pairs its last node */
+enum {
+    SNAPSHOT_ODD_PROMOTE = 0,    /* parent = node */
+    SNAPSHOT_ODD_DUPLICATE = 1   /* parent = H(node || node) */
+};
+
+/* Kinds of difference reported by snapshot_diff() */
+enum {
+    SNAPSHOT_CHANGED = 0,
+    SNAPSHOT_ADDED = 1,          /* only in the new snapshot */
+    SNAPSHOT_REMOVED = 2         /* only in the old snapshot */
+};
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t odd_rule;
+    uint32_t level_count;
+    uint64_t leaf_count;
+    uint64_t digest_count;       /* nodes over all levels */
+    uint64_t digests_offset;
+    uint64_t name_at_offset;
+    uint64_t by_name_offset;
+    uint64_t names_offset;
+    uint64_t names_bytes;
+    uint64_t file_size;
+    uint8_t names_digest[SHA256_DIGEST_LEN];
+} SnapshotHeader;
+
+typedef struct Snapshot Snapshot;
+
+/* Write a snapshot. 'digests' is the tree's level-ordered digest array
+   (leaves first, root last) and names[i] is the filename of leaf i.
+   Returns 0, or -1 on I/O or allocation failure. */
+int snapshot_write(const char *path, const uint8_t (*digests)[SHA256_DIGEST_LEN],
+                   size_t leaf_count, const char *const *names, int odd_rule);
+
+/* Map a snapshot read-only; NULL if missing or malformed */
+Snapshot *snapshot_open(const char *path);
+void snapshot_close(Snapshot *snap);
+
+size_t snapshot_leaf_count(const Snapshot *snap);
+size_t snapshot_bytes(const Snapshot *snap);
+const uint8_t *snapshot_root(const Snapshot *snap);
+
+/* Leaf index of a filename (binary search over the name table), or -1 */
+long snapshot_find(const Snapshot *snap, const char *name);
+
+/* Check content against leaf 'leaf': its digest must match the stored one
+   and, hashed up with the stored siblings, reproduce the stored root.
+   Returns 1 = valid, 0 = mismatch, -1 = bad index. */
+int snapshot_verify_leaf(const Snapshot *snap, size_t leaf, const void *content, size_t len);
+
+/* Report files that differ between two snapshots through fn(name, kind, ctx).
+   Trees of the same shape are compared top-down, descending only into
+   subtrees whose digests differ (O(k log n) for k changes); otherwise the
+   sorted name tables are merged. Returns the number of differences. */
+size_t snapshot_diff(const Snapshot *old_snap, const Snapshot *new_snap,
+                     void (*fn)(const char *name, int kind, void *ctx), void *ctx);
+
+#endif
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <string.h>
+#include "strpool.h"
+
+#define POOL_CHUNK (64 * 1024)
+
+// Header stored immediately before the bytes of every interned string
+typedef struct {
+    unsigned int hash;
+    unsigned int len;
+} StrHeader;
+
+// Strings are packed into large chunks (4-byte aligned headers)
+typedef struct PoolChunk {
+    struct PoolChunk* next;
+    size_t size;
+    size_t used;
+    char data[];
+} PoolChunk;
+
+static PoolChunk* chunks = NULL;
+static const char** table = NULL;   // open-addressing set of handles
+static size_t tableCapacity = 0;    // power of two, load factor <= 1/2
+static size_t stringCount = 0;
+static size_t poolBytes = 0;
+
+static const StrHeader* headerOf(const char* handle) {
+    return (const StrHeader*)(handle - sizeof(StrHeader));
+}
+
+unsigned int strpoolHashN(const char* s, size_t len) {
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+size_t strpoolLength(const char* handle) {
+    return headerOf(handle)->len;
+}
+
+unsigned int strpoolHash(const char* handle) {
+    return headerOf(handle)->hash;
+}
+
+// Probe for s[0..len); returns the slot holding it or the empty slot to use
+static size_t findSlot(const char* s, size_t len, unsigned int hash) {
+    size_t mask = tableCapacity - 1;
+    size_t i = hash & mask;
+    while (table[i] != NULL) {
+        const StrHeader* h = headerOf(table[i]);
+        if (h->hash == hash && h->len == len && memcmp(table[i], s, len) == 0)
+            return i;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+const char* strpoolFindN(const char* s, size_t len) {
+    if (tableCapacity == 0) return NULL;
+    return table[findSlot(s, len, strpoolHashN(s, len))];
+}
+
+const char* strpoolFind(const char* s) {
+    return strpoolFindN(s, strlen(s));
+}
+
+// Double the handle table (rehashing uses the cached hashes)
+static int growTable(void) {
+    size_t capacity = tableCapacity ? 2 * tableCapacity : 1024;
+    const char** grown = (const char**)calloc(capacity, sizeof(const char*));
+    if (grown == NULL) return -1;
+    for (size_t i = 0; i < tableCapacity; i++) {
+        if (table[i] == NULL) continue;
+        size_t j = strpoolHash(table[i]) & (capacity - 1);
+        while (grown[j] != NULL) j = (j + 1) & (capacity - 1);
+        grown[j] = table[i];
+    }
+    free(table);
+    table = grown;
+    tableCapacity = capacity;
+    return 0;
+}
+
+// Copy a new string into the current chunk, starting a new chunk if full
+static const char* storeString(const char* s, size_t len, unsigned int hash) {
+    size_t need = (sizeof(StrHeader) + len + 1 + 3) & ~(size_t)3;
+    if (chunks == NULL || chunks->size - chunks->used < need) {
+        size_t size = need > POOL_CHUNK ? need : POOL_CHUNK;
+        PoolChunk* chunk = (PoolChunk*)malloc(sizeof(PoolChunk) + size);
+        if (chunk == NULL) return NULL;
+        chunk->next = chunks;
+        chunk->size = size;
+        chunk->used = 0;
+        chunks = chunk;
+        poolBytes += sizeof(PoolChunk) + size;
+    }
+    StrHeader* header = (StrHeader*)(chunks->data + chunks->used);
+    chunks->used += need;
+    header->hash = hash;
+    header->len = (unsigned int)len;
+    char* bytes = (char*)(header + 1);
+    memcpy(bytes, s, len);
+    bytes[len] = '\0';
+    return bytes;
+}
+
+const char* strpoolIntern(const char* s) {
+    size_t len = strlen(s);
+    unsigned int hash = strpoolHashN(s, len);
+    if (2 * (stringCount + 1) > tableCapacity && growTable() != 0)
+        return NULL;
+
+    size_t slot = findSlot(s, len, hash);
+    if (table[slot] != NULL)
+        return table[slot];   // already interned: share the existing copy
+
+    const char* handle = storeString(s, len, hash);
+    if (handle == NULL) return NULL;
+    table[slot] = handle;
+    stringCount++;
+    return handle;
+}
+
+void strpoolStats(size_t* count, size_t* bytes) {
+    if (count) *count = stringCount;
+    if (bytes) *bytes = poolBytes + tableCapacity * sizeof(const char*);
+}
+
+void strpoolReset(void) {
+    while (chunks != NULL) {
+        PoolChunk* next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+    free(table);
+    table = NULL;
+    tableCapacity = 0;
+    stringCount = 0;
+    poolBytes = 0;
+}
@@ -0,0 +1,32 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include <stddef.h>
+
+// Shared string-interning pool for node names.
+// Each distinct string is stored once, length-prefixed (with its hash),
+// and identified by a stable handle: a pointer to its NUL-terminated bytes.
+// Two handles are equal exactly when the strings are equal, so names can
+// be compared with == instead of strcmp, and a handle prints like a string.
+
+// Return the handle for 's', adding it to the pool if needed (NULL on OOM)
+const char* strpoolIntern(const char* s);
+
+// Return the handle for 's' (or s[0..len)) if interned, else NULL
+const char* strpoolFind(const char* s);
+const char* strpoolFindN(const char* s, size_t len);
+
+// Length and hash stored in front of an interned string (O(1))
+size_t strpoolLength(const char* handle);
+unsigned int strpoolHash(const char* handle);
+
+// Hash used by the pool (FNV-1a), for callers hashing raw strings
+unsigned int strpoolHashN(const char* s, size_t len);
+
+// Number of distinct strings and bytes held by the pool
+void strpoolStats(size_t* count, size_t* bytes);
+
+// Release every interned string; all handles become invalid
+void strpoolReset(void);
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * threadpool.c
+ *
+ * Workers sleep on a condition variable until a loop is posted, then claim
+ * chunks from a shared atomic counter until the range is exhausted.
+ */
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "threadpool.h"
+
+struct ThreadPool {
+    int size;                   /* threads per loop, including the caller */
+    pthread_t *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;       /* a new loop (generation) was posted */
+    pthread_cond_t done;        /* the last worker finished the loop */
+    unsigned long generation;
+    int active;                 /* workers still inside the current loop */
+    int stop;
+
+    /* current loop */
+    parallel_body_fn body;
+    void *ctx;
+    size_t n, chunk;
+    atomic_size_t next;
+};
+
+/* Claim and run chunks until the range is used up */
+static void run_chunks(ThreadPool *pool) {
+    for (;;) {
+        size_t begin = atomic_fetch_add(&pool->next, pool->chunk);
+        if (begin >= pool->n) break;
+        size_t end = begin + pool->chunk < pool->n ? begin + pool->chunk : pool->n;
+        pool->body(begin, end, pool->ctx);
+    }
+}
+
+static void *worker_main(void *arg) {
+    ThreadPool *pool = arg;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->stop) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_chunks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool *threadpool_create(int threads) {
+    if (threads < 1) threads = 1;
+    ThreadPool *pool = calloc(1, sizeof(*pool));
+    if (!pool) return NULL;
+    pool->size = threads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    atomic_init(&pool->next, 0);
+
+    if (threads > 1) {
+        pool->workers = calloc((size_t)threads - 1, sizeof(pthread_t));
+        if (!pool->workers) { threadpool_free(pool); return NULL; }
+        for (int i = 0; i < threads - 1; ++i) {
+            if (pthread_create(&pool->workers[i], NULL, worker_main, pool) != 0) {
+                pool->size = i + 1;   /* run with the threads we got */
+                break;
+            }
+        }
+    }
+    return pool;
+}
+
+int threadpool_size(const ThreadPool *pool) {
+    return pool ? pool->size : 1;
+}
+
+void threadpool_parallel_for(ThreadPool *pool, size_t n, size_t chunk,
+                             parallel_body_fn body, void *ctx) {
+    if (n == 0) return;
+    if (!pool || pool->size == 1) { body(0, n, ctx); return; }
+    if (chunk == 0) {
+        /* ~4 chunks per thread balances load without much counter traffic */
+        chunk = n / ((size_t)pool->size * 4);
+        if (chunk == 0) chunk = 1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->body = body;
+    pool->ctx = ctx;
+    pool->n = n;
+    pool->chunk = chunk;
+    atomic_store(&pool->next, 0);
+    pool->active = pool->size - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void threadpool_free(ThreadPool *pool) {
+    if (!pool) return;
+    if (pool->workers) {
+        pthread_mutex_lock(&pool->lock);
+        pool->stop = 1;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+        for (int i = 0; i < pool->size - 1; ++i)
+            pthread_join(pool->workers[i], NULL);
+        free(pool->workers);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool);
+}
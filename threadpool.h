@@ -0,0 +1,34 @@
+/*
+ * threadpool.h
+ *
+ * Small fixed-size worker pool for data-parallel loops, used by the Merkle
+ * driver to hash leaves in parallel chunks and to reduce each tree level
+ * in parallel. The calling thread takes part in every loop, so a pool of
+ * size 1 has no worker threads and runs the loop inline.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stddef.h>
+
+typedef struct ThreadPool ThreadPool;
+
+/* body(begin, end, ctx) processes the half-open index range [begin, end) */
+typedef void (*parallel_body_fn)(size_t begin, size_t end, void *ctx);
+
+/* Create a pool with 'threads' total threads (including the caller) */
+ThreadPool *threadpool_create(int threads);
+
+/* Number of threads taking part in each loop */
+int threadpool_size(const ThreadPool *pool);
+
+/* Run body over [0, n) in chunks of 'chunk' indices (0 = pick a size);
+   returns when every chunk has finished */
+void threadpool_parallel_for(ThreadPool *pool, size_t n, size_t chunk,
+                             parallel_body_fn body, void *ctx);
+
+/* Stop the workers and free the pool */
+void threadpool_free(ThreadPool *pool);
+
+#endif
@@ -1,72 +1,864 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include "trie.h"
-
-// Create a new Trie node
-TrieNode* createNode() {
-    TrieNode *node = (TrieNode*)malloc(sizeof(TrieNode));
-    node->isEndOfFile = 0;
-    for (int i = 0; i < CHAR_SIZE; i++)
-        node->children[i] = NULL;
-    return node;
-}
-
-// Insert a file path into the Trie
-void insertFile(TrieNode *root, const char *path) {
-    TrieNode *curr = root;
-    for (int i = 0; path[i] != '\0'; i++) {
-        int index = (int)path[i];
-        if (!curr->children[index])
-            curr->children[index] = createNode();
-        curr = curr->children[index];
-    }
-    curr->isEndOfFile = 1;
-}
-
-// Search for a full file path
-int searchFile(TrieNode *root, const char *path) {
-    TrieNode *curr = root;
-    for (int i = 0; path[i] != '\0'; i++) {
-        int index = (int)path[i];
-        if (!curr->children[index])
-            return 0;
-        curr = curr->children[index];
-    }
-    return curr->isEndOfFile;
-}
-
-// Check if any file starts with the given prefix
-int startsWith(TrieNode *root, const char *prefix) {
-    TrieNode *curr = root;
-    for (int i = 0; prefix[i] != '\0'; i++) {
-        int index = (int)prefix[i];
-        if (!curr->children[index])
-            return 0;
-        curr = curr->children[index];
-    }
-    return 1;
-}
-
-// Recursively print all files that share a given prefix
-void printFilesWithPrefix(TrieNode *root, char *prefix, int level) {
-    if (root->isEndOfFile) {
-        prefix[level] = '\0';
-        printf("  %s\n", prefix);
-    }
-    for (int i = 0; i < CHAR_SIZE; i++) {
-        if (root->children[i]) {
-            prefix[level] = (char)i;
-            printFilesWithPrefix(root->children[i], prefix, level + 1);
-        }
-    }
-}
-
-// Free the Trie memory
-void freeTrie(TrieNode *root) {
-    for (int i = 0; i < CHAR_SIZE; i++) {
-        if (root->children[i])
-            freeTrie(root->children[i]);
-    }
-    free(root);
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trie.h"
+
+#ifndef TRIE_RADIX
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static Arena *nodeArena = NULL;   // optional node allocator
+
+#ifdef TRIE_COUNTS
+#define COUNT_FILE(node) ((node)->files++)
+#else
+#define COUNT_FILE(node) ((void)0)
+#endif
+
+// Route node allocation through an arena (NULL = malloc/free)
+void trieSetArena(Arena *arena) {
+    nodeArena = arena;
+}
+
+// Bytes occupied by one node of the given layout
+static size_t nodeSize(const TrieNode *node) {
+    switch (node->type) {
+        case TRIE_NODE4:  return sizeof(TrieNode4);
+        case TRIE_NODE16: return sizeof(TrieNode16);
+        case TRIE_NODE48: return sizeof(TrieNode48);
+        default:          return sizeof(TrieNode256);
+    }
+}
+
+// Release one node to the arena or the heap
+static void releaseNode(TrieNode *node) {
+    if (nodeArena)
+        arenaRelease(nodeArena, node, nodeSize(node));
+    else
+        free(node);
+}
+
+// Allocate an empty node of the given layout (NULL if memory ran out)
+static TrieNode* allocNode(unsigned char type) {
+    size_t size;
+    switch (type) {
+        case TRIE_NODE4:  size = sizeof(TrieNode4);  break;
+        case TRIE_NODE16: size = sizeof(TrieNode16); break;
+        case TRIE_NODE48: size = sizeof(TrieNode48); break;
+        default:          size = sizeof(TrieNode256); break;
+    }
+    TrieNode *node;
+    if (nodeArena) {
+        node = (TrieNode*)arenaAlloc(nodeArena, size);
+        if (node) memset(node, 0, size);
+    } else {
+        node = (TrieNode*)calloc(1, size);
+    }
+    if (!node) return NULL;
+    node->type = type;
+    return node;
+}
+
+// Create a new Trie root. The root is always dense: it is never replaced
+// by a larger layout, so the caller's pointer stays valid across inserts.
+TrieNode* createNode() {
+    return allocNode(TRIE_NODE256);
+}
+
+// Copy the children of a full node into the next larger layout.
+// Returns NULL, leaving the node as it was, if memory ran out.
+static TrieNode* growNode(TrieNode *node) {
+    static const unsigned char next[] = { TRIE_NODE16, TRIE_NODE48, TRIE_NODE256 };
+    TrieNode *bigger = allocNode(next[node->type]);
+    if (!bigger) return NULL;
+    switch (node->type) {
+        case TRIE_NODE4: {
+            TrieNode4 *n = (TrieNode4*)node;
+            TrieNode16 *b = (TrieNode16*)bigger;
+            memcpy(b->keys, n->keys, sizeof(n->keys));
+            memcpy(b->children, n->children, sizeof(n->children));
+            break;
+        }
+        case TRIE_NODE16: {
+            TrieNode16 *n = (TrieNode16*)node;
+            TrieNode48 *b = (TrieNode48*)bigger;
+            for (int i = 0; i < n->hdr.count; i++) {
+                b->children[i] = n->children[i];
+                b->index[n->keys[i]] = (unsigned char)(i + 1);
+            }
+            break;
+        }
+        default: {
+            TrieNode48 *n = (TrieNode48*)node;
+            TrieNode256 *b = (TrieNode256*)bigger;
+            for (int c = 0; c < CHAR_SIZE; c++)
+                if (n->index[c])
+                    b->children[c] = n->children[n->index[c] - 1];
+            break;
+        }
+    }
+    bigger->count = node->count;
+    bigger->isEndOfFile = node->isEndOfFile;
+#ifdef TRIE_COUNTS
+    bigger->files = node->files;
+#endif
+    releaseNode(node);
+    return bigger;
+}
+
+// Insert 'child' under character c and return the slot now holding it.
+// *ref is replaced when the node has to grow into a larger layout.
+// Returns NULL, with nothing changed, if the larger layout cannot be allocated.
+static TrieNode** addChild(TrieNode **ref, unsigned char c, TrieNode *child) {
+    TrieNode **slot;
+    TrieNode *node = *ref;
+    if ((node->type == TRIE_NODE4 && node->count == 4) ||
+        (node->type == TRIE_NODE16 && node->count == 16) ||
+        (node->type == TRIE_NODE48 && node->count == 48)) {
+        node = growNode(node);
+        if (!node) return NULL;
+        *ref = node;
+    }
+    switch (node->type) {
+        case TRIE_NODE4:
+        case TRIE_NODE16: {
+            // Keep keys sorted so listings come out in lexicographic order
+            unsigned char *keys = node->type == TRIE_NODE4 ? ((TrieNode4*)node)->keys
+                                                           : ((TrieNode16*)node)->keys;
+            TrieNode **children = node->type == TRIE_NODE4 ? ((TrieNode4*)node)->children
+                                                           : ((TrieNode16*)node)->children;
+            int pos = node->count;
+            while (pos > 0 && keys[pos - 1] > c) {
+                keys[pos] = keys[pos - 1];
+                children[pos] = children[pos - 1];
+                pos--;
+            }
+            keys[pos] = c;
+            children[pos] = child;
+            slot = &children[pos];
+            break;
+        }
+        case TRIE_NODE48: {
+            TrieNode48 *n = (TrieNode48*)node;
+            n->children[n->hdr.count] = child;
+            n->index[c] = (unsigned char)(n->hdr.count + 1);
+            slot = &n->children[n->hdr.count];
+            break;
+        }
+        default:
+            slot = &((TrieNode256*)node)->children[c];
+            *slot = child;
+            break;
+    }
+    node->count++;
+    return slot;
+}
+
+// Return the slot holding the child for character c, or NULL if absent
+static TrieNode** childSlot(TrieNode *node, unsigned char c) {
+    switch (node->type) {
+        case TRIE_NODE4: {
+            TrieNode4 *n = (TrieNode4*)node;
+            for (int i = 0; i < n->hdr.count; i++)
+                if (n->keys[i] == c)
+                    return &n->children[i];
+            return NULL;
+        }
+        case TRIE_NODE16: {
+            TrieNode16 *n = (TrieNode16*)node;
+#ifdef __SSE2__
+            __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)c),
+                                         _mm_loadu_si128((const __m128i*)n->keys));
+            unsigned mask = (unsigned)_mm_movemask_epi8(cmp) & ((1u << n->hdr.count) - 1);
+            return mask ? &n->children[__builtin_ctz(mask)] : NULL;
+#else
+            for (int i = 0; i < n->hdr.count; i++)
+                if (n->keys[i] == c)
+                    return &n->children[i];
+            return NULL;
+#endif
+        }
+        case TRIE_NODE48: {
+            TrieNode48 *n = (TrieNode48*)node;
+            return n->index[c] ? &n->children[n->index[c] - 1] : NULL;
+        }
+        default: {
+            TrieNode256 *n = (TrieNode256*)node;
+            return n->children[c] ? &n->children[c] : NULL;
+        }
+    }
+}
+
+// Find the child reached by character c, or NULL
+static TrieNode* findChild(TrieNode *node, unsigned char c) {
+    TrieNode **slot = childSlot(node, c);
+    return slot ? *slot : NULL;
+}
+
+// Call fn(child, key, ctx) for each child in ascending key order
+static void forEachChild(TrieNode *node,
+                         void (*fn)(TrieNode *child, unsigned char c, void *ctx), void *ctx) {
+    switch (node->type) {
+        case TRIE_NODE4: {
+            TrieNode4 *n = (TrieNode4*)node;
+            for (int i = 0; i < n->hdr.count; i++)
+                fn(n->children[i], n->keys[i], ctx);
+            break;
+        }
+        case TRIE_NODE16: {
+            TrieNode16 *n = (TrieNode16*)node;
+            for (int i = 0; i < n->hdr.count; i++)
+                fn(n->children[i], n->keys[i], ctx);
+            break;
+        }
+        case TRIE_NODE48: {
+            TrieNode48 *n = (TrieNode48*)node;
+            for (int c = 0; c < CHAR_SIZE; c++)
+                if (n->index[c])
+                    fn(n->children[n->index[c] - 1], (unsigned char)c, ctx);
+            break;
+        }
+        default: {
+            TrieNode256 *n = (TrieNode256*)node;
+            for (int c = 0; c < CHAR_SIZE; c++)
+                if (n->children[c])
+                    fn(n->children[c], (unsigned char)c, ctx);
+            break;
+        }
+    }
+}
+
+#ifdef TRIE_COUNTS
+// Take back the counts insertFile() added on the way down to 'last'
+// (a path that was already stored, or an insert that ran out of memory)
+static void uncountPath(TrieNode *root, const char *path, const TrieNode *last) {
+    TrieNode *curr = root;
+    for (int i = 0; curr != last; i++) {
+        curr->files--;
+        curr = findChild(curr, (unsigned char)path[i]);
+    }
+    curr->files--;
+}
+#define UNCOUNT_PATH(root, path, last) uncountPath(root, path, last)
+#else
+#define UNCOUNT_PATH(root, path, last) ((void)0)
+#endif
+
+// Add a new empty child under c; NULL if memory ran out
+static TrieNode** addNewChild(TrieNode **ref, unsigned char c) {
+    TrieNode *child = allocNode(TRIE_NODE4);
+    if (!child) return NULL;
+    TrieNode **slot = addChild(ref, c, child);
+    if (!slot) releaseNode(child);
+    return slot;
+}
+
+// Insert a file path into the Trie
+int insertFile(TrieNode *root, const char *path) {
+    TrieNode *curr = root;
+    TrieNode **ref = &curr;   // slot holding curr; the root never grows
+    for (int i = 0; path[i] != '\0'; i++) {
+        unsigned char c = (unsigned char)path[i];
+        COUNT_FILE(curr);     // growing curr below carries the count over
+        TrieNode **slot = childSlot(curr, c);
+        if (!slot && !(slot = addNewChild(ref, c))) {
+            UNCOUNT_PATH(root, path, curr);
+            return -1;
+        }
+        ref = slot;
+        curr = *slot;
+    }
+    COUNT_FILE(curr);
+    if (curr->isEndOfFile) {
+        UNCOUNT_PATH(root, path, curr);
+        return 0;
+    }
+    curr->isEndOfFile = 1;
+    return 0;
+}
+
+// Unlink the child under character c. The node keeps its layout; a
+// Node48 moves its last slot into the freed one so slots stay dense.
+static void removeChild(TrieNode *node, unsigned char c) {
+    switch (node->type) {
+        case TRIE_NODE4:
+        case TRIE_NODE16: {
+            unsigned char *keys = node->type == TRIE_NODE4 ? ((TrieNode4*)node)->keys
+                                                           : ((TrieNode16*)node)->keys;
+            TrieNode **children = node->type == TRIE_NODE4 ? ((TrieNode4*)node)->children
+                                                           : ((TrieNode16*)node)->children;
+            int pos = 0;
+            while (keys[pos] != c) pos++;
+            for (; pos + 1 < node->count; pos++) {
+                keys[pos] = keys[pos + 1];
+                children[pos] = children[pos + 1];
+            }
+            break;
+        }
+        case TRIE_NODE48: {
+            TrieNode48 *n = (TrieNode48*)node;
+            int slot = n->index[c] - 1, last = n->hdr.count - 1;
+            if (slot != last) {
+                n->children[slot] = n->children[last];
+                for (int k = 0; k < CHAR_SIZE; k++)
+                    if (n->index[k] == last + 1) {
+                        n->index[k] = (unsigned char)(slot + 1);
+                        break;
+                    }
+            }
+            n->children[last] = NULL;
+            n->index[c] = 0;
+            break;
+        }
+        default:
+            ((TrieNode256*)node)->children[c] = NULL;
+            break;
+    }
+    node->count--;
+}
+
+// Remove a file path; returns 1 if it was stored, else 0
+int removeFile(TrieNode *root, const char *path) {
+    // Find the file and the deepest node above it that must stay: the
+    // root, a file, or a node with other children. Everything below that
+    // node on the path only leads to this file.
+    TrieNode *curr = root, *keep = root;
+    size_t keepDepth = 0, len = 0;
+    for (; path[len] != '\0'; len++) {
+        if (curr->isEndOfFile || curr->count > 1) {
+            keep = curr;
+            keepDepth = len;
+        }
+        curr = findChild(curr, (unsigned char)path[len]);
+        if (!curr)
+            return 0;
+    }
+    if (!curr->isEndOfFile)
+        return 0;
+    UNCOUNT_PATH(root, path, curr);
+    curr->isEndOfFile = 0;
+    if (curr == root || curr->count > 0)
+        return 1;
+
+    TrieNode *node = findChild(keep, (unsigned char)path[keepDepth]);
+    removeChild(keep, (unsigned char)path[keepDepth]);
+    for (size_t d = keepDepth + 1; node; d++) {
+        TrieNode *next = d < len ? findChild(node, (unsigned char)path[d]) : NULL;
+        releaseNode(node);
+        node = next;
+    }
+    return 1;
+}
+
+struct TrieSortedCursor {
+    TrieNode *root;
+    char *prev;          // previous path
+    size_t prevLen;
+    TrieNode ***refs;    // refs[d]: slot holding the node at depth d of prev
+    size_t cap;          // capacity of prev and refs
+};
+
+TrieSortedCursor* trieSortedBegin(TrieNode *root) {
+    TrieSortedCursor *cur = (TrieSortedCursor*)calloc(1, sizeof(TrieSortedCursor));
+    if (!cur) return NULL;
+    cur->root = root;
+    cur->cap = 256;
+    cur->prev = (char*)malloc(cur->cap);
+    cur->refs = (TrieNode***)malloc((cur->cap + 1) * sizeof(TrieNode**));
+    if (!cur->prev || !cur->refs) {
+        trieSortedEnd(cur);
+        return NULL;
+    }
+    cur->refs[0] = &cur->root;   // the root never grows, so this stays valid
+    return cur;
+}
+
+// Insert path[0..len), starting from the deepest node shared with the
+// previous path. Nodes on the shared prefix are only replaced (grown) when
+// a child is added to them, which only happens at the divergence depth,
+// whose slot lives in its unchanged parent, so the cached refs stay valid.
+int trieSortedInsert(TrieSortedCursor *cur, const char *path, size_t len) {
+    if (len > cur->cap) {
+        size_t cap = cur->cap;
+        while (cap < len) cap *= 2;
+        char *prev = (char*)realloc(cur->prev, cap);
+        if (!prev) return -1;
+        cur->prev = prev;
+        TrieNode ***refs = (TrieNode***)realloc(cur->refs, (cap + 1) * sizeof(TrieNode**));
+        if (!refs) return -1;
+        cur->refs = refs;
+        cur->cap = cap;
+    }
+
+    size_t lcp = 0;
+    while (lcp < len && lcp < cur->prevLen && path[lcp] == cur->prev[lcp])
+        lcp++;
+
+    TrieNode **ref = cur->refs[lcp];
+    TrieNode *curr = *ref;
+    for (size_t i = lcp; i < len; i++) {
+        unsigned char c = (unsigned char)path[i];
+        TrieNode **slot = childSlot(curr, c);
+        if (!slot && !(slot = addNewChild(ref, c))) {
+            // refs past lcp now describe this path, not prev: forget them
+            cur->prevLen = lcp;
+            return -1;
+        }
+        cur->refs[i + 1] = slot;
+        ref = slot;
+        curr = *slot;
+    }
+#ifdef TRIE_COUNTS
+    if (!curr->isEndOfFile)
+        for (size_t d = 0; d <= len; d++)
+            (*cur->refs[d])->files++;
+#endif
+    curr->isEndOfFile = 1;
+
+    memcpy(cur->prev + lcp, path + lcp, len - lcp);
+    cur->prevLen = len;
+    return 0;
+}
+
+void trieSortedEnd(TrieSortedCursor *cur) {
+    if (!cur) return;
+    free(cur->prev);
+    free(cur->refs);
+    free(cur);
+}
+
+// Search for a full file path
+int searchFile(TrieNode *root, const char *path) {
+    TrieNode *curr = root;
+    for (int i = 0; path[i] != '\0'; i++) {
+        curr = findChild(curr, (unsigned char)path[i]);
+        if (!curr)
+            return 0;
+    }
+    return curr->isEndOfFile;
+}
+
+#define BATCH_LANES 16   // lookups in flight at once
+
+typedef struct {
+    TrieNode *node;
+    const char *p;       // rest of the path below node
+    size_t query;
+} BatchLane;
+
+size_t searchFileBatch(TrieNode *root, const char *const *paths, size_t count, uint64_t *found) {
+    BatchLane lanes[BATCH_LANES];
+    size_t next = 0, hits = 0;
+    int active = 0;
+    memset(found, 0, (count + 63) / 64 * sizeof(uint64_t));
+    for (; active < BATCH_LANES && next < count; active++, next++)
+        lanes[active] = (BatchLane){ root, paths[next], next };
+
+    // Round-robin: each lane takes one step, then the next lane runs while
+    // the node it just prefetched is on its way
+    while (active > 0) {
+        for (int l = 0; l < active; ) {
+            BatchLane *lane = &lanes[l];
+            int hit;
+            if (*lane->p != '\0') {
+                TrieNode *child = findChild(lane->node, (unsigned char)*lane->p);
+                if (child) {
+                    __builtin_prefetch(child);
+                    lane->node = child;
+                    lane->p++;
+                    l++;
+                    continue;
+                }
+                hit = 0;
+            } else {
+                hit = lane->node->isEndOfFile;
+            }
+            if (hit) {
+                found[lane->query / 64] |= 1ull << (lane->query % 64);
+                hits++;
+            }
+            if (next < count) {
+                *lane = (BatchLane){ root, paths[next], next };
+                next++;
+                l++;
+            } else {
+                *lane = lanes[--active];   // takes its step at this index
+            }
+        }
+    }
+    return hits;
+}
+
+// Check if any file starts with the given prefix
+int startsWith(TrieNode *root, const char *prefix) {
+    TrieNode *curr = root;
+    for (int i = 0; prefix[i] != '\0'; i++) {
+        curr = findChild(curr, (unsigned char)prefix[i]);
+        if (!curr)
+            return 0;
+    }
+    return 1;
+}
+
+// The child at the first key position >= *pos, or NULL; *pos moves past it
+static TrieNode* nextChild(TrieNode *node, int *pos, unsigned char *key) {
+    switch (node->type) {
+        case TRIE_NODE4:
+        case TRIE_NODE16: {
+            if (*pos >= node->count) return NULL;
+            const unsigned char *keys = node->type == TRIE_NODE4 ? ((TrieNode4*)node)->keys
+                                                                 : ((TrieNode16*)node)->keys;
+            TrieNode **children = node->type == TRIE_NODE4 ? ((TrieNode4*)node)->children
+                                                           : ((TrieNode16*)node)->children;
+            *key = keys[*pos];
+            return children[(*pos)++];
+        }
+        case TRIE_NODE48: {
+            TrieNode48 *n = (TrieNode48*)node;
+            for (int c = *pos; c < CHAR_SIZE; c++)
+                if (n->index[c]) {
+                    *pos = c + 1;
+                    *key = (unsigned char)c;
+                    return n->children[n->index[c] - 1];
+                }
+            break;
+        }
+        default: {
+            TrieNode256 *n = (TrieNode256*)node;
+            for (int c = *pos; c < CHAR_SIZE; c++)
+                if (n->children[c]) {
+                    *pos = c + 1;
+                    *key = (unsigned char)c;
+                    return n->children[c];
+                }
+            break;
+        }
+    }
+    *pos = CHAR_SIZE;
+    return NULL;
+}
+
+typedef struct {
+    TrieNode *node;
+    int pos;             // next child position; -1 = node itself not visited yet
+} IterFrame;
+
+// stack[d] is the node reached by path[0..base + d); one character per level
+struct TrieIter {
+    char *path;
+    IterFrame *stack;
+    size_t cap;          // bytes of path and frames of stack
+    size_t base;
+    size_t depth;        // frames in use
+    int pending;         // path[0..base + depth - 1) is a match not handed out yet
+    int failed;          // a longer path could not be buffered; listing stopped
+};
+
+TrieIter* trieIterCreate(void) {
+    TrieIter *it = (TrieIter*)calloc(1, sizeof(TrieIter));
+    if (!it) return NULL;
+    it->cap = TRIE_ITER_MAX_PATH;
+    it->path = (char*)malloc(it->cap);
+    it->stack = (IterFrame*)malloc(it->cap * sizeof(IterFrame));
+    if (!it->path || !it->stack) {
+        trieIterFree(it);
+        return NULL;
+    }
+    return it;
+}
+
+void trieIterFree(TrieIter *it) {
+    if (!it) return;
+    free(it->path);
+    free(it->stack);
+    free(it);
+}
+
+// Make path and stack hold at least 'need' entries
+static int iterReserve(TrieIter *it, size_t need) {
+    if (need <= it->cap) return 0;
+    size_t cap = it->cap;
+    while (cap < need) cap *= 2;
+    char *path = (char*)realloc(it->path, cap);
+    if (!path) return -1;
+    it->path = path;
+    IterFrame *stack = (IterFrame*)realloc(it->stack, cap * sizeof(IterFrame));
+    if (!stack) return -1;
+    it->stack = stack;
+    it->cap = cap;
+    return 0;
+}
+
+int trieIterFailed(const TrieIter *it) {
+    return it->failed;
+}
+
+// Start listing below 'node', whose path is already in it->path[0..len)
+static void iterStart(TrieIter *it, TrieNode *node, size_t len) {
+    it->stack[0].node = node;
+    it->stack[0].pos = -1;
+    it->base = len;
+    it->depth = 1;
+    it->pending = 0;
+}
+
+// Advance to the next match, passing over *skip matches first. Subtrees
+// that hold no more files than are left to skip are never entered when
+// nodes carry counts. Returns 1 with the match in path, or 0 at the end.
+static int iterStep(TrieIter *it, size_t *skip) {
+    while (it->depth > 0) {
+        IterFrame *f = &it->stack[it->depth - 1];
+        if (f->pos < 0) {
+            f->pos = 0;
+            if (f->node->isEndOfFile) {
+                if (*skip == 0) return 1;
+                (*skip)--;
+            }
+            continue;
+        }
+        unsigned char c;
+        TrieNode *child = nextChild(f->node, &f->pos, &c);
+        if (!child) {
+            it->depth--;
+            continue;
+        }
+        size_t len = it->base + it->depth - 1;
+#ifdef TRIE_COUNTS
+        if (child->files <= *skip) {
+            *skip -= child->files;
+            continue;
+        }
+#endif
+        if (iterReserve(it, len + 2) != 0) {
+            it->failed = 1;
+            it->depth = 0;
+            return 0;
+        }
+        it->path[len] = (char)c;
+        it->stack[it->depth].node = child;
+        it->stack[it->depth].pos = -1;
+        it->depth++;
+    }
+    return 0;
+}
+
+int trieIterReset(TrieIter *it, TrieNode *root, const char *prefix) {
+    size_t len = strlen(prefix);
+    it->depth = 0;
+    it->pending = 0;
+    it->failed = 0;
+    TrieNode *node = root;
+    for (size_t i = 0; i < len; i++) {
+        node = findChild(node, (unsigned char)prefix[i]);
+        if (!node) return 0;
+    }
+    if (iterReserve(it, len + 1) != 0) {
+        it->failed = 1;
+        return 0;
+    }
+    memcpy(it->path, prefix, len);
+    iterStart(it, node, len);
+    return 1;
+}
+
+size_t trieIterNext(TrieIter *it, char *buf, size_t bufSize, size_t limit) {
+    size_t n = 0, used = 0, skip = 0;
+    while (n < limit) {
+        if (!it->pending && !(it->pending = iterStep(it, &skip))) break;
+        size_t len = it->base + it->depth - 1;
+        if (used + len + 1 > bufSize) break;
+        memcpy(buf + used, it->path, len);
+        buf[used + len] = '\0';
+        used += len + 1;
+        it->pending = 0;
+        n++;
+    }
+    return n;
+}
+
+size_t trieIterSkip(TrieIter *it, size_t n) {
+    size_t skip = n;
+    if (it->pending && skip > 0) {
+        it->pending = 0;
+        skip--;
+    }
+    if (skip > 0) it->pending = iterStep(it, &skip);
+    return n - skip;
+}
+
+int trieIterDone(TrieIter *it) {
+    size_t skip = 0;
+    if (!it->pending) it->pending = iterStep(it, &skip);
+    return !it->pending;
+}
+
+// Nodes still to visit in a whole-subtree walk. A trie is one level deep
+// per path byte, so walks keep their pending nodes here on the heap, not
+// on the call stack.
+typedef struct {
+    TrieNode **nodes;
+    size_t count;
+    size_t cap;
+} NodeStack;
+
+// Returns -1 if the stack cannot grow; callers then handle that node by
+// recursing, so a walk never skips one
+static int nodeStackPush(NodeStack *s, TrieNode *node) {
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 64;
+        TrieNode **grown = (TrieNode**)realloc(s->nodes, cap * sizeof(TrieNode*));
+        if (!grown) return -1;
+        s->nodes = grown;
+        s->cap = cap;
+    }
+    s->nodes[s->count++] = node;
+    return 0;
+}
+
+#ifndef TRIE_COUNTS
+typedef struct {
+    NodeStack stack;
+    size_t files;
+} CountWalk;
+
+static size_t countFiles(TrieNode *node);
+
+static void countChild(TrieNode *child, unsigned char c, void *ctx) {
+    (void)c;
+    CountWalk *cw = (CountWalk*)ctx;
+    if (nodeStackPush(&cw->stack, child) != 0) cw->files += countFiles(child);
+}
+
+static size_t countFiles(TrieNode *node) {
+    CountWalk cw = { { NULL, 0, 0 }, 0 };
+    for (;;) {
+        cw.files += node->isEndOfFile ? 1 : 0;
+        forEachChild(node, countChild, &cw);
+        if (cw.stack.count == 0) break;
+        node = cw.stack.nodes[--cw.stack.count];
+    }
+    free(cw.stack.nodes);
+    return cw.files;
+}
+#endif
+
+// O(prefix length) with per-node counts, otherwise a walk of the subtree
+size_t trieCountPrefix(TrieNode *root, const char *prefix) {
+    TrieNode *node = root;
+    for (int i = 0; prefix[i] != '\0'; i++) {
+        node = findChild(node, (unsigned char)prefix[i]);
+        if (!node) return 0;
+    }
+#ifdef TRIE_COUNTS
+    return node->files;
+#else
+    return countFiles(node);
+#endif
+}
+
+// Print every file below 'root' one at a time through a cursor, straight
+// from its path buffer
+void printFilesWithPrefix(TrieNode *root, const char *prefix, int level) {
+    TrieIter *it = trieIterCreate();
+    if (!it || level < 0 || iterReserve(it, (size_t)level + 1) != 0) {
+        trieIterFree(it);
+        return;
+    }
+    memcpy(it->path, prefix, (size_t)level);
+    iterStart(it, root, (size_t)level);
+    size_t skip = 0;
+    while (iterStep(it, &skip)) {
+        fputs("  ", stdout);
+        fwrite(it->path, 1, it->base + it->depth - 1, stdout);
+        putchar('\n');
+    }
+    trieIterFree(it);
+}
+
+// Visit every stored path in lexicographic order, through a cursor so
+// paths of any length are handed out without recursion
+int trieForEachFile(TrieNode *root, void (*fn)(const char *path, void *ctx), void *ctx) {
+    TrieIter *it = trieIterCreate();
+    if (!it) return -1;
+    iterStart(it, root, 0);
+    size_t skip = 0;
+    while (iterStep(it, &skip)) {
+        it->path[it->base + it->depth - 1] = '\0';   // iterStep() keeps room for it
+        fn(it->path, ctx);
+    }
+    int failed = it->failed;
+    trieIterFree(it);
+    return failed ? -1 : 0;
+}
+
+typedef struct {
+    void (*fn)(TrieNode *child, const char *label, size_t labelLen, void *ctx);
+    void *ctx;
+} EdgeVisit;
+
+static void visitEdge(TrieNode *child, unsigned char c, void *ctx) {
+    EdgeVisit *v = (EdgeVisit*)ctx;
+    char label = (char)c;
+    v->fn(child, &label, 1, v->ctx);
+}
+
+// Every edge of an adaptive node is a single key byte
+void trieForEachChild(TrieNode *node,
+                      void (*fn)(TrieNode *child, const char *label, size_t labelLen, void *ctx),
+                      void *ctx) {
+    EdgeVisit v = { fn, ctx };
+    forEachChild(node, visitEdge, &v);
+}
+
+static void freeChild(TrieNode *child, unsigned char c, void *ctx) {
+    (void)c;
+    if (nodeStackPush((NodeStack*)ctx, child) != 0) freeTrie(child);
+}
+
+// Free the Trie memory; a node is released once its children are queued
+void freeTrie(TrieNode *root) {
+    NodeStack stack = { NULL, 0, 0 };
+    TrieNode *node = root;
+    for (;;) {
+        forEachChild(node, freeChild, &stack);
+        releaseNode(node);
+        if (stack.count == 0) break;
+        node = stack.nodes[--stack.count];
+    }
+    free(stack.nodes);
+}
+
+typedef struct {
+    NodeStack stack;
+    size_t nodes;
+    size_t bytes;
+} StatWalk;
+
+static void statChild(TrieNode *child, unsigned char c, void *ctx) {
+    (void)c;
+    StatWalk *sw = (StatWalk*)ctx;
+    if (nodeStackPush(&sw->stack, child) == 0) return;
+    size_t nodes, bytes;
+    trieStats(child, &nodes, &bytes);
+    sw->nodes += nodes;
+    sw->bytes += bytes;
+}
+
+// Count nodes and the bytes they occupy
+void trieStats(TrieNode *root, size_t *nodeCount, size_t *bytesUsed) {
+    StatWalk sw = { { NULL, 0, 0 }, 0, 0 };
+    TrieNode *node = root;
+    while (node) {
+        sw.nodes++;
+        sw.bytes += nodeSize(node);
+        forEachChild(node, statChild, &sw);
+        node = sw.stack.count ? sw.stack.nodes[--sw.stack.count] : NULL;
+    }
+    free(sw.stack.nodes);
+    if (nodeCount) *nodeCount = sw.nodes;
+    if (bytesUsed) *bytesUsed = sw.bytes;
+}
+
+#endif // TRIE_RADIX
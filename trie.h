@@ -1,18 +1,140 @@
-#ifndef TRIE_H
-#define TRIE_H
-
-#define CHAR_SIZE 128
-
-typedef struct TrieNode {
-    struct TrieNode *children[CHAR_SIZE];
-    int isEndOfFile;
-} TrieNode;
-
-TrieNode* createNode();
-void insertFile(TrieNode *root, const char *path);
-int searchFile(TrieNode *root, const char *path);
-int startsWith(TrieNode *root, const char *prefix);
-void printFilesWithPrefix(TrieNode *root, char *prefix, int level);
-void freeTrie(TrieNode *root);
-
-#endif
+#ifndef TRIE_H
+#define TRIE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+#define CHAR_SIZE 256       // one slot per byte value, so UTF-8 paths index safely
+
+#ifdef TRIE_RADIX
+// Path-compressed (radix / Patricia) node: the edge leading into a node
+// carries a whole string span instead of a single character.
+// Build with -DTRIE_RADIX and trie_radix.c to select this backend.
+typedef struct TrieNode {
+    struct TrieNode *firstChild;   // children sorted by first label byte
+    struct TrieNode *nextSibling;
+    int isEndOfFile;
+#ifdef TRIE_COUNTS
+    unsigned files;                // files stored in this subtree
+#endif
+    int labelLen;
+    char label[];                  // edge label, NUL-terminated
+} TrieNode;
+#else
+// Adaptive node layouts (ART-style): a node starts with a small sorted key
+// array and is replaced by the next larger layout when it fills up.
+enum { TRIE_NODE4, TRIE_NODE16, TRIE_NODE48, TRIE_NODE256 };
+
+// Common header shared by every layout
+typedef struct TrieNode {
+    unsigned char type;      // TRIE_NODE4 .. TRIE_NODE256
+    unsigned short count;    // children in use (a dense node holds up to 256)
+    int isEndOfFile;
+#ifdef TRIE_COUNTS
+    unsigned files;          // files stored in this subtree, this node included
+#endif
+} TrieNode;
+
+// Up to 4 children, keys kept sorted, linear scan
+typedef struct {
+    TrieNode hdr;
+    unsigned char keys[4];
+    TrieNode *children[4];
+} TrieNode4;
+
+// Up to 16 children, keys kept sorted, searched 16-wide with SSE2
+typedef struct {
+    TrieNode hdr;
+    unsigned char keys[16];
+    TrieNode *children[16];
+} TrieNode16;
+
+// Up to 48 children; index[c] holds slot+1 (0 = absent)
+typedef struct {
+    TrieNode hdr;
+    unsigned char index[CHAR_SIZE];
+    TrieNode *children[48];
+} TrieNode48;
+
+// Dense node, direct-indexed by character
+typedef struct {
+    TrieNode hdr;
+    TrieNode *children[CHAR_SIZE];
+} TrieNode256;
+#endif
+
+// createNode() returns NULL and insertFile() -1 if a node cannot be
+// allocated (malloc or arena); a failed insert stores no new file
+TrieNode* createNode();
+int insertFile(TrieNode *root, const char *path);
+// Remove a stored path; returns 1 if it was stored, else 0. Nodes that
+// lead to no other file are released.
+int removeFile(TrieNode *root, const char *path);
+int searchFile(TrieNode *root, const char *path);
+int startsWith(TrieNode *root, const char *prefix);
+// Look up many paths at once. Several descents advance in lockstep and
+// prefetch their next node, so the cache misses of different paths
+// overlap instead of queueing. Bit i of found[] (count bits, whole
+// words) is set when paths[i] is stored; returns how many are.
+size_t searchFileBatch(TrieNode *root, const char *const *paths, size_t count, uint64_t *found);
+// Print every file below 'root', whose own path is prefix[0..level)
+void printFilesWithPrefix(TrieNode *root, const char *prefix, int level);
+void freeTrie(TrieNode *root);
+
+// Incremental inserter for input that arrives in sorted order: each path
+// resumes from the node where it diverges from the previous one instead of
+// descending from the root again. Unsorted input is still inserted correctly.
+typedef struct TrieSortedCursor TrieSortedCursor;
+TrieSortedCursor* trieSortedBegin(TrieNode *root);
+int trieSortedInsert(TrieSortedCursor *cursor, const char *path, size_t len);
+void trieSortedEnd(TrieSortedCursor *cursor);
+
+// Call fn(path, ctx) for every stored file path in lexicographic order
+// Returns 0, or -1 if memory for the path buffer ran out
+int trieForEachFile(TrieNode *root, void (*fn)(const char *path, void *ctx), void *ctx);
+
+// Call fn(child, label, labelLen, ctx) for each child of 'node' in ascending
+// order of the first label byte. The label is the edge leading to the child:
+// one byte in the adaptive layouts, a whole span in the radix backend; it is
+// only valid during the call. Lets serializers walk the structure directly.
+void trieForEachChild(TrieNode *node,
+                      void (*fn)(TrieNode *child, const char *label, size_t labelLen, void *ctx),
+                      void *ctx);
+
+// Resumable listing of the files under a prefix, in lexicographic order.
+// A cursor walks with its own stack and path buffer and never recurses;
+// reset it for the next listing. The buffers start at TRIE_ITER_MAX_PATH
+// bytes and double when a longer path turns up, so listing only allocates
+// for a path longer than any the cursor has seen.
+// Building with -DTRIE_COUNTS keeps a file count in every node, which makes
+// trieCountPrefix() and trieIterSkip() O(prefix length) instead of a walk.
+#define TRIE_ITER_MAX_PATH 4096
+typedef struct TrieIter TrieIter;
+TrieIter* trieIterCreate(void);
+void trieIterFree(TrieIter *it);
+// Position before the first file under 'prefix' ("" lists everything).
+// Returns 1 if anything is stored under the prefix, else 0.
+int trieIterReset(TrieIter *it, TrieNode *root, const char *prefix);
+// Copy up to 'limit' paths into buf as consecutive NUL-terminated strings
+// and return how many were copied. A path that does not fit is kept for
+// the next call, so 0 before the end means buf is too small for it.
+size_t trieIterNext(TrieIter *it, char *buf, size_t bufSize, size_t limit);
+// Move past n files (a page offset); returns how many were skipped
+size_t trieIterSkip(TrieIter *it, size_t n);
+int trieIterDone(TrieIter *it);
+// 1 if the listing stopped early because a longer path could not be
+// buffered (out of memory); cleared by trieIterReset()
+int trieIterFailed(const TrieIter *it);
+
+// Number of files stored under 'prefix'
+size_t trieCountPrefix(TrieNode *root, const char *prefix);
+
+// Allocate nodes from 'arena' instead of malloc (NULL restores malloc).
+// With an arena attached, arenaDestroy() tears the whole trie down at once.
+void trieSetArena(Arena *arena);
+
+// Report the number of nodes and the heap bytes they occupy
+void trieStats(TrieNode *root, size_t *nodeCount, size_t *bytesUsed);
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trie_bulk.h"
+
+// Call fn for every complete line in buf[0..len); returns bytes consumed
+static size_t scanLines(char *buf, size_t len, int atEof,
+                        int (*fn)(char *line, size_t len, void *ctx), void *ctx, int *failed) {
+    size_t pos = 0;
+    while (pos < len) {
+        char *start = buf + pos;
+        char *nl = (char*)memchr(start, '\n', len - pos);
+        if (!nl && !atEof) break;               // partial line: wait for more input
+        size_t lineLen = nl ? (size_t)(nl - start) : len - pos;
+        pos += lineLen + (nl ? 1 : 0);
+
+        if (lineLen > 0 && start[lineLen - 1] == '\r') lineLen--;
+        if (lineLen == 0) continue;
+        start[lineLen] = '\0';                  // terminate in place (over '\n' or '\r')
+
+        if (fn(start, lineLen, ctx) != 0) { *failed = 1; return pos; }
+    }
+    return pos;
+}
+
+// Read a file block by block and hand each line to fn
+int trieBulkForEachLine(const char *filename, int (*fn)(char *line, size_t len, void *ctx),
+                        void *ctx, size_t *bytesRead) {
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) return -1;
+
+    size_t cap = TRIE_BULK_BLOCK;
+    char *buf = (char*)malloc(cap + 1);          // +1: room to terminate a final line
+    int failed = !buf;
+
+    size_t have = 0, total = 0;
+    while (!failed) {
+        // Grow the block if a single line does not fit in it
+        if (have == cap) {
+            char *grown = (char*)realloc(buf, 2 * cap + 1);
+            if (!grown) { failed = 1; break; }
+            buf = grown;
+            cap *= 2;
+        }
+        size_t got = fread(buf + have, 1, cap - have, fp);
+        total += got;
+        have += got;
+        int atEof = got == 0;
+        if (atEof && ferror(fp)) { failed = 1; break; }
+
+        size_t used = scanLines(buf, have, atEof, fn, ctx, &failed);
+        // Carry the unfinished tail to the front of the block
+        memmove(buf, buf + used, have - used);
+        have -= used;
+        if (atEof) break;
+    }
+
+    if (bytesRead) *bytesRead = total;
+    free(buf);
+    fclose(fp);
+    return failed ? -1 : 0;
+}
+
+typedef struct {
+    TrieNode *root;
+    TrieSortedCursor *cursor;
+    TrieLoadStats *stats;
+} LoadCtx;
+
+static int insertLine(char *line, size_t len, void *ctx) {
+    LoadCtx *load = (LoadCtx*)ctx;
+    if (load->cursor) {
+        if (trieSortedInsert(load->cursor, line, len) != 0) return -1;
+    } else if (insertFile(load->root, line) != 0) {
+        return -1;
+    }
+    load->stats->paths++;
+    if (len > load->stats->longestPath) load->stats->longestPath = len;
+    return 0;
+}
+
+// Stream a path list into the trie block by block
+int trieBulkLoad(TrieNode *root, const char *filename, int sortedInput, TrieLoadStats *stats) {
+    TrieLoadStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+
+    TrieSortedCursor *cursor = sortedInput ? trieSortedBegin(root) : NULL;
+    if (sortedInput && !cursor) return -1;
+    LoadCtx load = { root, cursor, stats };
+    int rc = trieBulkForEachLine(filename, insertLine, &load, &stats->bytes);
+    trieSortedEnd(cursor);
+    return rc;
+}
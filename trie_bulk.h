@@ -0,0 +1,30 @@
+#ifndef TRIE_BULK_H
+#define TRIE_BULK_H
+
+#include <stddef.h>
+#include "trie.h"
+
+// Streaming bulk loader for newline-separated path lists.
+// The input is read in large blocks and split in place (no per-line copy,
+// no length limit, spaces kept); '\r' before '\n' and blank lines are
+// ignored. With sortedInput set, paths go through a TrieSortedCursor so
+// each one resumes at the point it diverges from the previous path.
+
+#define TRIE_BULK_BLOCK (1 << 20)
+
+typedef struct {
+    size_t paths;        // paths inserted
+    size_t bytes;        // input bytes consumed
+    size_t longestPath;
+} TrieLoadStats;
+
+// Returns 0 on success, -1 if the file cannot be read or memory runs out
+int trieBulkLoad(TrieNode *root, const char *filename, int sortedInput, TrieLoadStats *stats);
+
+// The same block reader for other consumers: fn(line, len, ctx) sees each
+// NUL-terminated line in place (valid only during the call); a non-zero
+// return stops the scan. *bytesRead (optional) gets the bytes read.
+int trieBulkForEachLine(const char *filename, int (*fn)(char *line, size_t len, void *ctx),
+                        void *ctx, size_t *bytesRead);
+
+#endif
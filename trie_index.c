@@ -0,0 +1,333 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trie_index.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+struct TrieIndex {
+    const unsigned char *base;     // start of the mapping
+    size_t size;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+// ---------- Writer ----------
+
+// Growable output image; everything is addressed by offset, not pointer
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t cap;
+    int failed;
+} ImageBuf;
+
+static size_t pad4(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+// Reserve 'len' zeroed bytes at the (4-byte aligned) end; returns the offset
+static size_t imageReserve(ImageBuf *img, size_t len) {
+    size_t off = pad4(img->size);
+    size_t need = off + len;
+    if (need > UINT32_MAX) { img->failed = 1; return 0; }
+    if (need > img->cap) {
+        size_t cap = img->cap ? img->cap : 4096;
+        while (cap < need) cap *= 2;
+        unsigned char *grown = (unsigned char*)realloc(img->data, cap);
+        if (!grown) { img->failed = 1; return 0; }
+        img->data = grown;
+        img->cap = cap;
+    }
+    memset(img->data + img->size, 0, need - img->size);
+    img->size = need;
+    return off;
+}
+
+// Writer state for one serialization pass
+typedef struct {
+    ImageBuf img;
+    uint32_t nodeCount;
+    uint32_t fileCount;
+} IndexWriter;
+
+static void countEdge(TrieNode *child, const char *label, size_t labelLen, void *ctx) {
+    (void)child; (void)label; (void)labelLen;
+    (*(uint32_t*)ctx)++;
+}
+
+// The single child of a node and its label
+typedef struct {
+    TrieNode *child;
+    unsigned char *dst;     // label destination, NULL to only measure
+    size_t len;
+} ChainStep;
+
+static void chainEdge(TrieNode *child, const char *label, size_t labelLen, void *ctx) {
+    ChainStep *step = (ChainStep*)ctx;
+    if (step->dst) memcpy(step->dst, label, labelLen);
+    step->child = child;
+    step->len = labelLen;
+}
+
+// An edge runs on through nodes that store no file and have one child, so
+// it becomes a single radix label. Sets *len to the label length, copies the
+// label to 'dst' unless it is NULL, and returns the node the edge ends at
+static TrieNode* followEdge(TrieNode *child, const char *label, size_t labelLen,
+                            unsigned char *dst, size_t *len) {
+    if (dst) memcpy(dst, label, labelLen);
+    *len = labelLen;
+    while (!child->isEndOfFile) {
+        uint32_t count = 0;
+        trieForEachChild(child, countEdge, &count);
+        if (count != 1) break;
+        ChainStep step = { NULL, dst ? dst + *len : NULL, 0 };
+        trieForEachChild(child, chainEdge, &step);
+        *len += step.len;
+        child = step.child;
+    }
+    return child;
+}
+
+static uint32_t writeNode(IndexWriter *w, TrieNode *node);
+
+// Edge k of the node at 'nodeOff'
+typedef struct {
+    IndexWriter *w;
+    size_t nodeOff;
+    size_t keysBytes;
+    uint32_t k;
+} EdgeWrite;
+
+static void writeEdge(TrieNode *child, const char *label, size_t labelLen, void *ctx) {
+    EdgeWrite *e = (EdgeWrite*)ctx;
+    ImageBuf *img = &e->w->img;
+    if (img->failed) return;
+
+    size_t len;
+    followEdge(child, label, labelLen, NULL, &len);
+    size_t labelOff = imageReserve(img, len);
+    if (img->failed) return;
+    TrieNode *end = followEdge(child, label, labelLen, img->data + labelOff, &len);
+    uint32_t childOff = writeNode(e->w, end);
+    if (img->failed) return;
+
+    // Re-derive pointers: the image may have moved while recursing
+    unsigned char *keys = img->data + e->nodeOff + sizeof(TrieIndexNode);
+    TrieIndexEdge *edge = (TrieIndexEdge*)(keys + e->keysBytes) + e->k;
+    keys[e->k++] = (unsigned char)label[0];
+    edge->labelOffset = (uint32_t)labelOff;
+    edge->labelLen = (uint32_t)len;
+    edge->childOffset = childOff;
+}
+
+// Emit the radix node for 'node' and everything below it; children always
+// land after their parent. Returns the node's offset
+static uint32_t writeNode(IndexWriter *w, TrieNode *node) {
+    uint32_t childCount = 0;
+    trieForEachChild(node, countEdge, &childCount);
+
+    size_t keysBytes = pad4(childCount);
+    size_t nodeOff = imageReserve(&w->img, sizeof(TrieIndexNode) + keysBytes +
+                                  childCount * sizeof(TrieIndexEdge));
+    if (w->img.failed) return 0;
+    TrieIndexNode *out = (TrieIndexNode*)(w->img.data + nodeOff);
+    out->childCount = childCount;
+    out->isEndOfFile = node->isEndOfFile ? 1 : 0;
+    w->nodeCount++;
+    w->fileCount += out->isEndOfFile;
+
+    EdgeWrite e = { w, nodeOff, keysBytes, 0 };
+    trieForEachChild(node, writeEdge, &e);
+    return (uint32_t)nodeOff;
+}
+
+// Serialize the trie to a relocatable, offset-based index file, walking
+// the trie's own nodes (single-child chains collapse into one edge)
+int trieIndexWrite(TrieNode *root, const char *path) {
+    IndexWriter w = { { NULL, 0, 0, 0 }, 0, 0 };
+    int rc = -1;
+
+    imageReserve(&w.img, sizeof(TrieIndexHeader));
+    uint32_t rootOff = writeNode(&w, root);
+    if (!w.img.failed) {
+        TrieIndexHeader *hdr = (TrieIndexHeader*)w.img.data;
+        memcpy(hdr->magic, TRIE_INDEX_MAGIC, 4);
+        hdr->version = TRIE_INDEX_VERSION;
+        hdr->fileSize = (uint32_t)w.img.size;
+        hdr->nodeCount = w.nodeCount;
+        hdr->fileCount = w.fileCount;
+        hdr->rootOffset = rootOff;
+
+        FILE *fp = fopen(path, "wb");
+        if (fp) {
+            if (fwrite(w.img.data, 1, w.img.size, fp) == w.img.size) rc = 0;
+            if (fclose(fp) != 0) rc = -1;
+        }
+    }
+
+    free(w.img.data);
+    return rc;
+}
+
+// ---------- Reader ----------
+
+// Check every node reachable from the root once, so lookups can follow
+// offsets without bounds checks: nodes must be aligned and inside the file,
+// edge labels inside the file, non-empty, NUL-free and starting with their
+// key byte. The writer puts children after their parent, so offsets must
+// increase along every edge (no cycles), and the node and file counts must
+// match the header (no shared subtrees)
+static int validateIndex(const TrieIndex *index) {
+    const TrieIndexHeader *hdr = (const TrieIndexHeader*)index->base;
+    const unsigned char *base = index->base;
+    size_t size = index->size;
+    if (hdr->nodeCount == 0 || hdr->nodeCount > size / sizeof(TrieIndexNode)) return -1;
+
+    uint32_t *stack = (uint32_t*)malloc(hdr->nodeCount * sizeof(uint32_t));
+    if (!stack) return -1;
+    size_t depth = 0, visits = 1, files = 0;
+    int ok = 1;
+    stack[depth++] = hdr->rootOffset;
+    while (ok && depth > 0) {
+        size_t off = stack[--depth];
+        if (off % 4 != 0 || off < sizeof(TrieIndexHeader) || off > size ||
+            sizeof(TrieIndexNode) > size - off) { ok = 0; break; }
+        const TrieIndexNode *node = (const TrieIndexNode*)(base + off);
+        if (node->childCount > 256 || node->isEndOfFile > 1 ||
+            pad4(node->childCount) + node->childCount * sizeof(TrieIndexEdge) >
+                size - off - sizeof(TrieIndexNode)) { ok = 0; break; }
+        files += node->isEndOfFile;
+
+        const unsigned char *keys = (const unsigned char*)(node + 1);
+        const TrieIndexEdge *edges = (const TrieIndexEdge*)(keys + pad4(node->childCount));
+        for (uint32_t k = 0; k < node->childCount && ok; k++) {
+            const TrieIndexEdge *edge = &edges[k];
+            if (edge->labelLen == 0 || edge->labelOffset > size ||
+                edge->labelLen > size - edge->labelOffset ||
+                base[edge->labelOffset] != keys[k] ||
+                memchr(base + edge->labelOffset, '\0', edge->labelLen) != NULL ||
+                edge->childOffset <= off || visits == hdr->nodeCount) {
+                ok = 0;
+            } else {
+                visits++;
+                stack[depth++] = edge->childOffset;
+            }
+        }
+    }
+    free(stack);
+    return ok && visits == hdr->nodeCount && files == hdr->fileCount ? 0 : -1;
+}
+
+// Map 'path' read-only and validate it
+TrieIndex* trieIndexOpen(const char *path) {
+    TrieIndex *index = (TrieIndex*)calloc(1, sizeof(TrieIndex));
+    if (!index) return NULL;
+
+#if defined(_WIN32) || defined(_WIN64)
+    index->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (index->file == INVALID_HANDLE_VALUE) { free(index); return NULL; }
+    LARGE_INTEGER size;
+    GetFileSizeEx(index->file, &size);
+    index->size = (size_t)size.QuadPart;
+    index->mapping = CreateFileMappingA(index->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (index->mapping)
+        index->base = (const unsigned char*)MapViewOfFile(index->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!index->base) { trieIndexClose(index); return NULL; }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { free(index); return NULL; }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        index->size = (size_t)st.st_size;
+        void *map = mmap(NULL, index->size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) index->base = (const unsigned char*)map;
+    }
+    close(fd);   // the mapping stays valid after the descriptor is closed
+    if (!index->base) { free(index); return NULL; }
+#endif
+
+    const TrieIndexHeader *hdr = (const TrieIndexHeader*)index->base;
+    if (index->size < sizeof(TrieIndexHeader) ||
+        memcmp(hdr->magic, TRIE_INDEX_MAGIC, 4) != 0 ||
+        hdr->version != TRIE_INDEX_VERSION || hdr->fileSize != index->size ||
+        validateIndex(index) != 0) {
+        trieIndexClose(index);
+        return NULL;
+    }
+    return index;
+}
+
+void trieIndexClose(TrieIndex *index) {
+    if (!index) return;
+#if defined(_WIN32) || defined(_WIN64)
+    if (index->base) UnmapViewOfFile(index->base);
+    if (index->mapping) CloseHandle(index->mapping);
+    if (index->file != INVALID_HANDLE_VALUE) CloseHandle(index->file);
+#else
+    if (index->base) munmap((void*)index->base, index->size);
+#endif
+    free(index);
+}
+
+// Follow edges for as much of 'p' as possible. Returns the node reached
+// when all of 'p' is consumed, or NULL; *inLabel is set when 'p' ends
+// part-way along an edge (enough for prefix queries)
+static const TrieIndexNode* descend(const TrieIndex *index, const char *p, int *inLabel) {
+    const unsigned char *base = index->base;
+    const TrieIndexNode *node =
+        (const TrieIndexNode*)(base + ((const TrieIndexHeader*)base)->rootOffset);
+    *inLabel = 0;
+    while (*p != '\0') {
+        const unsigned char *keys = (const unsigned char*)(node + 1);
+        const unsigned char *hit = (const unsigned char*)memchr(keys, (unsigned char)*p,
+                                                                node->childCount);
+        if (!hit) return NULL;
+        const TrieIndexEdge *edge =
+            (const TrieIndexEdge*)(keys + pad4(node->childCount)) + (hit - keys);
+        const char *label = (const char*)base + edge->labelOffset;
+        uint32_t k = 0;
+        while (k < edge->labelLen && p[k] == label[k]) k++;
+        if (k < edge->labelLen) {
+            if (p[k] != '\0') return NULL;
+            *inLabel = 1;
+            return node;
+        }
+        p += k;
+        node = (const TrieIndexNode*)(base + edge->childOffset);
+    }
+    return node;
+}
+
+int trieIndexSearch(const TrieIndex *index, const char *path) {
+    int inLabel;
+    const TrieIndexNode *node = descend(index, path, &inLabel);
+    return node && !inLabel && node->isEndOfFile;
+}
+
+int trieIndexStartsWith(const TrieIndex *index, const char *prefix) {
+    int inLabel;
+    return descend(index, prefix, &inLabel) != NULL;
+}
+
+size_t trieIndexFileCount(const TrieIndex *index) {
+    return ((const TrieIndexHeader*)index->base)->fileCount;
+}
+
+size_t trieIndexBytes(const TrieIndex *index) {
+    return index->size;
+}
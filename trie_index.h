@@ -0,0 +1,56 @@
+#ifndef TRIE_INDEX_H
+#define TRIE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "trie.h"
+
+// Read-only, memory-mapped on-disk path index.
+// trieIndexWrite() serializes a trie as a compressed radix layout where
+// every reference is a 32-bit offset from the start of the file, so the
+// file is position independent: trieIndexOpen() maps it read-only and
+// lookups run directly against the mapped pages (shared between processes
+// through the page cache) without rebuilding anything.
+
+#define TRIE_INDEX_MAGIC "TRIX"
+#define TRIE_INDEX_VERSION 1
+
+// File header (all integers in host byte order)
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t fileSize;
+    uint32_t nodeCount;
+    uint32_t fileCount;
+    uint32_t rootOffset;
+} TrieIndexHeader;
+
+// Node: header, then childCount first-label bytes (padded to 4), then
+// childCount edges in the same order (sorted by first byte)
+typedef struct {
+    uint32_t childCount;
+    uint32_t isEndOfFile;
+} TrieIndexNode;
+
+typedef struct {
+    uint32_t labelOffset;    // edge label bytes
+    uint32_t labelLen;
+    uint32_t childOffset;    // TrieIndexNode the edge leads to
+} TrieIndexEdge;
+
+typedef struct TrieIndex TrieIndex;
+
+// Serialize every path stored in 'root' to 'path'; returns 0 on success
+int trieIndexWrite(TrieNode *root, const char *path);
+
+// Map an index file read-only; returns NULL if missing or malformed. Every
+// node and edge is bounds-checked here, once, so lookups trust the offsets
+TrieIndex* trieIndexOpen(const char *path);
+void trieIndexClose(TrieIndex *index);
+
+int trieIndexSearch(const TrieIndex *index, const char *path);
+int trieIndexStartsWith(const TrieIndex *index, const char *prefix);
+size_t trieIndexFileCount(const TrieIndex *index);
+size_t trieIndexBytes(const TrieIndex *index);
+
+#endif
@@ -0,0 +1,633 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trie.h"
+
+#ifdef TRIE_RADIX
+
+static Arena *nodeArena = NULL;   // optional node allocator
+
+#ifdef TRIE_COUNTS
+#define COUNT_FILE(node) ((node)->files++)
+#else
+#define COUNT_FILE(node) ((void)0)
+#endif
+
+// Route node allocation through an arena (NULL = malloc/free)
+void trieSetArena(Arena *arena) {
+    nodeArena = arena;
+}
+
+// Release one node to the arena or the heap
+static void releaseNode(TrieNode *node) {
+    if (nodeArena)
+        arenaRelease(nodeArena, node, sizeof(TrieNode) + (size_t)node->labelLen + 1);
+    else
+        free(node);
+}
+
+// Allocate a node with room for a len-byte label, filled in by the caller
+// (NULL if memory ran out)
+static TrieNode* allocEdge(int len) {
+    size_t size = sizeof(TrieNode) + (size_t)len + 1;
+    TrieNode *node = (TrieNode*)(nodeArena ? arenaAlloc(nodeArena, size) : malloc(size));
+    if (!node) return NULL;
+    node->firstChild = NULL;
+    node->nextSibling = NULL;
+    node->isEndOfFile = 0;
+#ifdef TRIE_COUNTS
+    node->files = 0;
+#endif
+    node->labelLen = len;
+    node->label[len] = '\0';
+    return node;
+}
+
+// Allocate a node whose incoming edge is labelled with label[0..len)
+// (NULL if memory ran out)
+static TrieNode* createEdge(const char *label, int len) {
+    TrieNode *node = allocEdge(len);
+    if (node) memcpy(node->label, label, (size_t)len);
+    return node;
+}
+
+// Create a new (root) node with an empty label
+TrieNode* createNode() {
+    return createEdge("", 0);
+}
+
+// Find the link slot where a child starting with 'c' is, or would be, stored
+static TrieNode** findLink(TrieNode *node, char c) {
+    TrieNode **link = &node->firstChild;
+    while (*link && (unsigned char)(*link)->label[0] < (unsigned char)c)
+        link = &(*link)->nextSibling;
+    return link;
+}
+
+// Length of the common prefix of a label and the remaining path
+static int commonPrefix(const TrieNode *node, const char *p) {
+    int k = 0;
+    while (k < node->labelLen && p[k] == node->label[k])
+        k++;
+    return k;
+}
+
+#ifdef TRIE_COUNTS
+// Take back the counts insertFile() added on the way down to 'last'
+// (a path that was already stored, or an insert that ran out of memory)
+static void uncountPath(TrieNode *root, const char *path, const TrieNode *last) {
+    TrieNode *curr = root;
+    const char *p = path;
+    curr->files--;
+    while (curr != last) {
+        curr = *findLink(curr, *p);
+        p += curr->labelLen;
+        curr->files--;
+    }
+}
+#define UNCOUNT_PATH(root, path, last) uncountPath(root, path, last)
+#else
+#define UNCOUNT_PATH(root, path, last) ((void)0)
+#endif
+
+// Insert a file path into the Trie, splitting edges where paths diverge
+int insertFile(TrieNode *root, const char *path) {
+    TrieNode *curr = root;
+    const char *p = path;
+    while (*p != '\0') {
+        COUNT_FILE(curr);
+        TrieNode **link = findLink(curr, *p);
+        TrieNode *child = *link;
+        if (!child || child->label[0] != *p) {
+            // No edge shares the next character: hang the rest of the path here
+            TrieNode *leaf = createEdge(p, (int)strlen(p));
+            if (!leaf) {
+                UNCOUNT_PATH(root, path, curr);
+                return -1;
+            }
+            leaf->isEndOfFile = 1;
+            COUNT_FILE(leaf);
+            leaf->nextSibling = child;
+            *link = leaf;
+            return 0;
+        }
+        int k = commonPrefix(child, p);
+        if (k < child->labelLen) {
+            // Split the edge: 'mid' keeps the shared span, 'tail' the rest
+            TrieNode *mid = createEdge(child->label, k);
+            TrieNode *tail = mid ? createEdge(child->label + k, child->labelLen - k) : NULL;
+            if (!tail) {
+                if (mid) releaseNode(mid);
+                UNCOUNT_PATH(root, path, curr);
+                return -1;
+            }
+            tail->firstChild = child->firstChild;
+            tail->isEndOfFile = child->isEndOfFile;
+#ifdef TRIE_COUNTS
+            tail->files = mid->files = child->files;
+#endif
+            mid->firstChild = tail;
+            mid->nextSibling = child->nextSibling;
+            *link = mid;
+            releaseNode(child);
+            child = mid;
+        }
+        p += k;
+        curr = child;
+    }
+    COUNT_FILE(curr);
+    if (curr->isEndOfFile) {
+        UNCOUNT_PATH(root, path, curr);
+        return 0;
+    }
+    curr->isEndOfFile = 1;
+    return 0;
+}
+
+// Replace a non-file node that has a single child by one edge carrying
+// both labels, so the trie stays path-compressed. If memory runs out the
+// two edges are simply left as they are.
+static void mergeWithChild(TrieNode **link) {
+    TrieNode *node = *link, *child = node->firstChild;
+    TrieNode *merged = allocEdge(node->labelLen + child->labelLen);
+    if (!merged) return;
+    memcpy(merged->label, node->label, (size_t)node->labelLen);
+    memcpy(merged->label + node->labelLen, child->label, (size_t)child->labelLen);
+    merged->firstChild = child->firstChild;
+    merged->nextSibling = node->nextSibling;
+    merged->isEndOfFile = child->isEndOfFile;
+#ifdef TRIE_COUNTS
+    merged->files = child->files;
+#endif
+    *link = merged;
+    releaseNode(node);
+    releaseNode(child);
+}
+
+// Remove a file path; returns 1 if it was stored, else 0. Its edge is
+// dropped when nothing hangs below it, and an edge left with one child
+// is merged with it.
+int removeFile(TrieNode *root, const char *path) {
+    TrieNode *curr = root;
+    TrieNode **link = NULL, **parentLink = NULL;   // slots holding curr and its parent
+    const char *p = path;
+    while (*p != '\0') {
+        TrieNode **next = findLink(curr, *p);
+        TrieNode *child = *next;
+        if (!child || child->label[0] != *p ||
+            strncmp(child->label, p, (size_t)child->labelLen) != 0)
+            return 0;
+        parentLink = link;
+        link = next;
+        p += child->labelLen;
+        curr = child;
+    }
+    if (!curr->isEndOfFile)
+        return 0;
+    UNCOUNT_PATH(root, path, curr);
+    curr->isEndOfFile = 0;
+    if (!link)
+        return 1;   // the root keeps its (empty) edge
+
+    if (curr->firstChild) {
+        if (!curr->firstChild->nextSibling) mergeWithChild(link);
+        return 1;
+    }
+    *link = curr->nextSibling;
+    releaseNode(curr);
+    // The parent may now be a plain pass-through edge
+    if (parentLink) {
+        TrieNode *parent = *parentLink;
+        if (!parent->isEndOfFile && parent->firstChild && !parent->firstChild->nextSibling)
+            mergeWithChild(parentLink);
+    }
+    return 1;
+}
+
+// The radix backend splits and replaces edges on insert, so cached
+// positions would not survive; sorted input simply uses insertFile().
+struct TrieSortedCursor {
+    TrieNode *root;
+    char *buf;
+    size_t cap;
+};
+
+TrieSortedCursor* trieSortedBegin(TrieNode *root) {
+    TrieSortedCursor *cur = (TrieSortedCursor*)calloc(1, sizeof(TrieSortedCursor));
+    if (cur) cur->root = root;
+    return cur;
+}
+
+int trieSortedInsert(TrieSortedCursor *cur, const char *path, size_t len) {
+    if (len + 1 > cur->cap) {
+        char *buf = (char*)realloc(cur->buf, len + 1);
+        if (!buf) return -1;
+        cur->buf = buf;
+        cur->cap = len + 1;
+    }
+    memcpy(cur->buf, path, len);
+    cur->buf[len] = '\0';
+    return insertFile(cur->root, cur->buf);
+}
+
+void trieSortedEnd(TrieSortedCursor *cur) {
+    if (!cur) return;
+    free(cur->buf);
+    free(cur);
+}
+
+// Search for a full file path
+int searchFile(TrieNode *root, const char *path) {
+    TrieNode *curr = root;
+    const char *p = path;
+    while (*p != '\0') {
+        TrieNode *child = *findLink(curr, *p);
+        if (!child || child->label[0] != *p)
+            return 0;
+        if (strncmp(child->label, p, (size_t)child->labelLen) != 0)
+            return 0;
+        p += child->labelLen;
+        curr = child;
+    }
+    return curr->isEndOfFile;
+}
+
+#define BATCH_LANES 16   // lookups in flight at once
+
+typedef struct {
+    TrieNode *node;
+    const char *p;       // rest of the path below node
+    size_t query;
+} BatchLane;
+
+size_t searchFileBatch(TrieNode *root, const char *const *paths, size_t count, uint64_t *found) {
+    BatchLane lanes[BATCH_LANES];
+    size_t next = 0, hits = 0;
+    int active = 0;
+    memset(found, 0, (count + 63) / 64 * sizeof(uint64_t));
+    for (; active < BATCH_LANES && next < count; active++, next++)
+        lanes[active] = (BatchLane){ root, paths[next], next };
+
+    // Round-robin: each lane takes one step, then the next lane runs while
+    // the node it just prefetched is on its way
+    while (active > 0) {
+        for (int l = 0; l < active; ) {
+            BatchLane *lane = &lanes[l];
+            int hit;
+            if (*lane->p != '\0') {
+                TrieNode *child = *findLink(lane->node, *lane->p);
+                if (child && child->label[0] == *lane->p &&
+                    strncmp(child->label, lane->p, (size_t)child->labelLen) == 0) {
+                    if (child->firstChild) __builtin_prefetch(child->firstChild);
+                    lane->node = child;
+                    lane->p += child->labelLen;
+                    l++;
+                    continue;
+                }
+                hit = 0;
+            } else {
+                hit = lane->node->isEndOfFile;
+            }
+            if (hit) {
+                found[lane->query / 64] |= 1ull << (lane->query % 64);
+                hits++;
+            }
+            if (next < count) {
+                *lane = (BatchLane){ root, paths[next], next };
+                next++;
+                l++;
+            } else {
+                *lane = lanes[--active];   // takes its step at this index
+            }
+        }
+    }
+    return hits;
+}
+
+// Check if any file starts with the given prefix (may end inside an edge)
+int startsWith(TrieNode *root, const char *prefix) {
+    TrieNode *curr = root;
+    const char *p = prefix;
+    while (*p != '\0') {
+        TrieNode *child = *findLink(curr, *p);
+        if (!child || child->label[0] != *p)
+            return 0;
+        int k = commonPrefix(child, p);
+        if (p[k] == '\0')
+            return 1;
+        if (k < child->labelLen)
+            return 0;
+        p += k;
+        curr = child;
+    }
+    return 1;
+}
+
+typedef struct {
+    TrieNode *node;
+    TrieNode *next;      // next child to visit
+    size_t len;          // path length including this node's label
+    int visited;         // the node itself has been considered
+} IterFrame;
+
+// Each frame adds one edge label to path, so depth never exceeds its length
+struct TrieIter {
+    char *path;
+    IterFrame *stack;
+    size_t cap;          // bytes of path and frames of stack
+    size_t depth;        // frames in use
+    int pending;         // path of the top frame is a match not handed out yet
+    int failed;          // a longer path could not be buffered; listing stopped
+};
+
+TrieIter* trieIterCreate(void) {
+    TrieIter *it = (TrieIter*)calloc(1, sizeof(TrieIter));
+    if (!it) return NULL;
+    it->cap = TRIE_ITER_MAX_PATH;
+    it->path = (char*)malloc(it->cap);
+    it->stack = (IterFrame*)malloc(it->cap * sizeof(IterFrame));
+    if (!it->path || !it->stack) {
+        trieIterFree(it);
+        return NULL;
+    }
+    return it;
+}
+
+void trieIterFree(TrieIter *it) {
+    if (!it) return;
+    free(it->path);
+    free(it->stack);
+    free(it);
+}
+
+// Make path and stack hold at least 'need' entries
+static int iterReserve(TrieIter *it, size_t need) {
+    if (need <= it->cap) return 0;
+    size_t cap = it->cap;
+    while (cap < need) cap *= 2;
+    char *path = (char*)realloc(it->path, cap);
+    if (!path) return -1;
+    it->path = path;
+    IterFrame *stack = (IterFrame*)realloc(it->stack, cap * sizeof(IterFrame));
+    if (!stack) return -1;
+    it->stack = stack;
+    it->cap = cap;
+    return 0;
+}
+
+int trieIterFailed(const TrieIter *it) {
+    return it->failed;
+}
+
+// Push 'node', whose label follows path[0..len). Returns 0, ending the
+// listing, if the longer path cannot be buffered.
+static int iterPush(TrieIter *it, TrieNode *node, size_t len) {
+    if (iterReserve(it, len + (size_t)node->labelLen + 1) != 0) {
+        it->failed = 1;
+        it->depth = 0;
+        return 0;
+    }
+    memcpy(it->path + len, node->label, (size_t)node->labelLen);
+    IterFrame *f = &it->stack[it->depth++];
+    f->node = node;
+    f->next = node->firstChild;
+    f->len = len + (size_t)node->labelLen;
+    f->visited = 0;
+    return 1;
+}
+
+// Advance to the next match, passing over *skip matches first. Subtrees
+// that hold no more files than are left to skip are never entered when
+// nodes carry counts. Returns 1 with the match in path, or 0 at the end.
+static int iterStep(TrieIter *it, size_t *skip) {
+    while (it->depth > 0) {
+        IterFrame *f = &it->stack[it->depth - 1];
+        if (!f->visited) {
+            f->visited = 1;
+            if (f->node->isEndOfFile) {
+                if (*skip == 0) return 1;
+                (*skip)--;
+            }
+            continue;
+        }
+        TrieNode *child = f->next;
+        if (!child) {
+            it->depth--;
+            continue;
+        }
+        f->next = child->nextSibling;
+#ifdef TRIE_COUNTS
+        if (child->files <= *skip) {
+            *skip -= child->files;
+            continue;
+        }
+#endif
+        iterPush(it, child, f->len);
+    }
+    return 0;
+}
+
+// The listing starts at the node whose edge the prefix ends on (possibly
+// part way along its label), so its full path is the prefix extended
+int trieIterReset(TrieIter *it, TrieNode *root, const char *prefix) {
+    TrieNode *node = root;
+    const char *p = prefix;
+    size_t before = 0;       // prefix bytes above 'node'
+    it->depth = 0;
+    it->pending = 0;
+    it->failed = 0;
+    while (*p != '\0') {
+        TrieNode *child = *findLink(node, *p);
+        if (!child || child->label[0] != *p)
+            return 0;
+        int k = commonPrefix(child, p);
+        if (p[k] != '\0' && k < child->labelLen)
+            return 0;
+        before = (size_t)(p - prefix);
+        node = child;
+        p += k;
+    }
+    if (iterReserve(it, before + 1) != 0) {
+        it->failed = 1;
+        return 0;
+    }
+    memcpy(it->path, prefix, before);
+    return iterPush(it, node, before);
+}
+
+size_t trieIterNext(TrieIter *it, char *buf, size_t bufSize, size_t limit) {
+    size_t n = 0, used = 0, skip = 0;
+    while (n < limit) {
+        if (!it->pending && !(it->pending = iterStep(it, &skip))) break;
+        size_t len = it->stack[it->depth - 1].len;
+        if (used + len + 1 > bufSize) break;
+        memcpy(buf + used, it->path, len);
+        buf[used + len] = '\0';
+        used += len + 1;
+        it->pending = 0;
+        n++;
+    }
+    return n;
+}
+
+size_t trieIterSkip(TrieIter *it, size_t n) {
+    size_t skip = n;
+    if (it->pending && skip > 0) {
+        it->pending = 0;
+        skip--;
+    }
+    if (skip > 0) it->pending = iterStep(it, &skip);
+    return n - skip;
+}
+
+int trieIterDone(TrieIter *it) {
+    size_t skip = 0;
+    if (!it->pending) it->pending = iterStep(it, &skip);
+    return !it->pending;
+}
+
+// Nodes still to visit in a whole-subtree walk. A chain of nested files
+// makes the trie as deep as the longest path, so walks keep their pending
+// nodes here on the heap, not on the call stack.
+typedef struct {
+    const TrieNode **nodes;
+    size_t count;
+    size_t cap;
+} NodeStack;
+
+// Returns -1 if the stack cannot grow; callers then handle that node by
+// recursing, so a walk never skips one
+static int nodeStackPush(NodeStack *s, const TrieNode *node) {
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 64;
+        const TrieNode **grown = (const TrieNode**)realloc(s->nodes, cap * sizeof(TrieNode*));
+        if (!grown) return -1;
+        s->nodes = grown;
+        s->cap = cap;
+    }
+    s->nodes[s->count++] = node;
+    return 0;
+}
+
+#ifndef TRIE_COUNTS
+static size_t countFiles(const TrieNode *node) {
+    NodeStack stack = { NULL, 0, 0 };
+    size_t files = 0;
+    while (node) {
+        files += node->isEndOfFile ? 1 : 0;
+        for (const TrieNode *c = node->firstChild; c; c = c->nextSibling)
+            if (nodeStackPush(&stack, c) != 0) files += countFiles(c);
+        node = stack.count ? stack.nodes[--stack.count] : NULL;
+    }
+    free(stack.nodes);
+    return files;
+}
+#endif
+
+// O(prefix length) with per-node counts, otherwise a walk of the subtree
+size_t trieCountPrefix(TrieNode *root, const char *prefix) {
+    TrieNode *node = root;
+    const char *p = prefix;
+    while (*p != '\0') {
+        TrieNode *child = *findLink(node, *p);
+        if (!child || child->label[0] != *p)
+            return 0;
+        int k = commonPrefix(child, p);
+        if (p[k] != '\0' && k < child->labelLen)
+            return 0;
+        node = child;
+        p += k;
+    }
+#ifdef TRIE_COUNTS
+    return node->files;
+#else
+    return countFiles(node);
+#endif
+}
+
+// Print every file below 'root' one at a time through a cursor, straight
+// from its path buffer; the root's own label follows prefix[0..level)
+void printFilesWithPrefix(TrieNode *root, const char *prefix, int level) {
+    TrieIter *it = trieIterCreate();
+    if (!it || level < 0 || iterReserve(it, (size_t)level + 1) != 0) {
+        trieIterFree(it);
+        return;
+    }
+    memcpy(it->path, prefix, (size_t)level);
+    size_t skip = 0;
+    if (iterPush(it, root, (size_t)level))
+        while (iterStep(it, &skip)) {
+            fputs("  ", stdout);
+            fwrite(it->path, 1, it->stack[it->depth - 1].len, stdout);
+            putchar('\n');
+        }
+    trieIterFree(it);
+}
+
+// Visit every stored path in lexicographic order, through a cursor so
+// paths of any length are handed out without recursion
+int trieForEachFile(TrieNode *root, void (*fn)(const char *path, void *ctx), void *ctx) {
+    TrieIter *it = trieIterCreate();
+    if (!it) return -1;
+    size_t skip = 0;
+    if (iterPush(it, root, 0))
+        while (iterStep(it, &skip)) {
+            it->path[it->stack[it->depth - 1].len] = '\0';   // iterPush() keeps room for it
+            fn(it->path, ctx);
+        }
+    int failed = it->failed;
+    trieIterFree(it);
+    return failed ? -1 : 0;
+}
+
+// Each child carries the label of the edge leading to it
+void trieForEachChild(TrieNode *node,
+                      void (*fn)(TrieNode *child, const char *label, size_t labelLen, void *ctx),
+                      void *ctx) {
+    for (TrieNode *c = node->firstChild; c; c = c->nextSibling)
+        fn(c, c->label, (size_t)c->labelLen, ctx);
+}
+
+// Free the Trie memory
+void freeTrie(TrieNode *root) {
+    // The nodes still to free form one list through nextSibling: each
+    // node's children are spliced in at the front before it is released,
+    // so no stack is needed however deep the trie is
+    TrieNode *pending = root;
+    root->nextSibling = NULL;
+    while (pending) {
+        TrieNode *node = pending;
+        pending = node->nextSibling;
+        if (node->firstChild) {
+            TrieNode *last = node->firstChild;
+            while (last->nextSibling) last = last->nextSibling;
+            last->nextSibling = pending;
+            pending = node->firstChild;
+        }
+        releaseNode(node);
+    }
+}
+
+// Count nodes and the bytes they occupy, including inline edge labels
+void trieStats(TrieNode *root, size_t *nodeCount, size_t *bytesUsed) {
+    NodeStack stack = { NULL, 0, 0 };
+    size_t nodes = 0, bytes = 0;
+    const TrieNode *node = root;
+    while (node) {
+        nodes++;
+        bytes += sizeof(TrieNode) + (size_t)node->labelLen + 1;
+        for (TrieNode *c = node->firstChild; c; c = c->nextSibling) {
+            if (nodeStackPush(&stack, c) == 0) continue;
+            size_t n, b;
+            trieStats(c, &n, &b);
+            nodes += n;
+            bytes += b;
+        }
+        node = stack.count ? stack.nodes[--stack.count] : NULL;
+    }
+    free(stack.nodes);
+    if (nodeCount) *nodeCount = nodes;
+    if (bytesUsed) *bytesUsed = bytes;
+}
+
+#endif // TRIE_RADIX
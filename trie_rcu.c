@@ -0,0 +1,593 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "trie_rcu.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define RCU_FANOUT 256          // any byte may appear in a path
+#define RCU_RECLAIM_BATCH 64    // retired nodes that trigger a reclaim pass
+
+// Same adaptive layouts as trie.c, with atomic child links. Node4/16 are
+// immutable once published (a writer swaps in a changed copy); Node48
+// appends children in place and publishes them through index[]; Node256
+// sets and clears its slots in place.
+enum { RCU_NODE4, RCU_NODE16, RCU_NODE48, RCU_NODE256 };
+
+typedef struct RcuNode RcuNode;
+typedef _Atomic(RcuNode*) RcuSlot;
+
+struct RcuNode {
+    unsigned char type;
+    unsigned short count;    // children in use (written by writers only)
+    atomic_int isEndOfFile;
+};
+
+typedef struct {
+    RcuNode hdr;
+    unsigned char keys[4];
+    RcuSlot children[4];
+} RcuNode4;
+
+typedef struct {
+    RcuNode hdr;
+    unsigned char keys[16];
+    RcuSlot children[16];
+} RcuNode16;
+
+typedef struct {
+    RcuNode hdr;
+    _Atomic unsigned char index[RCU_FANOUT];   // slot+1, 0 = absent
+    RcuSlot children[48];
+} RcuNode48;
+
+typedef struct {
+    RcuNode hdr;
+    RcuSlot children[RCU_FANOUT];
+} RcuNode256;
+
+typedef struct {
+    RcuNode *node;
+    uint64_t epoch;          // global epoch when it was unlinked
+} Retired;
+
+struct RcuTrieReader {
+    _Alignas(64) _Atomic uint64_t epoch;   // 0 = outside any read section
+    RcuTrie *trie;
+    RcuTrieReader *next;
+};
+
+struct RcuTrie {
+    RcuNode *root;           // dense, never replaced
+    _Atomic uint64_t epoch;
+    pthread_mutex_t writeLock;     // writers, reader registration
+    RcuTrieReader *readers;
+    Retired *retired;
+    size_t retiredCount, retiredCap;
+    size_t sealed;           // retired[0..sealed) carry their epoch
+};
+
+static size_t nodeSize(const RcuNode *node) {
+    switch (node->type) {
+        case RCU_NODE4:  return sizeof(RcuNode4);
+        case RCU_NODE16: return sizeof(RcuNode16);
+        case RCU_NODE48: return sizeof(RcuNode48);
+        default:         return sizeof(RcuNode256);
+    }
+}
+
+static RcuNode* allocNode(unsigned char type) {
+    size_t size;
+    switch (type) {
+        case RCU_NODE4:  size = sizeof(RcuNode4);  break;
+        case RCU_NODE16: size = sizeof(RcuNode16); break;
+        case RCU_NODE48: size = sizeof(RcuNode48); break;
+        default:         size = sizeof(RcuNode256); break;
+    }
+    RcuNode *node = (RcuNode*)calloc(1, size);
+    if (node) node->type = type;
+    return node;
+}
+
+// ---------- Readers ----------
+
+// Child reached by character c, or NULL. Node4/16 keys never change after
+// publication, so only the child links need acquire loads.
+static RcuNode* loadChild(const RcuNode *node, unsigned char c) {
+    switch (node->type) {
+        case RCU_NODE4: {
+            RcuNode4 *n = (RcuNode4*)node;
+            for (int i = 0; i < n->hdr.count; i++)
+                if (n->keys[i] == c)
+                    return atomic_load_explicit(&n->children[i], memory_order_acquire);
+            return NULL;
+        }
+        case RCU_NODE16: {
+            RcuNode16 *n = (RcuNode16*)node;
+#ifdef __SSE2__
+            __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)c),
+                                         _mm_loadu_si128((const __m128i*)n->keys));
+            unsigned mask = (unsigned)_mm_movemask_epi8(cmp) & ((1u << n->hdr.count) - 1);
+            return mask ? atomic_load_explicit(&n->children[__builtin_ctz(mask)], memory_order_acquire)
+                        : NULL;
+#else
+            for (int i = 0; i < n->hdr.count; i++)
+                if (n->keys[i] == c)
+                    return atomic_load_explicit(&n->children[i], memory_order_acquire);
+            return NULL;
+#endif
+        }
+        case RCU_NODE48: {
+            RcuNode48 *n = (RcuNode48*)node;
+            unsigned char idx = atomic_load_explicit(&n->index[c], memory_order_acquire);
+            return idx ? atomic_load_explicit(&n->children[idx - 1], memory_order_acquire) : NULL;
+        }
+        default:
+            return atomic_load_explicit(&((RcuNode256*)node)->children[c], memory_order_acquire);
+    }
+}
+
+// Enter a read section: publish the epoch we started in before touching
+// any node, so writers keep everything we might reach
+static void readBegin(RcuTrieReader *r) {
+    uint64_t e = atomic_load_explicit(&r->trie->epoch, memory_order_acquire);
+    atomic_store_explicit(&r->epoch, e, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+static void readEnd(RcuTrieReader *r) {
+    atomic_store_explicit(&r->epoch, 0, memory_order_release);
+}
+
+// Node reached by the whole of 'path', or NULL
+static RcuNode* walk(RcuTrieReader *r, const char *path) {
+    RcuNode *curr = r->trie->root;
+    for (int i = 0; curr && path[i] != '\0'; i++)
+        curr = loadChild(curr, (unsigned char)path[i]);
+    return curr;
+}
+
+int rcuTrieSearch(RcuTrieReader *r, const char *path) {
+    readBegin(r);
+    RcuNode *node = walk(r, path);
+    int found = node && atomic_load_explicit(&node->isEndOfFile, memory_order_acquire);
+    readEnd(r);
+    return found;
+}
+
+int rcuTrieStartsWith(RcuTrieReader *r, const char *prefix) {
+    readBegin(r);
+    int found = walk(r, prefix) != NULL;
+    readEnd(r);
+    return found;
+}
+
+RcuTrieReader* rcuTrieReaderJoin(RcuTrie *trie) {
+    size_t size = (sizeof(RcuTrieReader) + 63) & ~(size_t)63;
+    RcuTrieReader *r = (RcuTrieReader*)aligned_alloc(64, size);
+    if (!r) return NULL;
+    atomic_init(&r->epoch, 0);
+    r->trie = trie;
+    pthread_mutex_lock(&trie->writeLock);
+    r->next = trie->readers;
+    trie->readers = r;
+    pthread_mutex_unlock(&trie->writeLock);
+    return r;
+}
+
+void rcuTrieReaderLeave(RcuTrieReader *r) {
+    if (!r) return;
+    RcuTrie *trie = r->trie;
+    pthread_mutex_lock(&trie->writeLock);
+    for (RcuTrieReader **p = &trie->readers; *p; p = &(*p)->next) {
+        if (*p == r) {
+            *p = r->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&trie->writeLock);
+    free(r);
+}
+
+// ---------- Reclamation (writers, under writeLock) ----------
+
+static int retire(RcuTrie *t, RcuNode *node) {
+    if (t->retiredCount == t->retiredCap) {
+        size_t cap = t->retiredCap ? t->retiredCap * 2 : RCU_RECLAIM_BATCH;
+        Retired *grown = (Retired*)realloc(t->retired, cap * sizeof(Retired));
+        if (!grown) return -1;
+        t->retired = grown;
+        t->retiredCap = cap;
+    }
+    t->retired[t->retiredCount].node = node;
+    t->retired[t->retiredCount].epoch = 0;
+    t->retiredCount++;
+    return 0;
+}
+
+// Tag the nodes retired by this operation, now that they are unlinked,
+// and start a new epoch: readers that enter from here on cannot see them
+static void sealRetired(RcuTrie *t) {
+    if (t->sealed == t->retiredCount) return;
+    uint64_t e = atomic_fetch_add_explicit(&t->epoch, 1, memory_order_seq_cst);
+    for (; t->sealed < t->retiredCount; t->sealed++)
+        t->retired[t->sealed].epoch = e;
+}
+
+static size_t reclaimLocked(RcuTrie *t) {
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for (RcuTrieReader *r = t->readers; r; r = r->next) {
+        uint64_t e = atomic_load_explicit(&r->epoch, memory_order_acquire);
+        if (e && e < oldest) oldest = e;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < t->sealed; i++) {
+        if (t->retired[i].epoch < oldest)
+            free(t->retired[i].node);
+        else
+            t->retired[kept++] = t->retired[i];
+    }
+    size_t freed = t->sealed - kept;
+    memmove(t->retired + kept, t->retired + t->sealed,
+            (t->retiredCount - t->sealed) * sizeof(Retired));
+    t->retiredCount -= freed;
+    t->sealed = kept;
+    return t->retiredCount;
+}
+
+// Finish a write: seal what it retired, reclaim in batches
+static void writeEnd(RcuTrie *t) {
+    sealRetired(t);
+    if (t->retiredCount >= RCU_RECLAIM_BATCH)
+        reclaimLocked(t);
+    pthread_mutex_unlock(&t->writeLock);
+}
+
+size_t rcuTrieReclaim(RcuTrie *t) {
+    pthread_mutex_lock(&t->writeLock);
+    sealRetired(t);
+    size_t left = reclaimLocked(t);
+    pthread_mutex_unlock(&t->writeLock);
+    return left;
+}
+
+// ---------- Writers (under writeLock) ----------
+
+// Slot holding the child for character c, or NULL
+static RcuSlot* childSlot(RcuNode *node, unsigned char c) {
+    switch (node->type) {
+        case RCU_NODE4: {
+            RcuNode4 *n = (RcuNode4*)node;
+            for (int i = 0; i < n->hdr.count; i++)
+                if (n->keys[i] == c) return &n->children[i];
+            return NULL;
+        }
+        case RCU_NODE16: {
+            RcuNode16 *n = (RcuNode16*)node;
+            for (int i = 0; i < n->hdr.count; i++)
+                if (n->keys[i] == c) return &n->children[i];
+            return NULL;
+        }
+        case RCU_NODE48: {
+            RcuNode48 *n = (RcuNode48*)node;
+            unsigned char idx = atomic_load_explicit(&n->index[c], memory_order_relaxed);
+            return idx ? &n->children[idx - 1] : NULL;
+        }
+        default: {
+            RcuSlot *slot = &((RcuNode256*)node)->children[c];
+            return atomic_load_explicit(slot, memory_order_relaxed) ? slot : NULL;
+        }
+    }
+}
+
+// Children of a node in ascending key order; returns how many
+static int gatherChildren(RcuNode *node, unsigned char *keys, RcuNode **kids) {
+    int n = 0;
+    switch (node->type) {
+        case RCU_NODE4:
+        case RCU_NODE16: {
+            unsigned char *k = node->type == RCU_NODE4 ? ((RcuNode4*)node)->keys
+                                                       : ((RcuNode16*)node)->keys;
+            RcuSlot *s = node->type == RCU_NODE4 ? ((RcuNode4*)node)->children
+                                                 : ((RcuNode16*)node)->children;
+            for (; n < node->count; n++) {
+                keys[n] = k[n];
+                kids[n] = atomic_load_explicit(&s[n], memory_order_relaxed);
+            }
+            break;
+        }
+        case RCU_NODE48: {
+            RcuNode48 *b = (RcuNode48*)node;
+            for (int c = 0; c < RCU_FANOUT; c++) {
+                unsigned char idx = atomic_load_explicit(&b->index[c], memory_order_relaxed);
+                if (!idx) continue;
+                keys[n] = (unsigned char)c;
+                kids[n++] = atomic_load_explicit(&b->children[idx - 1], memory_order_relaxed);
+            }
+            break;
+        }
+        default: {
+            RcuNode256 *b = (RcuNode256*)node;
+            for (int c = 0; c < RCU_FANOUT; c++) {
+                RcuNode *kid = atomic_load_explicit(&b->children[c], memory_order_relaxed);
+                if (!kid) continue;
+                keys[n] = (unsigned char)c;
+                kids[n++] = kid;
+            }
+            break;
+        }
+    }
+    return n;
+}
+
+// Private (unpublished) node of the smallest layout that holds n children
+static RcuNode* buildNode(const unsigned char *keys, RcuNode *const *kids, int n, int isEnd) {
+    unsigned char type = n <= 4 ? RCU_NODE4 : n <= 16 ? RCU_NODE16 : n <= 48 ? RCU_NODE48 : RCU_NODE256;
+    RcuNode *node = allocNode(type);
+    if (!node) return NULL;
+    for (int i = 0; i < n; i++) {
+        switch (type) {
+            case RCU_NODE4:
+                ((RcuNode4*)node)->keys[i] = keys[i];
+                atomic_init(&((RcuNode4*)node)->children[i], kids[i]);
+                break;
+            case RCU_NODE16:
+                ((RcuNode16*)node)->keys[i] = keys[i];
+                atomic_init(&((RcuNode16*)node)->children[i], kids[i]);
+                break;
+            case RCU_NODE48:
+                atomic_init(&((RcuNode48*)node)->children[i], kids[i]);
+                atomic_init(&((RcuNode48*)node)->index[keys[i]], (unsigned char)(i + 1));
+                break;
+            default:
+                atomic_init(&((RcuNode256*)node)->children[keys[i]], kids[i]);
+                break;
+        }
+    }
+    node->count = (unsigned short)n;
+    atomic_init(&node->isEndOfFile, isEnd);
+    return node;
+}
+
+// Replace the node in *ref by a changed copy and retire the original
+static int swapIn(RcuTrie *t, RcuSlot *ref, RcuNode *old, RcuNode *copy) {
+    if (retire(t, old) != 0) {
+        free(copy);
+        return -1;
+    }
+    atomic_store_explicit(ref, copy, memory_order_release);
+    return 0;
+}
+
+// Add child under character c of 'node', held in *ref (NULL for the root)
+static int addChild(RcuTrie *t, RcuSlot *ref, RcuNode *node, unsigned char c, RcuNode *child) {
+    if (node->type == RCU_NODE256) {
+        atomic_store_explicit(&((RcuNode256*)node)->children[c], child, memory_order_release);
+        node->count++;
+        return 0;
+    }
+    if (node->type == RCU_NODE48 && node->count < 48) {
+        // Fill the slot first; the index store publishes it
+        RcuNode48 *n = (RcuNode48*)node;
+        atomic_store_explicit(&n->children[n->hdr.count], child, memory_order_relaxed);
+        atomic_store_explicit(&n->index[c], (unsigned char)(n->hdr.count + 1), memory_order_release);
+        node->count++;
+        return 0;
+    }
+    unsigned char keys[RCU_FANOUT];
+    RcuNode *kids[RCU_FANOUT];
+    int n = gatherChildren(node, keys, kids);
+    int pos = n;
+    while (pos > 0 && keys[pos - 1] > c) {
+        keys[pos] = keys[pos - 1];
+        kids[pos] = kids[pos - 1];
+        pos--;
+    }
+    keys[pos] = c;
+    kids[pos] = child;
+    RcuNode *copy = buildNode(keys, kids, n + 1,
+                              atomic_load_explicit(&node->isEndOfFile, memory_order_relaxed));
+    return copy ? swapIn(t, ref, node, copy) : -1;
+}
+
+// Remove the child under character c of 'node', held in *ref
+static int removeChild(RcuTrie *t, RcuSlot *ref, RcuNode *node, unsigned char c) {
+    if (node->type == RCU_NODE256) {
+        atomic_store_explicit(&((RcuNode256*)node)->children[c], NULL, memory_order_release);
+        node->count--;
+        return 0;
+    }
+    // Node48 slots are never reused in place: a reader that read the old
+    // index could otherwise land on another character's child
+    unsigned char keys[RCU_FANOUT];
+    RcuNode *kids[RCU_FANOUT];
+    int n = gatherChildren(node, keys, kids), out = 0;
+    for (int i = 0; i < n; i++) {
+        if (keys[i] == c) continue;
+        keys[out] = keys[i];
+        kids[out++] = kids[i];
+    }
+    RcuNode *copy = buildNode(keys, kids, out,
+                              atomic_load_explicit(&node->isEndOfFile, memory_order_relaxed));
+    return copy ? swapIn(t, ref, node, copy) : -1;
+}
+
+// Next child at or after *pos (a slot or key position), or NULL when done.
+// Keeps recursive walks to a small stack frame per level.
+static RcuNode* nextChild(RcuNode *node, int *pos) {
+    for (; *pos < RCU_FANOUT; (*pos)++) {
+        RcuNode *kid = NULL;
+        switch (node->type) {
+            case RCU_NODE4:
+                if (*pos >= node->count) return NULL;
+                kid = atomic_load_explicit(&((RcuNode4*)node)->children[*pos], memory_order_relaxed);
+                break;
+            case RCU_NODE16:
+                if (*pos >= node->count) return NULL;
+                kid = atomic_load_explicit(&((RcuNode16*)node)->children[*pos], memory_order_relaxed);
+                break;
+            case RCU_NODE48: {
+                RcuNode48 *n = (RcuNode48*)node;
+                unsigned char idx = atomic_load_explicit(&n->index[*pos], memory_order_relaxed);
+                if (idx) kid = atomic_load_explicit(&n->children[idx - 1], memory_order_relaxed);
+                break;
+            }
+            default:
+                kid = atomic_load_explicit(&((RcuNode256*)node)->children[*pos], memory_order_relaxed);
+                break;
+        }
+        if (kid) {
+            (*pos)++;
+            return kid;
+        }
+    }
+    return NULL;
+}
+
+static void freeNodes(RcuNode *node) {
+    RcuNode *kid;
+    for (int pos = 0; (kid = nextChild(node, &pos)) != NULL; )
+        freeNodes(kid);
+    free(node);
+}
+
+// Private chain of Node4s spelling 'rest'; its last node ends a file
+static RcuNode* buildChain(const char *rest) {
+    size_t len = strlen(rest);
+    RcuNode *tail = buildNode(NULL, NULL, 0, 1);
+    for (size_t i = len; tail && i > 0; i--) {
+        unsigned char c = (unsigned char)rest[i - 1];
+        RcuNode *parent = buildNode(&c, &tail, 1, 0);
+        if (!parent) freeNodes(tail);
+        tail = parent;
+    }
+    return tail;
+}
+
+int rcuTrieInsert(RcuTrie *t, const char *path) {
+    pthread_mutex_lock(&t->writeLock);
+    RcuSlot *ref = NULL;
+    RcuNode *node = t->root;
+    size_t i = 0;
+    for (; path[i] != '\0'; i++) {
+        RcuSlot *slot = childSlot(node, (unsigned char)path[i]);
+        if (!slot) break;
+        ref = slot;
+        node = atomic_load_explicit(slot, memory_order_relaxed);
+    }
+
+    int rc;
+    if (path[i] == '\0') {
+        rc = !atomic_load_explicit(&node->isEndOfFile, memory_order_relaxed);
+        if (rc) atomic_store_explicit(&node->isEndOfFile, 1, memory_order_release);
+    } else {
+        // Build the missing tail privately, then publish it with one store
+        RcuNode *chain = buildChain(path + i + 1);
+        rc = chain ? 1 : -1;
+        if (chain && addChild(t, ref, node, (unsigned char)path[i], chain) != 0) {
+            freeNodes(chain);
+            rc = -1;
+        }
+    }
+    writeEnd(t);
+    return rc;
+}
+
+int rcuTrieRemove(RcuTrie *t, const char *path) {
+    size_t len = strlen(path);
+    // nodes[d]: node after d characters; refs[d]: slot in nodes[d-1] holding it
+    RcuNode **nodes = (RcuNode**)malloc((len + 1) * sizeof(RcuNode*));
+    RcuSlot **refs = (RcuSlot**)malloc((len + 1) * sizeof(RcuSlot*));
+    if (!nodes || !refs) {
+        free(nodes);
+        free(refs);
+        return -1;
+    }
+
+    pthread_mutex_lock(&t->writeLock);
+    int rc = 0;
+    nodes[0] = t->root;
+    refs[0] = NULL;
+    size_t d = 0;
+    while (d < len) {
+        RcuSlot *slot = childSlot(nodes[d], (unsigned char)path[d]);
+        if (!slot) break;
+        refs[d + 1] = slot;
+        nodes[d + 1] = atomic_load_explicit(slot, memory_order_relaxed);
+        d++;
+    }
+    RcuNode *leaf = nodes[d];
+    if (d == len && atomic_load_explicit(&leaf->isEndOfFile, memory_order_relaxed)) {
+        rc = 1;
+        atomic_store_explicit(&leaf->isEndOfFile, 0, memory_order_release);
+        if (leaf->count == 0 && len > 0) {
+            // Unlink the longest chain that only existed for this path
+            size_t top = len;
+            while (top > 1 && nodes[top - 1]->count == 1 &&
+                   !atomic_load_explicit(&nodes[top - 1]->isEndOfFile, memory_order_relaxed))
+                top--;
+            if (removeChild(t, refs[top - 1], nodes[top - 1], (unsigned char)path[top - 1]) != 0) {
+                rc = -1;
+            } else {
+                for (size_t k = top; k <= len; k++)
+                    if (retire(t, nodes[k]) != 0) rc = -1;   // leaked, but unlinked
+            }
+        }
+    }
+    writeEnd(t);
+    free(nodes);
+    free(refs);
+    return rc;
+}
+
+// ---------- Lifetime and stats ----------
+
+RcuTrie* rcuTrieCreate(void) {
+    RcuTrie *t = (RcuTrie*)calloc(1, sizeof(RcuTrie));
+    if (!t) return NULL;
+    t->root = allocNode(RCU_NODE256);   // the root never changes layout
+    if (!t->root) {
+        free(t);
+        return NULL;
+    }
+    atomic_init(&t->epoch, 1);
+    pthread_mutex_init(&t->writeLock, NULL);
+    return t;
+}
+
+void rcuTrieFree(RcuTrie *t) {
+    if (!t) return;
+    freeNodes(t->root);
+    for (size_t i = 0; i < t->retiredCount; i++) free(t->retired[i].node);
+    free(t->retired);
+    while (t->readers) {
+        RcuTrieReader *next = t->readers->next;
+        free(t->readers);
+        t->readers = next;
+    }
+    pthread_mutex_destroy(&t->writeLock);
+    free(t);
+}
+
+static void countNodes(RcuNode *node, size_t *nodes, size_t *bytes) {
+    (*nodes)++;
+    *bytes += nodeSize(node);
+    RcuNode *kid;
+    for (int pos = 0; (kid = nextChild(node, &pos)) != NULL; )
+        countNodes(kid, nodes, bytes);
+}
+
+void rcuTrieStats(RcuTrie *t, size_t *nodeCount, size_t *bytesUsed, size_t *retired) {
+    size_t nodes = 0, bytes = 0;
+    pthread_mutex_lock(&t->writeLock);
+    countNodes(t->root, &nodes, &bytes);
+    if (retired) *retired = t->retiredCount;
+    pthread_mutex_unlock(&t->writeLock);
+    if (nodeCount) *nodeCount = nodes;
+    if (bytesUsed) *bytesUsed = bytes;
+}
@@ -0,0 +1,46 @@
+#ifndef TRIE_RCU_H
+#define TRIE_RCU_H
+
+#include <stddef.h>
+
+// Concurrent read-mostly path trie.
+// Lookups never block: readers walk the tree with acquire loads of the
+// child pointers. Writers take one mutex between them and never modify a
+// node a reader can be scanning in a way that changes its answer. Small
+// nodes are copied, changed and swapped in with a release store; dense
+// nodes set or clear single child slots in place. Nodes that are unlinked by a copy or
+// a removal are retired and freed once every reader that could still hold
+// them has left its read section (epoch-based reclamation).
+//
+// Every thread that reads must join with rcuTrieReaderJoin() and use its
+// own RcuTrieReader handle. Writers need no handle.
+
+typedef struct RcuTrie RcuTrie;
+typedef struct RcuTrieReader RcuTrieReader;
+
+RcuTrie* rcuTrieCreate(void);
+// Frees every node; no reader or writer may still be using the trie
+void rcuTrieFree(RcuTrie *trie);
+
+RcuTrieReader* rcuTrieReaderJoin(RcuTrie *trie);
+void rcuTrieReaderLeave(RcuTrieReader *reader);
+
+// Lock-free lookups; each one is its own read section
+int rcuTrieSearch(RcuTrieReader *reader, const char *path);
+int rcuTrieStartsWith(RcuTrieReader *reader, const char *prefix);
+
+// Returns 1 if the path was added, 0 if it was already present, -1 if
+// memory ran out (the trie is unchanged)
+int rcuTrieInsert(RcuTrie *trie, const char *path);
+// Returns 1 if the path was removed, 0 if it was not stored, -1 if memory
+// ran out. Nodes left without files below them are unlinked.
+int rcuTrieRemove(RcuTrie *trie, const char *path);
+
+// Free whatever retired nodes no reader can reach any more; returns how
+// many are still waiting. Writers also do this on their own in batches.
+size_t rcuTrieReclaim(RcuTrie *trie);
+
+// Reachable nodes, their bytes, and retired nodes not freed yet
+void rcuTrieStats(RcuTrie *trie, size_t *nodeCount, size_t *bytesUsed, size_t *retired);
+
+#endif